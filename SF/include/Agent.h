@@ -1,9 +1,8 @@
 #ifndef AGENT_H
 #define AGENT_H
 
-#include <map>
-
 #include "Definitions.h"
+#include "NeighborBuffer.h"
 #include "SFSimulator.h"
 #include "Vector3.h"
 #include "SimpleMatrix.h"
@@ -14,26 +13,6 @@ namespace SF
 	class Agent
 	{
 	private:
-		/// <summary> Defines the ParameterType </summary>
-		typedef enum
-		{
-			X = 1,
-			Y,
-			Z
-		}
-		ParameterType;
-
-		/// <summary> Defines the TimeType </summary>
-		typedef enum
-		{
-			PAST = 1,
-			PAST2NOW,
-			NOW,
-			NOW2FUTURE,
-			FUTURE
-		}
-		TimeType;
-
 		/// <summary> Defines an agent in the simulation </summary>
 		/// <param name="sim"> The simulator instance </param>
 		explicit Agent(SFSimulator* sim);
@@ -48,32 +27,33 @@ namespace SF
 		void computeNewVelocity();
 
 		/// <summary> Inserts an agent neighbor into the set of neighbors of this agent </summary>
-		/// <param name="agent"> A pointer to the agent to be inserted </param>
+		/// <param name="agentNo"> The storage slot of the agent to be inserted </param>
+		/// <param name="distSq"> The squared distance between this agent and the inserted one </param>
 		/// <param name="rangeSq"> The squared range around this agent </param>
-		void insertAgentNeighbor(const Agent* agent, float& rangeSq);
+		void insertAgentNeighbor(size_t agentNo, float distSq, float& rangeSq);
 
 		/// <summary> Inserts an neighbor agent identifier into the set of neighbors of this agent </summary>
-		/// <param name="agent"> A pointer to the agent ID to be inserted </param>
+		/// <param name="agentNo"> The storage slot of the agent to be inserted </param>
+		/// <param name="distSq"> The squared distance between this agent and the inserted one </param>
 		/// <param name="rangeSq"> The squared range around this agent </param>
-		void insertAgentNeighborsIndex(const Agent* agent, const float& rangeSq);
+		void insertAgentNeighborsIndex(size_t agentNo, float distSq, const float& rangeSq);
+
+		/// <summary> Inserts an agent into the cached neighbor candidates of this agent </summary>
+		/// <param name="agentNo"> The storage slot of the agent to be inserted </param>
+		/// <param name="distSq"> The squared distance between this agent and the inserted one </param>
+		/// <param name="rangeSq"> The squared range around this agent, including the neighbor skin </param>
+		void insertAgentNeighborCandidate(size_t agentNo, float distSq, float rangeSq);
 
 		/// <summary> Inserts a static obstacle neighbor into the set of neighbors of this agent </summary>
-		/// <param name="agent"> A pointer to the obstacle to be inserted </param>
+		/// <param name="obstacleNo"> The number of the obstacle segment to be inserted </param>
+		/// <param name="point1"> The first endpoint of the obstacle segment </param>
+		/// <param name="point2"> The second endpoint of the obstacle segment </param>
 		/// <param name="rangeSq"> The squared range around this agent </param>
-		void insertObstacleNeighbor(const Obstacle* obstacle, float rangeSq);
+		void insertObstacleNeighbor(size_t obstacleNo, const Vector2& point1, const Vector2& point2, float rangeSq);
 
 		/// <summary> Used for acceleration term method calling </summary>
         void update();
 
-		/// <summary> Updates speed list containing speed values corresponding each agent  </summary>
-		/// <param name="index"> Agent ID </param>
-		/// <param name="value"> New speed value </param>
-		void setSpeedList(size_t index, float value);
-
-		/// <summary> Null-initialization for speed list </summary>
-		/// <param name="id"> Agent ID </param>
-		void setNullSpeed(size_t id);
-
 		/// <summary> Finds perception of some point </summary>
 		/// <param name="from"> Agent position </param>
 		/// <param name="to"> Position of percepted point </param>
@@ -86,12 +66,6 @@ namespace SF
 		/// <returns> Normalized speed </returns>
 		float getNormalizedSpeed(float currentSpeed, float maxSpeed) const;
 		
-		/// <summary> Gets point on line nearest to selected position  </summary>
-		/// <param name="start"> Position of start of line </param>
-		/// <param name="end"> Position of end of line </param>
-		/// <param name="point"> Selected point </param>
-		/// <returns> The nearest point </returns>
-		Vector2 getNearestPoint(Vector2 *start, Vector2 *end, Vector2 *point) const;
     
 		/// <summary> Has intersection computing method </summary>
 		/// <param name="a"> Start of first line </param>
@@ -111,6 +85,12 @@ namespace SF
 
 		/// <summary> Acceleration term method </summary>
 		void getAccelerationTerm();
+
+		/// <summary> Moves this agent back to its previous position when its path crosses an obstacle neighbor </summary>
+		void stopAtObstacles();
+
+		/// <summary> Sweeps this agent from its previous position against the obstacles, sliding along the obstacles it touches instead of crossing them </summary>
+		void slideAlongObstacles();
 	
 		/// <summary> Repulsive agent force </summary>
 		void getRepulsiveAgentForce();
@@ -120,8 +100,11 @@ namespace SF
 	
 		/// <summary> Attractive force </summary>
 		void getAttractiveForce();
+
+		/// <summary> Attractive force exerted by the other members of the group of this agent </summary>
+		void getGroupAttractiveForce();
 	
-		/// <summary> Moving platform force </summary>
+		/// <summary> Moving platform force, computed for all agents by the simulator before the agent forces </summary>
 		void getMovingPlatformForce();
 
 		/// <summary> Matrix cross for moving platform </summary>
@@ -140,24 +123,6 @@ namespace SF
 		/// <returns> Degree value </returns>
 		double radiansToDegrees(float degree) const;
 
-		/// <summary> Gets current roll </summary>
-		/// <param name="pt"> Rotation projection type </param>
-		/// <param name="tt"> Rotation time type </param>
-		/// <returns> Roll </returns>
-		Vector3 getRoll(ParameterType pt, TimeType tt) const;
-
-		/// <summary> Gets Omega matrix </summary>
-		/// <param name="pt"> Rotation projection type </param>
-		/// <param name="tt"> Rotation time type </param>
-		/// <returns> Omega matrix </returns>
-		Vector3 getOmega(ParameterType pt, TimeType tt);
-
-		/// <summary> Gets DOmega matrix </summary>
-		/// <param name="pt"> Rotation projection type </param>
-		/// <param name="tt"> Rotation time type </param>
-		/// <returns> DOmega matrix </returns>
-		Vector3 getDOmega(ParameterType pt, TimeType tt);
-
 		/// <summary> Gets rotation X matrix </summary>
 		/// <param name="angle"> Rotation angle </param>
 		/// <returns> Rotation matrix </returns>
@@ -175,11 +140,18 @@ namespace SF
 
 		// TODO replace to the new parameter
 		const double TOLERANCE = 0.00001f;
+		static const size_t OBSTACLE_SLIDE_COUNT = 3;							// max count of obstacle contacts resolved by a sweep on each step
+		static const size_t OBSTACLE_NEIGHBOR_RESERVE = 16;					// count of obstacle neighbors preallocated, covering the walls and corners around an agent without growing on later steps
 	
 		bool isDeleted_;														// mark for deleting 
 		bool isForced_;															// mark preventing high speed after meeting with the obstacle 
 		size_t id_;																// unique identifier 
+		size_t slot_;															// slot in the agent storage, SF_ERROR once removed from it
+		size_t generation_;														// count of removals of agents with the same identifier
+		size_t groupNo_;														// group of agents attracted to each other, SF_ERROR when in no group
+		size_t groupIndex_;														// position among the members of the group
 		size_t maxNeighbors_;													// max count of neighbors
+		size_t maxObstacleNeighbors_;											// max count of neighbor obstacles
 		float acceleration_;													// acceleration buffer preventing high speed after meeting with the obstacle 
 		float relaxationTime_;													// time of approching the max speed  
 		float maxSpeed_;														// max speed 
@@ -204,15 +176,19 @@ namespace SF
 		Vector2 previosPosition_;												// saved previous position
 		Vector2 velocity_;														// current result vector
 		Vector2 obstacleTrajectory_;											// graphic representation of result force
-		Vector3 oldPlatformVelocity_;											// saved previous platform velocity
-		std::vector<std::pair<float, const Obstacle*> > obstacleNeighbors_;		// list of neighbor obstacles
-		std::vector<std::pair<float, const Agent*> > agentNeighbors_;			// list of neighbor agents
-		std::vector<std::pair<size_t, float>> agentNeighborsIndexList_;			// list of neighbor agent identifiers
+		NeighborBuffer<size_t> obstacleNeighbors_;								// list of neighbor obstacle segments
+		NeighborBuffer<size_t> agentNeighbors_;									// list of neighbor agent slots
+		std::vector<std::pair<size_t, float>> agentNeighborsIndexList_;			// list of neighbor agent slots
+		std::vector<size_t> agentNeighborCandidates_;							// cached agents within the neighbor distance extended by the neighbor skin
 		std::vector<int> attractiveIds_;										// list of attractive agent identifiers
-		std::map<size_t, float> speedList_;										// map of agent speeds
 		SFSimulator* sim_;														// simulator instance
     
+		friend class AgentGrid;
+		friend class AgentGroups;
+		friend class AgentStorage;
+		friend class DynamicObstacles;
 		friend class KdTree;
+		friend class ObstacleDistanceField;
 		friend class SFSimulator;
 	};
 }
@@ -0,0 +1,76 @@
+#ifndef AGENT_GRID_H
+#define AGENT_GRID_H
+
+#include "AgentNeighborSearch.h"
+
+namespace SF
+{
+	/// <summary> Defines a uniform grid of agents sorted by cell, with the cell size derived from the agent neighbor distances </summary>
+	class AgentGrid : public AgentNeighborSearch
+	{
+	private:
+		/// <summary> Constructs an empty agent grid </summary>
+		/// <param name="sim"> The simulator instance </param>
+		explicit AgentGrid(SFSimulator* sim);
+
+		/// <summary> Destructor </summary>
+		~AgentGrid();
+
+		/// <summary> Sorts the agents into the grid cells with a counting sort </summary>
+		void build() override;
+
+		/// <summary> Computes the agent neighbors of the specified agent </summary>
+		/// <param name="agent"> A pointer to the agent for which agent neighbors are to be computed </param>
+		/// <param name="rangeSq"> The squared range around the agent </param>
+		void computeAgentNeighbors(Agent* agent, float& rangeSq) const override;
+
+		/// <summary> Computes the agent ID neighbors of the specified agent </summary>
+		/// <param name="agent"> A pointer to the agent for which agent ID neighbors are to be computed </param>
+		/// <param name="rangeSq"> The squared range around the agent </param>
+		void computeAgentNeighborsIndexList(Agent* agent, float& rangeSq) const override;
+
+		/// <summary> Collects the unsorted agent neighbor candidates of the specified agent </summary>
+		/// <param name="agent"> A pointer to the agent for which agent neighbor candidates are to be collected </param>
+		/// <param name="rangeSq"> The squared range around the agent </param>
+		void computeAgentNeighborCandidates(Agent* agent, float rangeSq) const override;
+
+		/// <summary> Returns the storage slots of the indexed agents in the order of the grid cells </summary>
+		/// <returns> The agent slots </returns>
+		const std::vector<size_t>& getAgentOrder() const override;
+
+		/// <summary> Computes the range of cells overlapping a square around the specified point </summary>
+		/// <param name="position"> The center of the square </param>
+		/// <param name="range"> The half side of the square </param>
+		/// <param name="minColumn"> The first overlapped column </param>
+		/// <param name="maxColumn"> The last overlapped column </param>
+		/// <param name="minRow"> The first overlapped row </param>
+		/// <param name="maxRow"> The last overlapped row </param>
+		/// <returns> False if the square does not overlap the grid </returns>
+		bool getCellRange(const Vector2& position, float range, size_t& minColumn, size_t& maxColumn, size_t& minRow, size_t& maxRow) const;
+
+		/// <summary> Computes the squared distance from the specified point to the specified cell </summary>
+		/// <param name="position"> The selected point </param>
+		/// <param name="column"> The column of the cell </param>
+		/// <param name="row"> The row of the cell </param>
+		/// <returns> The squared distance, zero if the point lies in the cell </returns>
+		float distSqToCell(const Vector2& position, size_t column, size_t row) const;
+
+		std::vector<size_t> cellStart_;		// index of the first agent of each cell, followed by the total count
+		std::vector<size_t> cellFill_;		// index of the next agent of each cell while sorting, kept to reuse its memory
+		std::vector<size_t> cellAgents_;	// agent slots sorted by cell
+		std::vector<size_t> agentCells_;	// cell of each agent slot
+		float minX_;						// the minimum x-coordinate of the grid
+		float minY_;						// the minimum y-coordinate of the grid
+		float cellSize_;					// the side of a cell
+		size_t columns_;					// count of cell columns
+		size_t rows_;						// count of cell rows
+		SFSimulator* sim_;					// simulator instance
+
+		static const size_t MAX_CELLS_PER_AGENT = 4;
+		static const size_t CELLS_PER_NEIGHBOR_DIST = 2;
+
+		friend class SFSimulator;
+	};
+}
+
+#endif
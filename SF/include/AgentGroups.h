@@ -0,0 +1,54 @@
+#ifndef AGENT_GROUPS_H
+#define AGENT_GROUPS_H
+
+#include "Definitions.h"
+
+namespace SF
+{
+	/// <summary> Defines the groups of agents attracted to each other, with the member positions packed by group once per step </summary>
+	class AgentGroups
+	{
+	private:
+		/// <summary> Constructs an empty group table </summary>
+		/// <param name="sim"> The simulator instance </param>
+		explicit AgentGroups(SFSimulator* sim);
+
+		/// <summary> Destructor </summary>
+		~AgentGroups();
+
+		/// <summary> Adds a group of the specified agents, moving them from their previous groups </summary>
+		/// <param name="agentNos"> The numbers of the agents; deleted agents and repeated numbers are ignored </param>
+		/// <returns> The number of the group </returns>
+		size_t add(const std::vector<size_t>& agentNos);
+
+		/// <summary> Moves the specified agent to the specified group, creating it when its number is the count of groups </summary>
+		/// <param name="agent"> A pointer to the agent </param>
+		/// <param name="groupNo"> The number of the group, at most the count of groups, or SF::SF_ERROR to remove the agent from its group </param>
+		void assign(Agent* agent, size_t groupNo);
+
+		/// <summary> Removes the specified agent from its group, moving the last member of the group in its place </summary>
+		/// <param name="agent"> A pointer to the agent, ignored when not in a group </param>
+		void remove(Agent* agent);
+
+		/// <summary> Removes all groups </summary>
+		void clear();
+
+		/// <summary> Packs the current positions of the members and computes the group centroids </summary>
+		void update();
+
+		/// <summary> Returns the count of groups </summary>
+		/// <returns> The count of groups </returns>
+		size_t size() const;
+
+		std::vector<std::vector<size_t>> members_;	// numbers of the member agents of each group
+		std::vector<size_t> positionOffsets_;		// offsets of the packed member positions of each group, followed by the count of packed positions
+		std::vector<Vector2> positions_;			// positions of the members packed by group in member order
+		std::vector<Vector2> centroids_;			// centroids of the packed member positions of each group
+		SFSimulator* sim_;							// simulator instance
+
+		friend class Agent;
+		friend class SFSimulator;
+	};
+}
+
+#endif
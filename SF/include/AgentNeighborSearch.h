@@ -0,0 +1,39 @@
+#ifndef AGENT_NEIGHBOR_SEARCH_H
+#define AGENT_NEIGHBOR_SEARCH_H
+
+#include "Definitions.h"
+
+namespace SF
+{
+	/// <summary> Defines the interface of the spatial indices answering agent neighbor queries </summary>
+	class AgentNeighborSearch
+	{
+	public:
+		/// <summary> Destructor </summary>
+		virtual ~AgentNeighborSearch() { }
+
+		/// <summary> Builds the index over the current agent positions </summary>
+		virtual void build() = 0;
+
+		/// <summary> Computes the agent neighbors of the specified agent </summary>
+		/// <param name="agent"> A pointer to the agent for which agent neighbors are to be computed </param>
+		/// <param name="rangeSq"> The squared range around the agent </param>
+		virtual void computeAgentNeighbors(Agent* agent, float& rangeSq) const = 0;
+
+		/// <summary> Computes the agent ID neighbors of the specified agent </summary>
+		/// <param name="agent"> A pointer to the agent for which agent ID neighbors are to be computed </param>
+		/// <param name="rangeSq"> The squared range around the agent </param>
+		virtual void computeAgentNeighborsIndexList(Agent* agent, float& rangeSq) const = 0;
+
+		/// <summary> Collects the unsorted agent neighbor candidates of the specified agent </summary>
+		/// <param name="agent"> A pointer to the agent for which agent neighbor candidates are to be collected </param>
+		/// <param name="rangeSq"> The squared range around the agent </param>
+		virtual void computeAgentNeighborCandidates(Agent* agent, float rangeSq) const = 0;
+
+		/// <summary> Returns the storage slots of the indexed agents in the spatial order of the index </summary>
+		/// <returns> The agent slots </returns>
+		virtual const std::vector<size_t>& getAgentOrder() const = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef AGENT_STORAGE_H
+#define AGENT_STORAGE_H
+
+#include "Definitions.h"
+
+namespace SF
+{
+	/// <summary> Defines the contiguous structure-of-arrays agent state used by the hot paths of the simulation, indexed by dense agent slots </summary>
+	class AgentStorage
+	{
+	private:
+		/// <summary> Constructs an empty agent storage </summary>
+		AgentStorage();
+
+		/// <summary> Destructor </summary>
+		~AgentStorage();
+
+		/// <summary> Appends the state of a new agent to the storage and assigns it the last slot </summary>
+		/// <param name="agent"> A pointer to the agent to be appended </param>
+		void add(Agent* agent);
+
+		/// <summary> Copies the state of the specified agent into its slot </summary>
+		/// <param name="agent"> A pointer to the agent to be stored; agents removed from the storage are ignored </param>
+		void store(const Agent* agent);
+
+		/// <summary> Moves the agents not marked for deleting to the front slots keeping their order, and releases the others </summary>
+		/// <returns> True if any agent has been released </returns>
+		bool compact();
+
+		/// <summary> Removes all agents from the storage </summary>
+		void clear();
+
+		/// <summary> Returns the count of agent slots in the storage </summary>
+		/// <returns> The count of agent slots </returns>
+		size_t size() const;
+
+		std::vector<Vector2> positions_;		// current positions
+		std::vector<Vector2> velocities_;		// current result vectors
+		std::vector<Vector2> prefVelocities_;	// pre-computed velocities
+		std::vector<float> radii_;				// ranges around agents defined by radius
+		std::vector<float> maxSpeeds_;			// max speeds
+		std::vector<float> neighborDists_;		// min distances for neighbors
+		std::vector<float> speeds_;				// speeds reached during the last step
+		std::vector<float> platformFactors_;	// factor platform coefficients for moving platform force
+		std::vector<Vector2> platformForces_;	// moving platform forces of the current step
+		std::vector<Vector2> candidatePositions_;	// positions at the last update of the agent neighbor candidates
+		std::vector<Agent*> agents_;			// agents owning the slots
+
+		friend class Agent;
+		friend class AgentGrid;
+		friend class KdTree;
+		friend class SFSimulator;
+	};
+}
+
+#endif
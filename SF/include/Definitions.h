@@ -14,6 +14,7 @@ static const float SF_EPSILON = 0.00001f;	// A sufficiently small positive numbe
 namespace SF
 {
 	class Agent;
+	class AgentStorage;
 	class SFSimulator;
 	class Obstacle;
 	class AgentPropertyConfig;
@@ -52,6 +53,83 @@ namespace SF
 	{
 		return a * a;
 	}
+
+	/// <summary> Sweeps a circle along the specified displacement against a line segment, keeping the earliest contact. A circle already closer than its radius makes contact at once when it moves towards the segment </summary>
+	/// <param name="from"> The starting center of the circle </param>
+	/// <param name="displacement"> The displacement of the center </param>
+	/// <param name="radius"> The radius of the circle </param>
+	/// <param name="a"> Position of start of line </param>
+	/// <param name="b"> Position of end of line </param>
+	/// <param name="time"> The fraction of the displacement at the earliest contact so far, lowered when the segment is touched before it </param>
+	/// <param name="normal"> The unit normal of the earliest contact, pointing from the segment to the circle </param>
+	/// <returns> True if the segment is touched before the earliest contact so far </returns>
+	inline bool sweepCircleLineSegment(const Vector2& from, const Vector2& displacement, float radius, const Vector2& a, const Vector2& b, float& time, Vector2& normal)
+	{
+		auto hasContact = false;
+		const auto ab = b - a;
+		const auto lengthSq = absSq(ab);
+
+		// The sides of the segment, offset by the radius
+		if (lengthSq > SF_EPSILON * SF_EPSILON)
+		{
+			const auto length = std::sqrt(lengthSq);
+			const auto distance = leftOf(a, b, from) / length;
+			const auto rate = det(ab, displacement) / length;
+			const auto isLeft = distance > 0.0f || (distance == 0.0f && rate < 0.0f);
+			const auto approach = isLeft ? -rate : rate;
+
+			if (approach > 0.0f)
+			{
+				const auto gap = std::fabs(distance) - radius;
+				const auto t = gap > 0.0f ? gap / approach : 0.0f;
+
+				if (t < time)
+				{
+					const auto r = ((from + t * displacement - a) * ab) / lengthSq;
+
+					if (r >= 0.0f && r <= 1.0f)
+					{
+						time = t;
+						normal = (isLeft ? 1.0f : -1.0f) * Vector2(-ab.y(), ab.x()) / length;
+						hasContact = true;
+					}
+				}
+			}
+		}
+
+		// The endpoints of the segment
+		const auto displacementSq = absSq(displacement);
+
+		for (auto k = 0; k < 2; ++k)
+		{
+			const auto& endpoint = k == 0 ? a : b;
+			const auto offset = from - endpoint;
+			const auto closing = offset * displacement;
+
+			if (closing >= 0.0f || displacementSq <= 0.0f)
+				continue;
+
+			const auto c = absSq(offset) - sqr(radius);
+			const auto discriminant = sqr(closing) - displacementSq * c;
+
+			if (discriminant < 0.0f)
+				continue;
+
+			const auto t = c > 0.0f ? (-closing - std::sqrt(discriminant)) / displacementSq : 0.0f;
+
+			if (t < time)
+			{
+				const auto contact = from + t * displacement - endpoint;
+				const auto contactLengthSq = absSq(contact);
+
+				time = t;
+				normal = contactLengthSq > 0.0f ? contact / std::sqrt(contactLengthSq) : -displacement / std::sqrt(displacementSq);
+				hasContact = true;
+			}
+		}
+
+		return hasContact;
+	}
 }
 
 #endif
@@ -0,0 +1,90 @@
+#ifndef DYNAMIC_OBSTACLES_H
+#define DYNAMIC_OBSTACLES_H
+
+#include "Definitions.h"
+
+namespace SF
+{
+	/// <summary> Defines the obstacles that can be added, removed, enabled and moved at runtime, kept apart from the obstacle tree and searched through the bounding boxes of the enabled ones </summary>
+	class DynamicObstacles
+	{
+	private:
+		/// <summary> Defines a dynamic obstacle polygon </summary>
+		struct DynamicObstacle
+		{
+			std::vector<Vector2> vertices;	// The vertices as added, before the translation
+			Vector2 offset;					// The translation of the vertices
+			size_t firstSegment;			// The number of the first segment in the segment table
+			size_t enabledIndex;			// The position among the enabled obstacles
+			bool isEnabled;					// Whether the obstacle takes part in the simulation
+			bool isRemoved;					// Whether the obstacle has been removed
+		};
+
+		/// <summary> Constructs an empty set of dynamic obstacles </summary>
+		/// <param name="sim"> The simulator instance </param>
+		explicit DynamicObstacles(SFSimulator* sim);
+
+		/// <summary> Destructor </summary>
+		~DynamicObstacles();
+
+		/// <summary> Adds an enabled obstacle and appends its segments to the segment table </summary>
+		/// <param name="vertices"> The vertices of the polygonal obstacle in counterclockwise order </param>
+		/// <returns> The number of the obstacle, or SF::SF_ERROR when the number of vertices is less than two </returns>
+		size_t add(const std::vector<Vector2>& vertices);
+
+		/// <summary> Removes the specified obstacle; its segments are released when the obstacles are processed </summary>
+		/// <param name="obstacleNo"> The number of the obstacle </param>
+		void remove(size_t obstacleNo);
+
+		/// <summary> Enables or disables the specified obstacle </summary>
+		/// <param name="obstacleNo"> The number of the obstacle, ignored when removed </param>
+		/// <param name="isEnabled"> True to let the obstacle take part in the simulation </param>
+		void setEnabled(size_t obstacleNo, bool isEnabled);
+
+		/// <summary> Moves the specified obstacle </summary>
+		/// <param name="obstacleNo"> The number of the obstacle, ignored when removed </param>
+		/// <param name="offset"> The translation of the vertices from their positions when added </param>
+		void setOffset(size_t obstacleNo, const Vector2& offset);
+
+		/// <summary> Appends the segments of all obstacles to the static segments of the segment table, releasing those of the removed obstacles </summary>
+		void writeSegments();
+
+		/// <summary> Writes the segments of the specified obstacle into the segment table, and its bounding box when enabled </summary>
+		/// <param name="obstacleNo"> The number of the obstacle </param>
+		void writeObstacle(size_t obstacleNo);
+
+		/// <summary> Inserts the segments of the enabled obstacles within range into the obstacle neighbors of the specified agent </summary>
+		/// <param name="agent"> A pointer to the agent for which obstacle neighbors are to be computed </param>
+		/// <param name="rangeSq"> The squared range around the agent </param>
+		void computeObstacleNeighbors(Agent* agent, float rangeSq) const;
+
+		/// <summary> Queries the visibility between two points within a specified radius with respect to the enabled obstacles, which block the view from both sides </summary>
+		/// <param name="q1"> The first point between which visibility is to be tested </param>
+		/// <param name="q2"> The second point between which visibility is to be tested </param>
+		/// <param name="radius"> The radius within which visibility is to be tested </param>
+		/// <returns> True if q1 and q2 are mutually visible within the radius; false otherwise </returns>
+		bool queryVisibility(const Vector2& q1, const Vector2& q2, float radius) const;
+
+		/// <summary> Sweeps a circle along the specified displacement against the enabled obstacles whose bounding boxes it may reach </summary>
+		/// <param name="from"> The starting center of the circle </param>
+		/// <param name="displacement"> The displacement of the center </param>
+		/// <param name="radius"> The radius of the circle </param>
+		/// <param name="time"> The fraction of the displacement at the earliest contact so far, lowered when an obstacle is touched before it </param>
+		/// <param name="normal"> The unit normal of the earliest contact, pointing from the obstacle to the circle </param>
+		/// <returns> True if an obstacle is touched before the earliest contact so far </returns>
+		bool querySweep(const Vector2& from, const Vector2& displacement, float radius, float& time, Vector2& normal) const;
+
+		std::vector<DynamicObstacle> obstacles_;	// all dynamic obstacles by number
+		std::vector<size_t> enabledNos_;			// numbers of the enabled obstacles
+		std::vector<float> minX_;					// minimum x-coordinates of the enabled obstacles
+		std::vector<float> minY_;					// minimum y-coordinates of the enabled obstacles
+		std::vector<float> maxX_;					// maximum x-coordinates of the enabled obstacles
+		std::vector<float> maxY_;					// maximum y-coordinates of the enabled obstacles
+		SFSimulator* sim_;							// simulator instance
+
+		friend class Agent;
+		friend class SFSimulator;
+	};
+}
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef FORCE_KERNELS_H
+#define FORCE_KERNELS_H
+
+#include "Definitions.h"
+#include "ScratchArena.h"
+#include "SFSimulator.h"
+
+namespace SF
+{
+	/// <summary> Defines the input of the repulsive force exerted on an agent by its agent neighbors </summary>
+	struct RepulsiveAgentInput
+	{
+		const Vector2* positions;		// The positions indexed by agent slot
+		const Vector2* velocities;		// The velocities indexed by agent slot
+		const float* speeds;			// The speeds indexed by agent slot
+		Vector2 position;				// The position of the agent
+		float timeStep;					// The time step of the simulation
+		float repulsiveAgent;			// The repulsive exponential agent coefficient of the agent
+		float repulsiveAgentFactor;		// The repulsive factor agent coefficient of the agent
+		float perception;				// The weight of the neighbors behind the agent
+	};
+
+	/// <summary> Defines the repulsive force exerted on an agent by its agent neighbors </summary>
+	struct RepulsiveAgentOutput
+	{
+		Vector2 forceSum;				// The sum of the forces
+		double pressure;				// The sum of the force lengths
+		float maxForceLength;			// The maximum force length, FLT_MIN when there are no forces
+	};
+
+	/// <summary> Defines the input of the repulsive force exerted on an agent by the closest points of its obstacle neighbors </summary>
+	struct RepulsiveObstacleInput
+	{
+		Vector2 position;				// The position of the agent
+		float radius;					// The radius of the agent
+		float repulsiveObstacle;		// The repulsive exponential obstacle coefficient of the agent
+		float repulsiveObstacleFactor;	// The repulsive factor obstacle coefficient of the agent
+	};
+
+	/// <summary> Defines the input of the moving platform forces exerted on all agents </summary>
+	struct MovingPlatformInput
+	{
+		const Vector2* positions;		// The positions indexed by agent slot
+		const Vector2* velocities;		// The velocities indexed by agent slot
+		const float* platformFactors;	// The platform factors indexed by agent slot
+		const PlatformFrame* frame;		// The platform kinematics on the current step
+		float timeStep;					// The time step of the simulation
+	};
+
+	/// <summary> Defines the contiguous obstacle segments near an agent with their closest points, drawn from a scratch arena </summary>
+	struct ObstacleSegmentBatch
+	{
+		/// <summary> Allocates the buffers for the specified count of segments, padded to a whole count of the widest vectors </summary>
+		/// <param name="arena"> The scratch arena of the calling thread </param>
+		/// <param name="count"> The count of segments </param>
+		void allocate(ScratchArena& arena, size_t count);
+
+		float* startX;							// The x-coordinates of the segment starts
+		float* startY;							// The y-coordinates of the segment starts
+		float* endX;							// The x-coordinates of the segment ends
+		float* endY;							// The y-coordinates of the segment ends
+		float* closestX;						// The x-coordinates of the points of the segments closest to the agent
+		float* closestY;						// The y-coordinates of the points of the segments closest to the agent
+		float* pointX;							// The x-coordinates of the distinct closest points exerting the force
+		float* pointY;							// The y-coordinates of the distinct closest points exerting the force
+		float* forceX;							// The x-coordinates of the forces exerted by the distinct closest points
+		float* forceY;							// The y-coordinates of the forces exerted by the distinct closest points
+		std::pair<float, size_t>* closestOrder;	// The x-coordinates of the closest points with their segments, sorted
+		size_t* closestRank;					// The positions of the segments in the closest point order
+		std::pair<float, size_t>* endpointOrder;	// The x-coordinates of the segment endpoints, sorted, with 2 * i for the start of segment i and 2 * i + 1 for its end
+		char* isSelected;						// The marks of the closest points not coinciding with preceding ones
+	};
+
+	/// <summary> Selects the closest points exerting the repulsive obstacle force. A closest point is dropped if it coincides with the closest point of a preceding segment, or if it coincides with an endpoint of a segment whose own closest point lies elsewhere </summary>
+	/// <param name="batch"> The segments and their closest points. Receives the selected points </param>
+	/// <param name="count"> The count of segments </param>
+	/// <param name="toleranceSq"> The squared distance under which two points coincide </param>
+	/// <returns> The count of selected points </returns>
+	size_t selectRepulsiveObstaclePoints(ObstacleSegmentBatch& batch, size_t count, double toleranceSq);
+
+	/// <summary> Detects the widest instruction set supported by the CPU and the operating system </summary>
+	/// <returns> The widest supported instruction set </returns>
+	SFSimulator::InstructionSet getSupportedInstructionSet();
+
+	/// <summary> Returns the repulsive agent force kernel using the specified instruction set and math mode </summary>
+	/// <param name="instructionSet"> The instruction set, which must be supported </param>
+	/// <param name="mathMode"> The math mode </param>
+	/// <returns> The kernel </returns>
+	RepulsiveAgentKernel getRepulsiveAgentKernel(SFSimulator::InstructionSet instructionSet, SFSimulator::MathMode mathMode);
+
+	/// <summary> Returns the closest point kernel using the specified instruction set </summary>
+	/// <param name="instructionSet"> The instruction set, which must be supported </param>
+	/// <returns> The kernel </returns>
+	ClosestPointKernel getClosestPointKernel(SFSimulator::InstructionSet instructionSet);
+
+	/// <summary> Returns the repulsive obstacle force kernel using the specified instruction set and math mode </summary>
+	/// <param name="instructionSet"> The instruction set, which must be supported </param>
+	/// <param name="mathMode"> The math mode </param>
+	/// <returns> The kernel </returns>
+	RepulsiveObstacleKernel getRepulsiveObstacleKernel(SFSimulator::InstructionSet instructionSet, SFSimulator::MathMode mathMode);
+
+	/// <summary> Returns the moving platform force kernel using the specified instruction set </summary>
+	/// <param name="instructionSet"> The instruction set, which must be supported </param>
+	/// <returns> The kernel </returns>
+	MovingPlatformKernel getMovingPlatformKernel(SFSimulator::InstructionSet instructionSet);
+
+	/// <summary> Computes the repulsive force exerted on an agent by its agent neighbors one neighbor at a time </summary>
+	/// <param name="input"> The agent and the state of its neighbors </param>
+	/// <param name="neighbors"> The squared distances and slots of the neighbors </param>
+	/// <param name="count"> The count of neighbors </param>
+	/// <param name="output"> The accumulated force </param>
+	void computeRepulsiveAgentForceScalar(const RepulsiveAgentInput& input, const std::pair<float, size_t>* neighbors, size_t count, RepulsiveAgentOutput& output);
+
+	/// <summary> Computes the points of line segments closest to a point one segment at a time </summary>
+	/// <param name="batch"> The segments. Receives the closest points </param>
+	/// <param name="count"> The count of segments </param>
+	/// <param name="point"> The point </param>
+	void computeClosestPointsScalar(ObstacleSegmentBatch& batch, size_t count, const Vector2& point);
+
+	/// <summary> Computes the repulsive force exerted on an agent by the selected closest points one point at a time. Each force is weighted by its share of the sum of the force lengths </summary>
+	/// <param name="input"> The agent </param>
+	/// <param name="batch"> The selected closest points. Receives the forces </param>
+	/// <param name="count"> The count of selected closest points </param>
+	/// <returns> The weighted sum of the forces </returns>
+	Vector2 computeRepulsiveObstacleForceScalar(const RepulsiveObstacleInput& input, ObstacleSegmentBatch& batch, size_t count);
+
+	/// <summary> Computes the moving platform forces exerted on a range of agents one agent at a time </summary>
+	/// <param name="input"> The state of the agents and the platform kinematics </param>
+	/// <param name="begin"> The slot of the first agent </param>
+	/// <param name="end"> The slot past the last agent </param>
+	/// <param name="forces"> The forces indexed by agent slot </param>
+	void computeMovingPlatformForcesScalar(const MovingPlatformInput& input, size_t begin, size_t end, Vector2* forces);
+}
+
+#endif
@@ -1,12 +1,14 @@
 #ifndef KD_TREE_H
 #define KD_TREE_H
 
-#include "Definitions.h"
+#include <cstdint>
+
+#include "AgentNeighborSearch.h"
 
 namespace SF
 {
 	/// <summary> Defines kd-trees for agents and static obstacles in the simulation </summary>
-	class KdTree
+	class KdTree : public AgentNeighborSearch
 	{
 	private:
 		/// <summary> Defines an agent kd-tree node </summary>
@@ -22,11 +24,27 @@ namespace SF
 			size_t right;			// The right node number
 		};
 
-		/// <summary> Defines an obstacle in kd-tree node </summary>
-		struct ObstacleTreeNode {
-			ObstacleTreeNode* left;		// The left obstacle tree node
-			const Obstacle* obstacle;	// The obstacle number
-			ObstacleTreeNode* right;	// The right obstacle tree node
+		/// <summary> Defines an obstacle tree node, stored depth-first with the splitting segment inline. A segment crossing the splitting line is kept whole on one side, so the traversals prune the subtrees by their bounding boxes rather than by the splitting line </summary>
+		struct ObstacleTreeNode
+		{
+			Vector2 point1;			// The first endpoint of the splitting segment
+			Vector2 point2;			// The second endpoint of the splitting segment
+			float lengthSq;			// The squared length of the splitting segment
+			uint32_t obstacle;		// The obstacle number of the splitting segment
+			uint32_t left;			// The left node number
+			uint32_t right;			// The right node number
+			float maxX;				// The maximum x-coordinate of the segments of the subtree
+			float maxY;				// The maximum y-coordinate of the segments of the subtree
+			float minX;				// The minimum x-coordinate of the segments of the subtree
+			float minY;				// The minimum y-coordinate of the segments of the subtree
+		};
+
+		/// <summary> Defines an agent kd-tree subtree deferred to a parallel build </summary>
+		struct AgentTreeTask
+		{
+			size_t begin;			// The beginning node number
+			size_t end;				// The ending node number
+			size_t node;			// The subtree root node number
 		};
 
 		/// <summary> Constructs a kd-tree instance </summary>
@@ -36,6 +54,9 @@ namespace SF
 		/// <summary> Destructor </summary>
 		~KdTree();
 
+		/// <summary> Builds the agent kd-tree over the current agent positions </summary>
+		void build() override;
+
 		/// <summary> Builds an agent kd-tree </summary>
 		void buildAgentTree();
 
@@ -45,27 +66,80 @@ namespace SF
 		/// <param name="node"> Selected node  </param>
 		void buildAgentTreeRecursive(size_t begin, size_t end, size_t node);
 
+		/// <summary> Builds the top levels of an agent kd-tree with parallel loops and collects the remaining subtrees </summary>
+		/// <param name="begin"> Begin node  </param>
+		/// <param name="end"> End node  </param>
+		/// <param name="node"> Selected node  </param>
+		/// <param name="cutoff"> The agent count below which a subtree is deferred </param>
+		/// <param name="subtrees"> The deferred subtrees </param>
+		/// <param name="subtreeCount"> The count of deferred subtrees </param>
+		void buildAgentTreeTopRecursive(size_t begin, size_t end, size_t node, size_t cutoff, AgentTreeTask* subtrees, size_t& subtreeCount);
+
+		/// <summary> Computes the bounding box of the agents of the specified agent tree node with a parallel reduction </summary>
+		/// <param name="node"> Selected node  </param>
+		void computeAgentTreeBoundsParallel(size_t node);
+
+		/// <summary> Stably partitions the agents of a range by a split line with parallel loops. The serial build swaps the agents in place instead, so the agents of a node end up in a different order </summary>
+		/// <param name="begin"> Begin node  </param>
+		/// <param name="end"> End node  </param>
+		/// <param name="isVertical"> True if the split line is vertical </param>
+		/// <param name="splitValue"> The coordinate of the split line </param>
+		/// <returns> The beginning of the agents lying at or beyond the split line </returns>
+		size_t partitionAgentsParallel(size_t begin, size_t end, bool isVertical, float splitValue);
+
+		/// <summary> Computes the bounding box of the agents of the specified agent tree node </summary>
+		/// <param name="node"> Selected node  </param>
+		void computeAgentTreeBounds(size_t node);
+
+		/// <summary> Updates the bounding boxes of an agent kd-tree bottom-up keeping its partition </summary>
+		/// <param name="node"> Selected node  </param>
+		void refitAgentTreeRecursive(size_t node);
+
 		/// <summary> Builds an obstacle kd-tree </summary>
 		void buildObstacleTree();
 
 		/// <summary> Builds an obstacle kd-tree </summary>
 		/// <param name="obstacles"> Obstacles set  </param>
-		/// <returns> The tree </returns>
-		ObstacleTreeNode* buildObstacleTreeRecursive(const std::vector<Obstacle*>& obstacles);
+		/// <param name="depth"> The depth of the subtree root </param>
+		/// <returns> The node number of the subtree root, or NO_OBSTACLE_NODE when the set is empty </returns>
+		uint32_t buildObstacleTreeRecursive(const std::vector<Obstacle*>& obstacles, size_t depth);
+
+		/// <summary> Collects the obstacles tried as the splitter of a large obstacle set, taken around the median of the segment midpoints along both axes </summary>
+		/// <param name="obstacles"> Obstacles set  </param>
+		/// <param name="candidates"> The numbers of the candidate obstacles in the set </param>
+		void collectObstacleSplitCandidates(const std::vector<Obstacle*>& obstacles, std::vector<size_t>& candidates) const;
 
 		/// <summary> Computes the agent neighbors of the specified agent </summary>
 		/// <param name="agent"> A pointer to the agent for which agent neighbors are to be computed </param>
 		/// <param name="rangeSq"> The squared range around the agent </param>
-		void computeAgentNeighbors(Agent* agent, float& rangeSq) const;
+		void computeAgentNeighbors(Agent* agent, float& rangeSq) const override;
 
 		/// <summary> Computes the obstacle neighbors of the specified agent </summary>
 		/// <param name="agent"> A pointer to the obstacle for which agent neighbors are to be computed </param>
 		/// <param name="rangeSq"> The squared range around the agent </param>
 		void computeObstacleNeighbors(Agent* agent, float rangeSq) const;
 
-		/// <summary> Deletes the specified obstacle tree node </summary>
-		/// <param name="agent"> A pointer to the obstacle tree node to be deleted </param>
-		void deleteObstacleTree(ObstacleTreeNode* node) const;
+		/// <summary> Tests whether a line segment widened by a radius may reach the segments of an obstacle tree node, which it cannot when it is separated from their bounding box along an axis or along the normal of the segment </summary>
+		/// <param name="node"> The obstacle tree node </param>
+		/// <param name="q1"> The first endpoint of the line segment </param>
+		/// <param name="q2"> The second endpoint of the line segment </param>
+		/// <param name="radius"> The radius widening the line segment </param>
+		/// <returns> True if the widened line segment overlaps the bounding box of the node; false otherwise </returns>
+		static bool isObstacleNodeReached(const ObstacleTreeNode& node, const Vector2& q1, const Vector2& q2, float radius);
+
+		/// <summary> Tests whether an obstacle tree node blocks the visibility between two points, which it does when they cross its segment from right to left and the segments intersect or come within the radius </summary>
+		/// <param name="node"> The obstacle tree node </param>
+		/// <param name="q1"> The first point between which visibility is to be tested </param>
+		/// <param name="q2"> The second point between which visibility is to be tested </param>
+		/// <param name="radiusSq"> The squared radius within which visibility is to be tested </param>
+		/// <returns> True if the segment of the node blocks the visibility; false otherwise </returns>
+		static bool isObstacleNodeBlocking(const ObstacleTreeNode& node, const Vector2& q1, const Vector2& q2, float radiusSq);
+
+		/// <summary> Returns the stack for traversing the obstacle tree, which is the local buffer unless the tree is too deep for it </summary>
+		/// <param name="localStack"> The local buffer of OBSTACLE_STACK_SIZE node numbers </param>
+		/// <param name="heapStack"> The buffer grown when the tree is too deep </param>
+		/// <returns> A pointer to the stack </returns>
+		uint32_t* getObstacleTreeStack(uint32_t* localStack, std::vector<uint32_t>& heapStack) const;
 
 		/// <summary> Inserts the specified agent tree node </summary>
 		/// <param name="agent"> A pointer to the agent for which agent neighbors are to be inserted </param>
@@ -78,12 +152,13 @@ namespace SF
 		/// <param name="rangeSq"> The squared range around the agent </param>
 		/// <param name="node"> The specified node </param>
 		void queryAgentNeighborsIndexListTreeRecursive(Agent* agent, float& rangeSq, size_t node) const;
-    
-		/// <summary> Inserts the specified obstacle tree node </summary>
-		/// <param name="agent"> A pointer to the agent for which obstacle neighbors are to be computed </param>
+
+		/// <summary> Inserts the agent neighbor candidates of the specified agent tree node </summary>
+		/// <param name="agent"> A pointer to the agent for which agent neighbor candidates are to be inserted </param>
 		/// <param name="rangeSq"> The squared range around the agent </param>
 		/// <param name="node"> The specified node </param>
-		void queryObstacleTreeRecursive(Agent* agent, float rangeSq, const ObstacleTreeNode* node) const;
+		void queryAgentNeighborCandidatesTreeRecursive(Agent* agent, float rangeSq, size_t node) const;
+
 
 		/// <summary> Queries the visibility between two points within a specified radius </summary>
 		/// <param name="q1"> The first point between which visibility is to be tested </param>
@@ -92,25 +167,61 @@ namespace SF
 		/// <returns> True if q1 and q2 are mutually visible within the radius; false otherwise </returns>
 		bool queryVisibility(const Vector2& q1, const Vector2& q2, float radius) const;
 
-		/// <summary> Queries the visibility between two points within a specified radius </summary>
+		/// <summary> Queries the visibility between two points within a specified radius, traversing the obstacle tree with the specified stack </summary>
 		/// <param name="q1"> The first point between which visibility is to be tested </param>
 		/// <param name="q2"> The second point between which visibility is to be tested </param>
-		/// <param name="node"> The selected node </param>
 		/// <param name="radius"> The radius within which visibility is to be tested </param>
+		/// <param name="stack"> The traversal stack returned by getObstacleTreeStack </param>
 		/// <returns> True if q1 and q2 are mutually visible within the radius; false otherwise </returns>
-		bool queryVisibilityRecursive(const Vector2& q1, const Vector2& q2, float radius, const ObstacleTreeNode* node) const;
+		bool queryVisibility(const Vector2& q1, const Vector2& q2, float radius, uint32_t* stack) const;
+
+		/// <summary> Queries the visibility between up to 64 pairs of points within their radii, traversing the obstacle tree for the pairs one after another with one stack </summary>
+		/// <param name="points1"> The first points of the pairs </param>
+		/// <param name="points2"> The second points of the pairs </param>
+		/// <param name="radii"> The radii of the pairs, or nullptr for zero radii </param>
+		/// <param name="count"> The count of pairs, at most 64 </param>
+		/// <returns> The mask with the bit of each pair, in the order of the pairs from the lowest bit, set when its points are mutually visible </returns>
+		uint64_t queryVisibilities(const Vector2* points1, const Vector2* points2, const float* radii, size_t count) const;
+
+		/// <summary> Sweeps a circle along the specified displacement against the obstacles, visiting only the nodes whose segments the swept circle may reach </summary>
+		/// <param name="from"> The starting center of the circle </param>
+		/// <param name="displacement"> The displacement of the center </param>
+		/// <param name="radius"> The radius of the circle </param>
+		/// <param name="time"> The fraction of the displacement at the earliest contact so far, lowered when an obstacle is touched before it </param>
+		/// <param name="normal"> The unit normal of the earliest contact, pointing from the obstacle to the circle </param>
+		/// <returns> True if an obstacle is touched before the earliest contact so far </returns>
+		bool querySweep(const Vector2& from, const Vector2& displacement, float radius, float& time, Vector2& normal) const;
 
 		/// <summary> Computes the agent ID neighbors of the specified agent </summary>
 		/// <param name="agent"> A pointer to the agent for which agent ID neighbors are to be computed </param>
 		/// <param name="rangeSq"> The squared range around the agent </param>
-		void computeAgentNeighborsIndexList(Agent* agent, float& rangeSq) const;
+		void computeAgentNeighborsIndexList(Agent* agent, float& rangeSq) const override;
+
+		/// <summary> Collects the unsorted agent neighbor candidates of the specified agent </summary>
+		/// <param name="agent"> A pointer to the agent for which agent neighbor candidates are to be collected </param>
+		/// <param name="rangeSq"> The squared range around the agent </param>
+		void computeAgentNeighborCandidates(Agent* agent, float rangeSq) const override;
+
+		/// <summary> Returns the storage slots of the indexed agents in the leaf order of the agent tree </summary>
+		/// <returns> The agent slots </returns>
+		const std::vector<size_t>& getAgentOrder() const override;
 
-		std::vector<Agent*> agents_;				// agent list
+		std::vector<size_t> agents_;				// agent slot list
+		size_t agentsAdded_;						// count of storage slots already taken into the list
+		std::vector<size_t> agentBuffer_;			// scratch agent slot list for parallel partitioning
 		std::vector<AgentTreeNode> agentTree_;		// agent tree list
-		ObstacleTreeNode* obstacleTree_;			// trivial obstacle node
+		bool isAgentTreeRefit_;						// mark for refitting the agent tree instead of rebuilding it
+		float maxAgentTreeOverlap_;					// children overlap ratio triggering a rebuild of a refitted node
+		size_t obstacleTreeExhaustiveSize_;			// max obstacle count of a node for trying every obstacle as the splitter
+		std::vector<ObstacleTreeNode> obstacleTree_;	// obstacle tree list in depth-first order
+		size_t obstacleTreeDepth_;					// count of levels of the obstacle tree
 		SFSimulator* sim_;							// simulator instance
 
 		static const size_t MAX_LEAF_SIZE = 10;
+		static const size_t PARALLEL_BUILD_SIZE = 4096;	// min agent count for building the agent tree in parallel
+		static const size_t OBSTACLE_SPLIT_CANDIDATES = 16;	// count of splitter candidates per axis of a large obstacle node
+		static const size_t OBSTACLE_STACK_SIZE = 128;		// node count of the local stack for traversing the obstacle tree
+		static const uint32_t NO_OBSTACLE_NODE = 0xFFFFFFFF;	// node number of a missing child
 
 		friend class Agent;
 		friend class SFSimulator;
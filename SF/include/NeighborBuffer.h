@@ -0,0 +1,108 @@
+#ifndef NEIGHBOR_BUFFER_H
+#define NEIGHBOR_BUFFER_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace SF
+{
+	/// <summary> Defines a list of neighbors sorted by squared distance and bounded by a maximum count, reusing its storage between steps </summary>
+	template <typename T>
+	class NeighborBuffer
+	{
+	public:
+		typedef std::pair<float, T> Entry;
+
+		/// <summary> Constructs an empty neighbor buffer </summary>
+		NeighborBuffer() :
+			entries_(),
+			count_(0)
+		{ }
+
+		/// <summary> Returns the first neighbor </summary>
+		/// <returns> A pointer to the nearest neighbor </returns>
+		const Entry* begin() const
+		{
+			return entries_.data();
+		}
+
+		/// <summary> Returns the end of the neighbors </summary>
+		/// <returns> A pointer past the farthest neighbor </returns>
+		const Entry* end() const
+		{
+			return entries_.data() + count_;
+		}
+
+		/// <summary> Returns the specified neighbor </summary>
+		/// <param name="i"> The position of the neighbor in distance order </param>
+		/// <returns> The squared distance and the neighbor </returns>
+		const Entry& operator[](size_t i) const
+		{
+			return entries_[i];
+		}
+
+		/// <summary> Returns the farthest neighbor </summary>
+		/// <returns> The squared distance and the neighbor </returns>
+		const Entry& back() const
+		{
+			return entries_[count_ - 1];
+		}
+
+		/// <summary> Returns the count of neighbors </summary>
+		/// <returns> The count of neighbors </returns>
+		size_t size() const
+		{
+			return count_;
+		}
+
+		/// <summary> Removes all neighbors keeping the storage </summary>
+		void clear()
+		{
+			count_ = 0;
+		}
+
+		/// <summary> Preallocates the storage for the specified count of neighbors </summary>
+		/// <param name="maxCount"> The expected maximum count of neighbors </param>
+		void reserve(size_t maxCount)
+		{
+			if (entries_.size() < maxCount)
+				entries_.resize(maxCount);
+		}
+
+		/// <summary> Inserts a neighbor after the neighbors not farther than it, dropping the farthest one when the buffer is full </summary>
+		/// <param name="distSq"> The squared distance to the neighbor </param>
+		/// <param name="neighbor"> The neighbor to be inserted </param>
+		/// <param name="maxCount"> The maximum count of neighbors </param>
+		/// <returns> False if the buffer is full and the neighbor is not nearer than the farthest one </returns>
+		bool insert(float distSq, const T& neighbor, size_t maxCount)
+		{
+			if (count_ >= maxCount)
+			{
+				if (maxCount == 0 || !(distSq < entries_[maxCount - 1].first))
+					return false;
+
+				count_ = maxCount - 1;
+			}
+
+			if (count_ == entries_.size())
+				entries_.push_back(Entry());
+
+			const auto first = entries_.begin();
+			const auto last = first + count_;
+			const auto position = std::upper_bound(first, last, distSq, [](float value, const Entry& entry) { return value < entry.first; });
+
+			std::move_backward(position, last, last + 1);
+			*position = Entry(distSq, neighbor);
+			++count_;
+
+			return true;
+		}
+
+	private:
+		std::vector<Entry> entries_;	// neighbors sorted by squared distance, followed by spare storage
+		size_t count_;					// count of neighbors
+	};
+}
+
+#endif
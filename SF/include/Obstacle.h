@@ -25,6 +25,7 @@ namespace SF
 
 		friend class Agent;
 		friend class KdTree;
+		friend class ObstacleSegments;
 		friend class SFSimulator;
 	};
 }
@@ -0,0 +1,69 @@
+#ifndef OBSTACLE_DISTANCE_FIELD_H
+#define OBSTACLE_DISTANCE_FIELD_H
+
+#include <cstdint>
+
+#include "Definitions.h"
+
+namespace SF
+{
+	/// <summary> Defines a signed distance field of the processed obstacle segments sampled on a grid over the scene bounds, exact up to a max distance. Each grid node also keeps its few nearest segments, so that the agents near it find their obstacle neighbors without querying the obstacle tree </summary>
+	class ObstacleDistanceField
+	{
+	private:
+		/// <summary> Constructs a disabled distance field </summary>
+		/// <param name="sim"> The simulator instance </param>
+		explicit ObstacleDistanceField(SFSimulator* sim);
+
+		/// <summary> Destructor </summary>
+		~ObstacleDistanceField();
+
+		/// <summary> Samples the distances to the processed obstacle segments on the grid, unless the field is disabled </summary>
+		void build();
+
+		/// <summary> Computes the obstacle neighbors of the specified agent from the nearest grid node, when the segments it keeps are all those that may lie within range </summary>
+		/// <param name="agent"> A pointer to the agent for which obstacle neighbors are to be computed </param>
+		/// <param name="rangeSq"> The squared range around the agent </param>
+		/// <returns> False if the field is disabled or more segments may lie within range, so that the obstacle tree has to be queried </returns>
+		bool computeObstacleNeighbors(Agent* agent, float rangeSq) const;
+
+		/// <summary> Interpolates the signed distance to the obstacles at the specified point </summary>
+		/// <param name="point"> The point </param>
+		/// <param name="gradient"> The gradient of the interpolated distance </param>
+		/// <returns> The distance, negative inside the obstacles, or the max distance outside the grid </returns>
+		float interpolate(const Vector2& point, Vector2& gradient) const;
+
+		/// <summary> Returns the nearest obstacle segment of the grid node nearest to the specified point </summary>
+		/// <param name="point"> The point </param>
+		/// <returns> The number of the segment, or NO_SEGMENT when all segments are farther than the max distance </returns>
+		uint32_t getNearestSegment(const Vector2& point) const;
+
+		/// <summary> Adds the specified segment to the nearest segments of the grid nodes within the max distance from it </summary>
+		/// <param name="segmentNo"> The number of the segment </param>
+		/// <param name="nodeDistances"> The distances to the nearest segments of each node, in the layout of the segment numbers </param>
+		void addSegment(uint32_t segmentNo, std::vector<float>& nodeDistances);
+
+		/// <summary> Negates the distances of the grid nodes lying inside the obstacle polygons by the parity of the segment crossings along each row </summary>
+		void signInsideNodes();
+
+		float cellSize_;						// spacing of the grid nodes, not positive when the field is disabled
+		float maxDistance_;						// distance beyond which the distances are stored as this value
+		float minX_;							// x-coordinate of the first grid node
+		float minY_;							// y-coordinate of the first grid node
+		size_t columns_;						// count of grid nodes along the x-axis
+		size_t rows_;							// count of grid nodes along the y-axis
+		std::vector<float> distances_;			// signed distances to the nearest segment of each node, negative inside the obstacles
+		std::vector<float> boundDistances_;		// distances to the nearest segment of each node that is not kept by it
+		std::vector<uint32_t> segmentNos_;		// NODE_SEGMENTS nearest segments of each node by distance, NO_SEGMENT when fewer lie within the max distance
+		std::vector<uint32_t> twinSegmentNos_;	// reverse segment of each segment of a two-vertex obstacle
+		SFSimulator* sim_;						// simulator instance
+
+		static const uint32_t NO_SEGMENT = 0xFFFFFFFF;	// number of a missing segment
+		static const size_t NODE_SEGMENTS = 4;			// count of the nearest segments kept by each node, a two-vertex obstacle counting once
+
+		friend class Agent;
+		friend class SFSimulator;
+	};
+}
+
+#endif
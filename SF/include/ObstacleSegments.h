@@ -0,0 +1,62 @@
+#ifndef OBSTACLE_SEGMENTS_H
+#define OBSTACLE_SEGMENTS_H
+
+#include "Definitions.h"
+
+namespace SF
+{
+	/// <summary> Defines the read-only structure-of-arrays table of the obstacle segments used by the hot paths of the simulation, indexed by the number of the first vertex of each static segment and followed by the segments of the dynamic obstacles </summary>
+	class ObstacleSegments
+	{
+	private:
+		/// <summary> Constructs an empty segment table </summary>
+		ObstacleSegments();
+
+		/// <summary> Destructor </summary>
+		~ObstacleSegments();
+
+		/// <summary> Fills the table with the segments starting at the specified obstacle vertices </summary>
+		/// <param name="obstacles"> The obstacle vertices in the order they have been added, with the vertices of each polygon in a row </param>
+		void build(const std::vector<Obstacle*>& obstacles);
+
+		/// <summary> Sets the count of segments, keeping the first ones </summary>
+		/// <param name="count"> The count of segments </param>
+		void resize(size_t count);
+
+		/// <summary> Sets the specified segment </summary>
+		/// <param name="segmentNo"> The number of the segment </param>
+		/// <param name="start"> The first endpoint </param>
+		/// <param name="end"> The second endpoint </param>
+		/// <param name="polygonNo"> The number of the first segment of the polygon </param>
+		void set(size_t segmentNo, const Vector2& start, const Vector2& end, size_t polygonNo);
+
+		/// <summary> Returns the first endpoint of the specified segment </summary>
+		/// <param name="segmentNo"> The number of the segment </param>
+		/// <returns> The first endpoint </returns>
+		Vector2 getStart(size_t segmentNo) const;
+
+		/// <summary> Returns the second endpoint of the specified segment </summary>
+		/// <param name="segmentNo"> The number of the segment </param>
+		/// <returns> The second endpoint </returns>
+		Vector2 getEnd(size_t segmentNo) const;
+
+		/// <summary> Returns the count of segments in the table </summary>
+		/// <returns> The count of segments </returns>
+		size_t size() const;
+
+		std::vector<float> startX_;				// x-coordinates of the first endpoints
+		std::vector<float> startY_;				// y-coordinates of the first endpoints
+		std::vector<float> endX_;				// x-coordinates of the second endpoints
+		std::vector<float> endY_;				// y-coordinates of the second endpoints
+		std::vector<size_t> polygonNos_;		// numbers of the first vertices of the polygons the segments belong to
+		size_t staticCount_;					// count of the segments of the static obstacles
+
+		friend class Agent;
+		friend class DynamicObstacles;
+		friend class KdTree;
+		friend class ObstacleDistanceField;
+		friend class SFSimulator;
+	};
+}
+
+#endif
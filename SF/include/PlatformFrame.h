@@ -0,0 +1,28 @@
+#ifndef PLATFORM_FRAME_H
+#define PLATFORM_FRAME_H
+
+#include "Vector3.h"
+
+namespace SF
+{
+	/// <summary> Defines the roll of a moving platform about one axis on the current step </summary>
+	struct PlatformRoll
+	{
+		bool isRolling;					// Whether the platform rolls about the axis
+		Vector3 omega;					// The angular velocity of the roll
+		Vector3 dOmega;					// The angular acceleration of the roll
+		float omegaCosX;				// The cosine of the x-coordinate of the angular velocity
+		float omegaCosY;				// The cosine of the y-coordinate of the angular velocity
+	};
+
+	/// <summary> Defines the kinematics of a moving platform shared by all agents on the current step </summary>
+	struct PlatformFrame
+	{
+		bool isActive;					// Whether the rotation history is complete, so that the moving platform force applies
+		PlatformRoll rollX;				// The roll about the x-axis
+		PlatformRoll rollY;				// The roll about the y-axis
+		float heaveFactor;				// The factor of the agent velocities due to the change of the vertical platform acceleration
+	};
+}
+
+#endif
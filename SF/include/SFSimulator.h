@@ -1,12 +1,15 @@
 #ifndef SF_SIMULATOR_H
 #define SF_SIMULATOR_H
 
+#include <cstdint>
 #include <limits>
+#include <utility>
 #include <vector>
 
 #include "Vector2.h"
 #include "Vector3.h"
 #include "AgentPropertyConfig.h"
+#include "PlatformFrame.h"
 #include "RotationDegreeSet.h"
 
 namespace SF
@@ -23,16 +26,77 @@ namespace SF
 		Vector2 direction;
 	};
 
+	/// <summary> Defines a handle of an agent, which becomes invalid once the agent is removed even if its number is reused </summary>
+	struct AgentHandle
+	{
+		/// <summary> The number of the agent </summary>
+		size_t agentNo;
+
+		/// <summary> The generation of the agent number </summary>
+		size_t generation;
+	};
+
 	class Agent;
+	class AgentGrid;
+	class AgentGroups;
+	class AgentNeighborSearch;
+	class AgentStorage;
+	class DynamicObstacles;
 	class KdTree;
+	class ScratchArena;
 	class Obstacle;
+	class ObstacleDistanceField;
+	class ObstacleSegments;
 	class AgentPropertyConfig;
 	class RotationDegreeSet;
+	struct RepulsiveAgentInput;
+	struct RepulsiveAgentOutput;
+	struct RepulsiveObstacleInput;
+	struct ObstacleSegmentBatch;
+	struct MovingPlatformInput;
+
+	/// <summary> Defines a kernel computing the repulsive force exerted on an agent by its agent neighbors </summary>
+	typedef void (*RepulsiveAgentKernel)(const RepulsiveAgentInput& input, const std::pair<float, size_t>* neighbors, size_t count, RepulsiveAgentOutput& output);
+
+	/// <summary> Defines a kernel computing the points of line segments closest to a point </summary>
+	typedef void (*ClosestPointKernel)(ObstacleSegmentBatch& batch, size_t count, const Vector2& point);
+
+	/// <summary> Defines a kernel computing the repulsive force exerted on an agent by the closest points of its obstacle neighbors </summary>
+	typedef Vector2 (*RepulsiveObstacleKernel)(const RepulsiveObstacleInput& input, ObstacleSegmentBatch& batch, size_t count);
+
+	/// <summary> Defines a kernel computing the moving platform forces exerted on a range of agents </summary>
+	typedef void (*MovingPlatformKernel)(const MovingPlatformInput& input, size_t begin, size_t end, Vector2* forces);
 
 	/// <summary> The main class of the library that contains all simulation functionality </summary>
 	class SFSimulator
 	{
 	public:
+		/// <summary> Defines the spatial indices available for agent neighbor queries </summary>
+		typedef enum
+		{
+			KD_TREE = 1,
+			UNIFORM_GRID
+		}
+		NeighborSearchType;
+
+		/// <summary> Defines the instruction sets available for the force kernels </summary>
+		typedef enum
+		{
+			SCALAR = 0,
+			SSE2,
+			AVX2,
+			AVX512
+		}
+		InstructionSet;
+
+		/// <summary> Defines the math modes of the force kernels. SFSimulator::FAST approximates the exponential with a quartic polynomial and the inverse square root with the hardware estimate refined by a Newton step. Each force then stays within 1e-5 relative error of SFSimulator::PRECISE, while the weighted sums of opposing forces may lose more through cancellation </summary>
+		typedef enum
+		{
+			PRECISE = 0,
+			FAST
+		}
+		MathMode;
+
 		/// <summary> Constructs a simulator instance </summary>
 		SFSimulator();
 
@@ -82,6 +146,29 @@ namespace SF
 			float friction,
 			const Vector2& velocity = Vector2()
 		);
+
+		/// <summary> Spawns a new agent with default properties, reusing the number of a removed agent when available </summary>
+		/// <param name="position"> The two-dimensional starting position of this agent </param>
+		/// <returns> The handle of the agent, with SF::SF_ERROR as the number when the agent defaults have not been set </returns>
+		AgentHandle spawnAgent(const Vector2& position);
+
+		/// <summary> Spawns new agents with default properties, reusing the numbers of removed agents when available </summary>
+		/// <param name="positions"> The two-dimensional starting positions of the agents </param>
+		/// <returns> The handles of the agents in the order of the positions </returns>
+		std::vector<AgentHandle> addAgents(const std::vector<Vector2>& positions);
+
+		/// <summary> Removes the specified agent; it leaves the simulation on the next step, when the other agents stop being attracted to it, after which its number may be reused </summary>
+		/// <param name="handle"> The handle of the agent, ignored when no longer valid </param>
+		void removeAgent(const AgentHandle& handle);
+
+		/// <summary> Removes the specified agents; they leave the simulation on the next step, when the other agents stop being attracted to them, after which their numbers may be reused </summary>
+		/// <param name="handles"> The handles of the agents, ignored when no longer valid </param>
+		void removeAgents(const std::vector<AgentHandle>& handles);
+
+		/// <summary> Checks whether the specified handle still refers to a live agent </summary>
+		/// <param name="handle"> The handle of the agent </param>
+		/// <returns> True if the agent has been neither removed nor deleted </returns>
+		bool isAgentHandleValid(const AgentHandle& handle) const;
 				
 		/// <summary> Adds a new obstacle to the simulation </summary>
 		/// <param name="vertices"> List of the vertices of the polygonal obstacle in counterclockwise order </param>
@@ -91,6 +178,9 @@ namespace SF
 		/// <summary> Lets the simulator perform a simulation step and updates the two - dimensional position and two - dimensional velocity of each agent </summary>
 		void doStep();
 
+		/// <summary> Builds the agent neighbor index over the current agent positions, as each simulation step does before the agents query it. When deleted agents are released first, the agent neighbor lists are emptied until the next step </summary>
+		void buildAgentNeighborIndex();
+
 		/// <summary> Returns the specified agent neighbor of the specified agent </summary>
 		/// <param name="agentNo"> The number of the agent whose agent neighbor is to be retrieved </param>
 		/// <param name="neighborNo"> The number of the agent neighbor to be retrieved </param>
@@ -102,6 +192,11 @@ namespace SF
 		/// <returns> The present maximum neighbor count of the agent </returns>
 		size_t getAgentMaxNeighbors(size_t agentNo) const;
 
+		/// <summary> Returns the maximum obstacle neighbor count of a specified agent </summary>
+		/// <param name="agentNo"> The number of the agent whose maximum obstacle neighbor count is to be retrieved </param>
+		/// <returns> The present maximum obstacle neighbor count of the agent, SF::SF_ERROR when unbounded </returns>
+		size_t getAgentMaxObstacleNeighbors(size_t agentNo) const;
+
 		/// <summary> Returns the maximum speed of a specified agent </summary>
 		/// <param name="agentNo"> The number of the agent whose maximum speed is to be retrieved </param>
 		/// <returns> The present maximum speed of the agent </returns>
@@ -125,7 +220,7 @@ namespace SF
 		/// <summary> Returns the specified obstacle neighbor of the specified agent </summary>
 		/// <param name="agentNo"> The number of the agent whose obstacle neighbor is to be retrieved </param>
 		/// <param name="neighborNo"> The number of the obstacle neighbor to be retrieved </param>
-		/// <returns> The number of the first vertex of the neighboring obstacle edge </returns>
+		/// <returns> The number of the first vertex of the neighboring obstacle edge, or SF::SF_ERROR when the edge belongs to a dynamic obstacle, whose edges are not obstacle vertices </returns>
 		size_t getAgentObstacleNeighbor(size_t agentNo, size_t neighborNo) const;
 
 		/// <summary> Returns the two-dimensional position of a specified agent </summary>
@@ -190,7 +285,7 @@ namespace SF
 		/// <summary> Performs a visibility query between the two specified points with respect to the obstacles </summary>
 		/// <param name="point1"> The first point of the query </param>
 		/// <param name="point2"> The second point of the query </param>
-		/// <param name="radius"> The minimal distance between the line connecting the two points and the obstacles in order for the points to be mutually visible(optional). Must be non - negative </param>
+		/// <param name="radius"> The minimal distance between the line segment connecting the two points and the obstacles in order for the points to be mutually visible(optional). Must be non - negative </param>
 		/// <returns> A boolean specifying whether the two points are mutually visible. Returns true when the obstacles have not been processed </returns>
 		bool queryVisibility(
 			const Vector2& point1, 
@@ -198,6 +293,65 @@ namespace SF
 			float radius = 0.0f
 		) const;
 
+		/// <summary> Performs the visibility queries between the specified pairs of points in parallel, with the same results as queryVisibility. The pairs are ordered along a Z-order curve of their midpoints and tested 64 at a time by a thread in turn, so that successive pairs find the nodes they visit in cache </summary>
+		/// <param name="points1"> The first points of the queries </param>
+		/// <param name="points2"> The second points of the queries, as many as the first points </param>
+		/// <param name="radii"> The radii of the queries, as many as the first points, or empty for zero radii </param>
+		/// <returns> The mask of mutually visible pairs, packed 64 pairs per word from the lowest bit, so that the pair i is visible when the bit i % 64 of the word i / 64 is set. Empty when the second points or the radii do not match the first points in count </returns>
+		std::vector<uint64_t> queryVisibilities(
+			const std::vector<Vector2>& points1,
+			const std::vector<Vector2>& points2,
+			const std::vector<float>& radii = std::vector<float>()
+		) const;
+
+		/// <summary> Sets the distance field of the obstacles, sampled on a grid over the scene bounds when the obstacles are processed. Each grid node keeps its four nearest segments, so that agents near a node with no other segment within range take their obstacle neighbors from it instead of querying the obstacle tree; agents near junctions of more segments still query the tree </summary>
+		/// <param name="cellSize"> The spacing of the grid nodes; not positive to disable the field, as by default </param>
+		/// <param name="maxDistance"> The distance up to which the field is exact, which should exceed the obstacle range timeHorizonObst * maxSpeed + radius of the agents; not positive to disable the field </param>
+		void setObstacleDistanceField(float cellSize, float maxDistance);
+
+		/// <summary> Interpolates the signed distance to the obstacles at the specified point from the distance field </summary>
+		/// <param name="point"> The point </param>
+		/// <returns> The distance, negative inside the obstacles, or the max distance of the field beyond its grid or when it is disabled </returns>
+		float getObstacleDistance(const Vector2& point) const;
+
+		/// <summary> Returns the gradient of the interpolated signed distance to the obstacles at the specified point </summary>
+		/// <param name="point"> The point </param>
+		/// <returns> The gradient, zero beyond the grid of the distance field or when it is disabled </returns>
+		Vector2 getObstacleDistanceGradient(const Vector2& point) const;
+
+		/// <summary> Returns the nearest obstacle segment of the distance field node nearest to the specified point </summary>
+		/// <param name="point"> The point </param>
+		/// <returns> The number of the first vertex of the segment, or SF::SF_ERROR when all segments are farther than the max distance of the field or when it is disabled </returns>
+		size_t getNearestObstacleSegment(const Vector2& point) const;
+
+		/// <summary> Adds an enabled dynamic obstacle, which can be removed, disabled and moved at runtime without processing the obstacles again. Dynamic obstacles are searched by their bounding boxes apart from the obstacle tree, so they suit doors, gates and barriers in the tens to hundreds </summary>
+		/// <param name="vertices"> List of the vertices of the polygonal obstacle in counterclockwise order </param>
+		/// <returns> The number of the dynamic obstacle, or SF::SF_ERROR when the number of vertices is less than two </returns>
+		size_t addDynamicObstacle(const std::vector<Vector2>& vertices);
+
+		/// <summary> Removes the specified dynamic obstacle; its segments are released when the obstacles are processed </summary>
+		/// <param name="obstacleNo"> The number of the dynamic obstacle </param>
+		void removeDynamicObstacle(size_t obstacleNo);
+
+		/// <summary> Enables or disables the specified dynamic obstacle, as when opening or closing a door </summary>
+		/// <param name="obstacleNo"> The number of the dynamic obstacle, ignored when removed </param>
+		/// <param name="isEnabled"> True to let the obstacle take part in the simulation </param>
+		void setDynamicObstacleEnabled(size_t obstacleNo, bool isEnabled);
+
+		/// <summary> Returns whether the specified dynamic obstacle takes part in the simulation </summary>
+		/// <param name="obstacleNo"> The number of the dynamic obstacle </param>
+		/// <returns> True if the obstacle is enabled and not removed </returns>
+		bool isDynamicObstacleEnabled(size_t obstacleNo) const;
+
+		/// <summary> Moves the specified dynamic obstacle by the specified displacement </summary>
+		/// <param name="obstacleNo"> The number of the dynamic obstacle, ignored when removed </param>
+		/// <param name="displacement"> The displacement of the vertices </param>
+		void translateDynamicObstacle(size_t obstacleNo, const Vector2& displacement);
+
+		/// <summary> Returns the count of dynamic obstacles added to the simulation, including the removed ones </summary>
+		/// <returns> The count of dynamic obstacles </returns>
+		size_t getNumDynamicObstacles() const;
+
 		/// <summary> Sets default property of agent</summary>
 		/// <param name="apc"> Property </param>
 		void setAgentDefaults(AgentPropertyConfig & apc);
@@ -207,6 +361,11 @@ namespace SF
 		/// <param name="maxNeighbors"> The replacement maximum neighbor count </param>
 		void setAgentMaxNeighbors(size_t agentNo, size_t maxNeighbors);
 
+		/// <summary> Sets the maximum obstacle neighbor count of a specified agent; the nearest obstacles are kept </summary>
+		/// <param name="agentNo"> The number of the agent whose maximum obstacle neighbor count is to be modified </param>
+		/// <param name="maxObstacleNeighbors"> The replacement maximum obstacle neighbor count, SF::SF_ERROR for no limit </param>
+		void setAgentMaxObstacleNeighbors(size_t agentNo, size_t maxObstacleNeighbors);
+
 		/// <summary> Sets the maximum speed of a specified agent </summary>
 		/// <param name="agentNo"> The number of the agent whose maximum speed is to be modified </param>
 		/// <param name="maxSpeed"> The replacement maximum speed. Must be non - negative </param>
@@ -242,6 +401,62 @@ namespace SF
 		/// <param name="velocity"> The replacement two-dimensional linear velocity </param>
 		void setAgentVelocity(size_t agentNo, const Vector2& velocity);
 
+		/// <summary> Sets the spatial index used for agent neighbor queries </summary>
+		/// <param name="type"> The neighbor search type, SFSimulator::KD_TREE by default </param>
+		void setNeighborSearchType(NeighborSearchType type);
+
+		/// <summary> Returns the spatial index used for agent neighbor queries </summary>
+		/// <returns> The neighbor search type </returns>
+		NeighborSearchType getNeighborSearchType() const;
+
+		/// <summary> Sets the instruction set used by the force kernels. The widest one supported by the CPU is used by default </summary>
+		/// <param name="instructionSet"> The instruction set, narrowed to the widest supported one. SFSimulator::SCALAR reproduces the results of the per-neighbor computation exactly, and the others stay within 1e-6 relative error of it on each agent in the precise math mode </param>
+		void setInstructionSet(InstructionSet instructionSet);
+
+		/// <summary> Returns the instruction set used by the force kernels </summary>
+		/// <returns> The instruction set </returns>
+		InstructionSet getInstructionSet() const;
+
+		/// <summary> Sets the math mode used by the repulsive force kernels, SFSimulator::PRECISE by default </summary>
+		/// <param name="mathMode"> The math mode </param>
+		void setMathMode(MathMode mathMode);
+
+		/// <summary> Returns the math mode used by the repulsive force kernels </summary>
+		/// <returns> The math mode </returns>
+		MathMode getMathMode() const;
+
+		/// <summary> Sets the skin of the cached agent neighbor candidates. The candidates within the neighbor distance extended by the skin, and the spatial index, are only updated once an agent has moved farther than half of the skin </summary>
+		/// <param name="skin"> The neighbor skin, zero to query the neighbors on each step. Must be non - negative </param>
+		void setNeighborSkin(float skin);
+
+		/// <summary> Returns the skin of the cached agent neighbor candidates </summary>
+		/// <returns> The neighbor skin, zero when the neighbors are queried on each step </returns>
+		float getNeighborSkin() const;
+
+		/// <summary> Returns the count of heap allocations made for the temporary buffers of the simulation steps. It stops growing once the scratch arenas fit the scene, so that steady-state steps do not allocate </summary>
+		/// <returns> The count of heap allocations </returns>
+		size_t getScratchAllocationCount() const;
+
+		/// <summary> Sets whether the agent kd-tree is refitted instead of rebuilt on each step </summary>
+		/// <param name="refit"> True to keep the partition of the previous step and update only the bounding boxes </param>
+		void setAgentTreeRefit(bool refit);
+
+		/// <summary> Sets the overlap that triggers the rebuild of a refitted agent kd-tree node </summary>
+		/// <param name="maxOverlap"> The maximal ratio of the area shared by the bounding boxes of the node children to the area of the node bounding box. Must be non - negative </param>
+		void setAgentTreeMaxOverlap(float maxOverlap);
+
+		/// <summary> Sets the obstacle count up to which a node of the obstacle tree tries every obstacle as its splitter. Larger nodes try only the obstacles around the median of the segment midpoints, so that processing the obstacles takes O(n log n) time on balanced floor plans </summary>
+		/// <param name="size"> The obstacle count, 128 by default; SF::SF_ERROR keeps the exhaustive search for all nodes </param>
+		void setObstacleTreeExhaustiveSize(size_t size);
+
+		/// <summary> Sets whether agents are swept against the obstacles on each step. A swept agent stops at the first obstacle it touches, within its obstacle radius, and slides along it for the rest of the step, using the obstacle tree rather than its obstacle neighbors; otherwise an agent whose path crosses an obstacle neighbor goes back to its previous position. Sweeping keeps agents out of walls at larger time steps </summary>
+		/// <param name="sweep"> True to sweep the agents, false by default </param>
+		void setObstacleSweep(bool sweep);
+
+		/// <summary> Returns whether agents are swept against the obstacles on each step </summary>
+		/// <returns> True if the agents are swept </returns>
+		bool getObstacleSweep() const;
+
 		/// <summary> Sets the time step of the simulation</summary>
 		/// <param name="timeStep"> The time step of the simulation. Must be positive </param>
 		void setTimeStep(float timeStep);
@@ -288,6 +503,56 @@ namespace SF
 		/// <param name="attractiveIds"> The list of attractive agent ID</param>
 		void deleteAttractiveIdList(int id, const std::vector<int> &attractiveIds);
 
+		/// <summary> Returns the list of attractive agents of specified agent </summary>
+		/// <param name="id"> The number of the agent </param>
+		/// <returns> The list of attractive agent ID </returns>
+		const std::vector<int>& getAttractiveIdList(int id) const;
+
+		/// <summary> Adds a group of agents attracted to each other with the attractive force, moving the agents from their previous groups </summary>
+		/// <param name="agentNos"> The numbers of the agents; deleted agents and repeated numbers are ignored </param>
+		/// <returns> The number of the group </returns>
+		size_t addAgentGroup(const std::vector<size_t>& agentNos);
+
+		/// <summary> Moves the specified agent to the specified group in constant time </summary>
+		/// <param name="agentNo"> The number of the agent, ignored when deleted or out of range </param>
+		/// <param name="groupNo"> The number of the group, getNumAgentGroups() to create a new group, or SF::SF_ERROR to remove the agent from its group. Larger numbers are ignored </param>
+		void setAgentGroup(size_t agentNo, size_t groupNo);
+
+		/// <summary> Moves each of the specified agents to the corresponding group in turn, as setAgentGroup does </summary>
+		/// <param name="agentNos"> The numbers of the agents, deleted and out of range agents are ignored </param>
+		/// <param name="groupNos"> The numbers of the groups, each at most the count of groups when it is applied, or SF::SF_ERROR to remove the agents from their groups </param>
+		void setAgentGroups(const std::vector<size_t>& agentNos, const std::vector<size_t>& groupNos);
+
+		/// <summary> Removes all agent groups </summary>
+		void clearAgentGroups();
+
+		/// <summary> Returns the group of the specified agent </summary>
+		/// <param name="agentNo"> The number of the agent </param>
+		/// <returns> The number of the group, or SF::SF_ERROR when the agent is in no group </returns>
+		size_t getAgentGroup(size_t agentNo) const;
+
+		/// <summary> Returns the count of agent groups </summary>
+		/// <returns> The count of agent groups </returns>
+		size_t getNumAgentGroups() const;
+
+		/// <summary> Returns the members of the specified agent group </summary>
+		/// <param name="groupNo"> The number of the group </param>
+		/// <returns> The numbers of the member agents </returns>
+		std::vector<size_t> getAgentGroupMembers(size_t groupNo) const;
+
+		/// <summary> Returns the centroid of the current positions of the members of the specified agent group </summary>
+		/// <param name="groupNo"> The number of the group </param>
+		/// <returns> The centroid, or the origin when the group is empty </returns>
+		Vector2 getAgentGroupCentroid(size_t groupNo) const;
+
+		/// <summary> Sets the size up to which the attractive force within a group sums the forces of the members one by one. Larger groups exert on each member a single force towards the centroid of the other members, scaled by their count </summary>
+		/// <param name="size"> The size, 8 by default </param>
+		void setAgentGroupExactSize(size_t size);
+
+		/// <summary> Returns the size up to which the attractive force within a group sums the forces of the members one by one </summary>
+		/// <returns> The size </returns>
+		size_t getAgentGroupExactSize() const;
+
 		/// <summary> Sets the velocity of platform </summary>
 		/// <param name="velocity"> New value of velocit </param>
 		void setPlatformVelocity(const Vector3 &velocity);
@@ -359,7 +624,13 @@ namespace SF
 		/// <returns> A list of indices into a specified radius agents </returns>
 		std::vector<size_t> getAgentNeighboursIndexList(size_t index, float radius);
 
-		/// <summary> Deleting the specified agent </summary>
+		/// <summary> Fills a list of indices into a specified radius agents, reusing its storage </summary>
+		/// <param name="index"> The number of the agent </param>
+		/// <param name="radius"> The specified radius </param>
+		/// <param name="result"> The list of indices into a specified radius agents </param>
+		void getAgentNeighboursIndexList(size_t index, float radius, std::vector<size_t>& result);
+
+		/// <summary> Deleting the specified agent; it leaves the simulation on the next step, while its number stays valid </summary>
 		/// <param name="index"> The number of the agent </param>
 		void deleteAgent(size_t index);
 
@@ -401,21 +672,114 @@ namespace SF
 		std::vector<size_t> deleteIDs;		// list of deleted agents
 
 	private:
+		/// <summary> Defines the ParameterType </summary>
+		typedef enum
+		{
+			X = 1,
+			Y,
+			Z
+		}
+		ParameterType;
+
+		/// <summary> Defines the TimeType </summary>
+		typedef enum
+		{
+			PAST = 1,
+			PAST2NOW,
+			NOW,
+			NOW2FUTURE,
+			FUTURE
+		}
+		TimeType;
+
+		/// <summary> Checks whether the cached agent neighbor candidates must be updated on the current step </summary>
+		/// <returns> True if an agent may have moved into the neighbor distance of another agent not among its candidates </returns>
+		bool isNeighborCandidateUpdateNeeded() const;
+
+		/// <summary> Releases the storage slots of the deleted agents, so that the simulation steps only visit live agents </summary>
+		void compactAgents();
+
+		/// <summary> Releases the temporary buffers of the previous step, adding a scratch arena for each thread that may run the step </summary>
+		void resetScratchArenas();
+
+		/// <summary> Returns the scratch arena of the calling thread </summary>
+		/// <returns> The scratch arena </returns>
+		ScratchArena& getScratchArena();
+
+		/// <summary> Computes the kinematics of the moving platform shared by all agents on the current step </summary>
+		void updatePlatformFrame();
+
+		/// <summary> Computes the moving platform forces exerted on all agents on the current step in a separate pass over the agent storage </summary>
+		void computeMovingPlatformForces();
+
+		/// <summary> Gets current roll </summary>
+		/// <param name="pt"> Rotation projection type </param>
+		/// <param name="tt"> Rotation time type </param>
+		/// <returns> Roll </returns>
+		Vector3 getRoll(ParameterType pt, TimeType tt) const;
+
+		/// <summary> Gets Omega matrix </summary>
+		/// <param name="pt"> Rotation projection type </param>
+		/// <param name="tt"> Rotation time type </param>
+		/// <returns> Omega matrix </returns>
+		Vector3 getOmega(ParameterType pt, TimeType tt) const;
+
+		/// <summary> Gets DOmega matrix </summary>
+		/// <param name="pt"> Rotation projection type </param>
+		/// <param name="tt"> Rotation time type </param>
+		/// <returns> DOmega matrix </returns>
+		Vector3 getDOmega(ParameterType pt, TimeType tt) const;
+
+		/// <summary> Creates an agent with default properties </summary>
+		/// <param name="position"> The two-dimensional starting position of this agent </param>
+		/// <returns> A pointer to the agent, not yet numbered </returns>
+		Agent* createDefaultAgent(const Vector2& position);
+
 		std::vector<Agent*> agents_;		// all agents list
+		AgentStorage* agentStorage_;		// contiguous agent state indexed by agent slot
 		Agent* defaultAgent_;				// default setting
 		float globalTime_;					// the global timer
 		KdTree* kdTree_;					// the global tree 
+		AgentGrid* agentGrid_;				// the uniform agent grid
+		AgentGroups* agentGroups_;			// the groups of agents attracted to each other
+		size_t agentGroupExactSize_;		// the size up to which the attractive force within a group is summed member by member
+		AgentNeighborSearch* agentNeighborSearch_;	// the index answering agent neighbor queries
+		NeighborSearchType neighborSearchType_;		// the type of the agent neighbor index
+		float neighborSkin_;				// the skin of the cached agent neighbor candidates
+		InstructionSet instructionSet_;		// the instruction set of the force kernels
+		MathMode mathMode_;					// the math mode of the repulsive force kernels
+		RepulsiveAgentKernel repulsiveAgentKernel_;	// the kernel computing the repulsive agent force
+		ClosestPointKernel closestPointKernel_;		// the kernel computing the obstacle points closest to an agent
+		RepulsiveObstacleKernel repulsiveObstacleKernel_;	// the kernel computing the repulsive obstacle force
+		MovingPlatformKernel movingPlatformKernel_;	// the kernel computing the moving platform forces
+		bool isNeighborCandidateStale_;		// mark for updating the agent neighbor candidates regardless of the displacements
+		bool isNeighborCandidateUpdate_;	// mark for updating the agent neighbor candidates on the current step
+		bool isCompactionPending_;			// mark for releasing the slots of the deleted agents on the next step
+		std::vector<size_t> freeAgentNumbers_;		// numbers of removed agents available for reuse
+		std::vector<size_t> removedAgentNumbers_;	// numbers of removed agents released on the next step
 		std::vector<Obstacle*> obstacles_;	// all obstacles list
+		ObstacleSegments* obstacleSegments_;	// packed segments of the processed obstacles
+		ObstacleDistanceField* obstacleDistanceField_;	// distance field of the processed obstacles
+		DynamicObstacles* dynamicObstacles_;	// obstacles added, removed and moved at runtime
+		bool isObstacleSweep_;				// mark for sweeping the agents against the obstacles instead of stopping them at crossed obstacles
+		std::vector<ScratchArena*> scratchArenas_;	// temporary buffers of the simulation steps, one arena per thread
 		float timeStep_;					// time step
 		Vector3 platformVelocity_;			// the velocity of platform
+		Vector3 previousPlatformVelocity_;	// the velocity of platform on the previous step applying the moving platform force
+		PlatformFrame platformFrame_;		// the kinematics of platform on the current step
 		RotationDegreeSet angleSet_;		// the rotation set
 		double platformRotationXY_;			// the rotaion component of XY axis
 		double platformRotationXZ_;			// the rotaion component of XZ axis
 		double platformRotationYZ_;			// the rotaion component of YZ axis
 
 		friend class Agent;
+		friend class AgentGrid;
+		friend class AgentGroups;
+		friend class AgentStorage;
+		friend class DynamicObstacles;
 		friend class KdTree;
 		friend class Obstacle;
+		friend class ObstacleDistanceField;
 	};
 }
 
@@ -0,0 +1,89 @@
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace SF
+{
+	/// <summary> Defines a bump allocator for the temporary buffers of a simulation step, owned by one thread and reused between steps </summary>
+	class ScratchArena
+	{
+	public:
+		/// <summary> Defines a scope releasing the buffers allocated within it on destruction </summary>
+		class Scope
+		{
+		public:
+			/// <summary> Opens a scope on the specified arena </summary>
+			/// <param name="arena"> The arena </param>
+			explicit Scope(ScratchArena& arena);
+
+			/// <summary> Releases the buffers allocated since the scope has been opened </summary>
+			~Scope();
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			ScratchArena& arena_;			// the arena
+			size_t block_;					// the block in use when the scope has been opened
+			size_t offset_;					// the offset in that block
+		};
+
+		/// <summary> Constructs an empty arena </summary>
+		ScratchArena();
+
+		/// <summary> Destructor </summary>
+		~ScratchArena();
+
+		ScratchArena(const ScratchArena&) = delete;
+		ScratchArena& operator=(const ScratchArena&) = delete;
+
+		/// <summary> Allocates an uninitialized buffer aligned for the widest vectors </summary>
+		/// <param name="count"> The count of elements </param>
+		/// <returns> A pointer to the buffer, valid until the enclosing scope is closed or the arena is reset </returns>
+		template <typename T>
+		T* allocate(size_t count)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "Scratch buffers are released without destruction");
+
+			return static_cast<T*>(allocateBytes(count * sizeof(T)));
+		}
+
+		/// <summary> Releases all buffers. The blocks grown during the previous step are merged, so that a step of the same size fits in a single block </summary>
+		void reset();
+
+		/// <summary> Returns the count of heap allocations made by this arena </summary>
+		/// <returns> The count of heap allocations </returns>
+		size_t getAllocationCount() const;
+
+	private:
+		/// <summary> Defines a block of memory owned by the arena </summary>
+		struct Block
+		{
+			char* memory;					// The allocated memory
+			char* data;						// The aligned beginning of the block
+			size_t size;					// The usable size in bytes
+		};
+
+		/// <summary> Allocates an aligned buffer, appending a block when the remaining ones are too small </summary>
+		/// <param name="size"> The size in bytes </param>
+		/// <returns> A pointer to the buffer </returns>
+		void* allocateBytes(size_t size);
+
+		/// <summary> Appends a block of at least the specified size </summary>
+		/// <param name="size"> The size in bytes </param>
+		void appendBlock(size_t size);
+
+		/// <summary> Frees all blocks </summary>
+		void freeBlocks();
+
+		std::vector<Block> blocks_;			// blocks in allocation order
+		size_t block_;						// block in use
+		size_t offset_;						// offset of the free memory in the block in use
+		size_t allocationCount_;			// count of heap allocations
+	};
+}
+
+#endif
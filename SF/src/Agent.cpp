@@ -1,7 +1,13 @@
 #include <algorithm>
 
 #include "../include/Agent.h"
-#include "../include/Obstacle.h"
+#include "../include/AgentGroups.h"
+#include "../include/AgentNeighborSearch.h"
+#include "../include/AgentStorage.h"
+#include "../include/DynamicObstacles.h"
+#include "../include/ForceKernels.h"
+#include "../include/ObstacleDistanceField.h"
+#include "../include/ObstacleSegments.h"
 #include "../include/KdTree.h"
 
 namespace SF
@@ -12,7 +18,12 @@ namespace SF
 		isDeleted_(false),					// mark for deleting 
 		isForced_(false),					// mark preventing high speed after meeting with the obstacle 
 		id_(0),								// unique identifier 
+		slot_(SF_ERROR),					// slot in the agent storage, SF_ERROR once removed from it
+		generation_(0),						// count of removals of agents with the same identifier
+		groupNo_(SF_ERROR),					// group of agents attracted to each other, SF_ERROR when in no group
+		groupIndex_(0),						// position among the members of the group
 		maxNeighbors_(0),					// max count of neighbors
+		maxObstacleNeighbors_(SF_ERROR),	// max count of neighbor obstacles
 		acceleration_(0),					// acceleration buffer preventing high speed after meeting with the obstacle 
 		relaxationTime_(0),					// time of approching the max speed  
 		maxSpeed_(0.0f),					// max speed 
@@ -37,16 +48,13 @@ namespace SF
 		previosPosition_(INT_MIN, INT_MIN),	// saved previous position
 		velocity_(),						// current result vector
 		obstacleTrajectory_(),				// graphic representation of result force
-		oldPlatformVelocity_(),				// saved previous platform velocity
 		obstacleNeighbors_(),				// list of neighbor obstacles
 		agentNeighbors_(),					// list of neighbor agents
 		agentNeighborsIndexList_(),			// list of neighbor agent identifiers
+		agentNeighborCandidates_(),			// cached agents within the neighbor distance extended by the neighbor skin
 		attractiveIds_(),					// list of attractive agent identifiers
-		speedList_(),						// map of agent speeds
 		sim_(sim)							// simulator instance
-	{ 
-		setNullSpeed(id_);
-	}
+	{ }
 
 	/// <summary> Destructor </summary>
 	Agent::~Agent()	{ }
@@ -56,35 +64,47 @@ namespace SF
 	{
 		// obstacle section
 		obstacleNeighbors_.clear();
+		obstacleNeighbors_.reserve(std::min(maxObstacleNeighbors_, OBSTACLE_NEIGHBOR_RESERVE));
 		auto rangeSq = sqr(timeHorizonObst_ * maxSpeed_ + radius_);
-		sim_->kdTree_->computeObstacleNeighbors(this, rangeSq);
+
+		if (!sim_->obstacleDistanceField_->computeObstacleNeighbors(this, rangeSq))
+			sim_->kdTree_->computeObstacleNeighbors(this, rangeSq);
+
+		sim_->dynamicObstacles_->computeObstacleNeighbors(this, rangeSq);
 
 		// agent section
 		agentNeighbors_.clear();
+		agentNeighbors_.reserve(maxNeighbors_);
 		if (maxNeighbors_ > 0) 
 		{
 			rangeSq = sqr(neighborDist_);
-			sim_->kdTree_->computeAgentNeighbors(this, rangeSq);
-		}
-	}
 
-	/// <summary> Updates speed list containing speed values corresponding each agent  </summary>
-	/// <param name="index"> Agent ID </param>
-	/// <param name="value"> New speed value </param>
-	void Agent::setSpeedList(size_t index, float value)
-	{
-		if (speedList_.count(index) < 1)
-			speedList_.insert(std::make_pair(index, value));
-		else
-			speedList_[index] = value;
-	}
+			if (sim_->neighborSkin_ <= 0.0f || sim_->isNeighborCandidateUpdate_)
+				sim_->agentNeighborSearch_->computeAgentNeighbors(this, rangeSq);
 
-	/// <summary> Null-initialization for speed list </summary>
-	/// <param name="id"> Agent ID </param>
-	void Agent::setNullSpeed(size_t id)
-	{
-		if (speedList_.count(id) < 1)
-			setSpeedList(id, 0.0f);
+			if (sim_->neighborSkin_ > 0.0f)
+			{
+				if (sim_->isNeighborCandidateUpdate_)
+				{
+					// Until the candidates are updated, no agent moves by more than the skin relative to another one, 
+					// so the current nearest neighbors stay within their distance plus the skin and no farther agent can replace them
+					auto candidateRange = neighborDist_;
+
+					if (agentNeighbors_.size() == maxNeighbors_)
+						candidateRange = std::min(candidateRange, std::sqrt(agentNeighbors_.back().first) + sim_->neighborSkin_);
+
+					agentNeighborCandidates_.clear();
+					sim_->agentNeighborSearch_->computeAgentNeighborCandidates(this, sqr(candidateRange + sim_->neighborSkin_));
+				}
+				else
+				{
+					const auto& positions = sim_->agentStorage_->positions_;
+
+					for (auto agentNo : agentNeighborCandidates_)
+						insertAgentNeighbor(agentNo, absSq(position_ - positions[agentNo]), rangeSq);
+				}
+			}
+		}
 	}
 
 	/// <summary> Finds perception of some point </summary>
@@ -114,7 +134,7 @@ namespace SF
 	/// <summary> Acceleration term method </summary>
 	void Agent::getAccelerationTerm()
 	{
-		setNullSpeed(id_);
+		auto& speed = sim_->agentStorage_->speeds_[slot_];
 
 		if ((fabs(previosPosition_.x() - INT_MIN) < SF_EPSILON) && (fabs(previosPosition_.y() - INT_MIN) < SF_EPSILON))
 			previosPosition_ = position_;
@@ -124,12 +144,11 @@ namespace SF
 		if (fabs(prefVelocity_.x()) < TOLERANCE && fabs(prefVelocity_.y()) < TOLERANCE)
 		{
 			acceleration_ = 0.0f;
-			setSpeedList(id_, 0.0f);
+			speed = 0.0f;
 		}
 
-		auto speed = speedList_[id_];
-		auto mult = getNormalizedSpeed(speedList_[id_], maxSpeed_);
-		auto tempAcceleration = 1 / relaxationTime_ * (maxSpeed_ - speedList_[id_]) * mult;
+		auto mult = getNormalizedSpeed(speed, maxSpeed_);
+		auto tempAcceleration = 1 / relaxationTime_ * (maxSpeed_ - speed) * mult;
 
 		if (!isForced_)
 			acceleration_ += tempAcceleration;
@@ -137,19 +156,36 @@ namespace SF
 
 		position_ += velocity_ * sim_->timeStep_ * acceleration_;
 
+		if (sim_->isObstacleSweep_)
+			slideAlongObstacles();
+		else
+			stopAtObstacles();
+
+		speed = static_cast<float>(sqrt(pow((position_ - previosPosition_).x(), 2) + pow((position_ - previosPosition_).y(), 2))) / sim_->timeStep_;
+
+		previosPosition_ = position_;
+
+	}
+
+	/// <summary> Moves this agent back to its previous position when its path crosses an obstacle neighbor </summary>
+	void Agent::stopAtObstacles()
+	{
 		auto minLength = DBL_MAX;
 		auto p = Vector2();
 		auto hasIntersection = false;
 
+		const auto& segments = *sim_->obstacleSegments_;
+
 		for(auto on: obstacleNeighbors_)
 		{
-			auto obstacle = on.second;
+			const auto start = segments.getStart(on.second);
+			const auto end = segments.getEnd(on.second);
 
 			if (isIntersect(
 				position_,
 				previosPosition_,
-				obstacle->point_,
-				obstacle->nextObstacle->point_
+				start,
+				end
 				))
 			{
 				if (!hasIntersection)
@@ -158,8 +194,8 @@ namespace SF
 				auto intersection = getIntersection(
 					position_,
 					previosPosition_,
-					obstacle->point_,
-					obstacle->nextObstacle->point_
+					start,
+					end
 					);
 
 				auto l = getLength(intersection - previosPosition_);
@@ -196,48 +232,68 @@ namespace SF
 		}
 		else
 			isForced_ = false;
-
-		setSpeedList(id_, static_cast<float>(sqrt(pow((position_ - previosPosition_).x(), 2) + pow((position_ - previosPosition_).y(), 2))) / sim_->timeStep_);
-
-		previosPosition_ = position_;
-
 	}
 
-	/// <summary> Repulsive agent force </summary>
-	void Agent::getRepulsiveAgentForce()
+	/// <summary> Sweeps this agent from its previous position against the obstacles, sliding along the obstacles it touches instead of crossing them </summary>
+	void Agent::slideAlongObstacles()
 	{
-		double pressure = 0;
-		auto forceSum = Vector2();
-		auto maxForceLength = FLT_MIN;
+		auto from = previosPosition_;
+		auto displacement = position_ - previosPosition_;
+		auto hasContact = false;
 
-		for(auto an: agentNeighbors_)
+		// Each contact moves the agent to the obstacle and keeps the part of the remaining displacement along it
+		for (size_t i = 0; i < OBSTACLE_SLIDE_COUNT && absSq(displacement) > 0.0f; ++i)
 		{
-			setNullSpeed(an.second->id_);
-			auto pos = an.second->position_;
+			auto time = 1.0f;
+			auto normal = Vector2();
 
-			if (position_ == pos)
-				continue;
+			const auto isTreeContact = sim_->kdTree_->querySweep(from, displacement, obstacleRadius_, time, normal);
+			const auto isDynamicContact = sim_->dynamicObstacles_->querySweep(from, displacement, obstacleRadius_, time, normal);
 
-			auto velocity = an.second->velocity_;
-
-			auto y = an.second->velocity_ * speedList_[an.second->id_] * sim_->timeStep_;
-			auto d = position_ - pos;
-			auto radius = speedList_[an.second->id_] * sim_->timeStep_;
-			auto b = sqrt(sqr(getLength(d) + getLength(d - y)) - sqr(radius)) / 2;
-			auto potential = repulsiveAgent_ * exp(-b / repulsiveAgent_);
-			auto ratio = (getLength(d) + getLength(d - y)) / 2 * b;
-			auto sum = (d / getLength(d) + (d - y) / getLength(d - y));
-			auto force = potential * ratio * sum * getPerception(&position_, &pos) * repulsiveAgentFactor_;
+			if (!isTreeContact && !isDynamicContact)
+			{
+				from += displacement;
+				displacement = Vector2();
+				break;
+			}
 
-			auto length = getLength(force);
-			pressure += length;
+			hasContact = true;
+			from += displacement * time;
+			displacement *= 1.0f - time;
 
-			if (maxForceLength < length)
-				maxForceLength = length;
+			const auto approach = displacement * normal;
 
-			forceSum += force;
+			if (approach < 0.0f)
+				displacement -= normal * approach;
 		}
 
+		// The acceleration is only reset when the obstacles stop this agent entirely
+		isForced_ = hasContact && absSq(from - previosPosition_) <= sqr(SF_EPSILON);
+		position_ = from;
+	}
+
+	/// <summary> Repulsive agent force </summary>
+	void Agent::getRepulsiveAgentForce()
+	{
+		const auto& storage = *sim_->agentStorage_;
+
+		RepulsiveAgentInput input;
+		input.positions = storage.positions_.data();
+		input.velocities = storage.velocities_.data();
+		input.speeds = storage.speeds_.data();
+		input.position = position_;
+		input.timeStep = sim_->timeStep_;
+		input.repulsiveAgent = repulsiveAgent_;
+		input.repulsiveAgentFactor = repulsiveAgentFactor_;
+		input.perception = perception_;
+
+		RepulsiveAgentOutput output;
+		sim_->repulsiveAgentKernel_(input, agentNeighbors_.begin(), agentNeighbors_.size(), output);
+
+		const auto pressure = output.pressure;
+		const auto maxForceLength = output.maxForceLength;
+		auto forceSum = output.forceSum;
+
 		auto forceSumLength = getLength(forceSum);
 
 		if (forceSumLength > maxForceLength)
@@ -255,108 +311,45 @@ namespace SF
 	/// <summary> Repulsive obstacle force </summary>
 	void Agent::getRepulsiveObstacleForce()
 	{
-		auto forceSum = Vector2();
-		auto maxForceLength = FLT_MIN;
-		auto minDistanceToObstacle = FLT_MAX;
+		auto& arena = sim_->getScratchArena();
+		ScratchArena::Scope scope(arena);
 
-		std::vector<Vector2> nearestObstaclePointList;
-		nearestObstaclePointList.clear();
+		const auto count = obstacleNeighbors_.size();
+		ObstacleSegmentBatch batch;
+		batch.allocate(arena, count);
 
-		Vector2 sum;
-		
-		std::vector<Vector2> forces;
-		forces.clear();
+		const auto& segments = *sim_->obstacleSegments_;
 
-		for(auto on: obstacleNeighbors_)
+		for (size_t i = 0; i < count; ++i)
 		{
-			setNullSpeed(id_);
+			const auto segmentNo = obstacleNeighbors_[i].second;
 
-			auto obstacle = on.second;
-			auto start = obstacle->point_;
-			auto end = obstacle->nextObstacle->point_;
-			auto closestPoint = getNearestPoint(&start, &end, &position_);
-
-			auto hasSuchClosestPoint = false;
-
-			for(auto nop: nearestObstaclePointList)
-			{
-				auto l = nop - closestPoint;
-				if (fabsf(l.GetLengthSquared()) < TOLERANCE)
-				{
-					hasSuchClosestPoint = true;
-					break;
-				}
-			}
-
-			if (hasSuchClosestPoint)
-				continue;
-
-			nearestObstaclePointList.push_back(closestPoint);
+			batch.startX[i] = segments.startX_[segmentNo];
+			batch.startY[i] = segments.startY_[segmentNo];
+			batch.endX[i] = segments.endX_[segmentNo];
+			batch.endY[i] = segments.endY_[segmentNo];
 		}
 
-		for(auto on: obstacleNeighbors_)
-		{
-			auto obstacle = on.second;
-			auto start = obstacle->point_;
-			auto end = obstacle->nextObstacle->point_;
-			auto closestPoint = getNearestPoint(&start, &end, &position_);
-
-			size_t j = 0;
-			for (size_t i = 0; i < nearestObstaclePointList.size(); i++)
-			{
-				auto nop = nearestObstaclePointList[i];
-				auto l = nop - closestPoint;
-				if (l.GetLengthSquared() > TOLERANCE)
-				{
-					if ((nop - start).GetLengthSquared() < TOLERANCE || (nop - end).GetLengthSquared() < TOLERANCE)
-					nearestObstaclePointList.erase(nearestObstaclePointList.begin() + j);
-				}
+		sim_->closestPointKernel_(batch, count, position_);
+		const auto pointCount = selectRepulsiveObstaclePoints(batch, count, TOLERANCE);
 
-				j++;
-			}
-		}
+		auto total = Vector2();
 
-		for(auto nop: nearestObstaclePointList)
+		if (pointCount > 0)
 		{
-			auto closestPoint = nop;
-
-			auto diff = position_ - closestPoint;
-			auto distanceSquared = diff.GetLengthSquared();
-			auto absoluteDistanceToObstacle = sqrt(distanceSquared);
-			auto distance = absoluteDistanceToObstacle - radius_;
-		
-			if (absoluteDistanceToObstacle < minDistanceToObstacle)
-				minDistanceToObstacle = absoluteDistanceToObstacle;
-
-			auto forceAmount = repulsiveObstacleFactor_ * exp(-distance / repulsiveObstacle_);
-			auto force = forceAmount * diff.normalized();
+			RepulsiveObstacleInput input;
+			input.position = position_;
+			input.radius = radius_;
+			input.repulsiveObstacle = repulsiveObstacle_;
+			input.repulsiveObstacleFactor = repulsiveObstacleFactor_;
 
-			forces.push_back(force);
-			forceSum += force;
-			
-			auto length = getLength(force);
-
-			if (maxForceLength < length)
-				maxForceLength = length;
+			total = sim_->repulsiveObstacleKernel_(input, batch, pointCount);
 		}
-
-		float lengthSum = 0;
-		for(auto force: forces)
-			lengthSum += getLength(force);
-		
-		std::vector<float> forceWeightList;
-		forceWeightList.clear();
-		for(auto force: forces)
-			forceWeightList.push_back(getLength(force) / lengthSum);
-		
-		auto total = Vector2();
-		for (size_t i = 0; i < forces.size(); i++)
-			total += forces[i] * forceWeightList[i];
 		
 		obstaclePressure_ = getLength(total);
 		correction += total;
 
-		if (forces.size() > 0)
+		if (pointCount > 0)
 			// TODO: coeff of smth else
 			obstacleTrajectory_ = position_ + total * 10;
 		else
@@ -368,12 +361,20 @@ namespace SF
 	{
 		if(attractiveIds_.size() > 0)
 		{
+			const auto& positions = sim_->agentStorage_->positions_;
+
 			for(auto ai: attractiveIds_)
 			{
-				if (ai == id_)
+				if (ai < 0 || static_cast<size_t>(ai) >= sim_->agents_.size() || static_cast<size_t>(ai) == id_)
+					continue;
+
+				// Deleted agents stop attracting at once, before their slots are released
+				const auto partner = sim_->agents_[ai];
+
+				if (partner->isDeleted_)
 					continue;
 
-				auto anp = sim_->agents_[ai]->position_;
+				auto anp = positions[partner->slot_];
 
 				auto pairPosition = anp;
 				auto normalizedDistance = normalize(position_ - anp);
@@ -386,168 +387,61 @@ namespace SF
 				correction += add;
 			}
 		}
+
+		if (groupNo_ != SF_ERROR)
+			getGroupAttractiveForce();
 	}
 
-	/// <summary> Moving platform force </summary>
-	void Agent::getMovingPlatformForce()
+	/// <summary> Attractive force exerted by the other members of the group of this agent </summary>
+	void Agent::getGroupAttractiveForce()
 	{
-		if (sim_->rotationFuture_ != Vector3())
+		const auto& groups = *sim_->agentGroups_;
+		const auto begin = groups.positionOffsets_[groupNo_];
+		const auto count = groups.positionOffsets_[groupNo_ + 1] - begin;
+
+		// An agent alone in its group has no other member, whatever the exact size
+		if (count <= 1)
+			return;
+
+		if (count <= sim_->agentGroupExactSize_)
 		{
-			Vector3
-				omega,
-				dOmega,
-				R = Vector3(position_.x(), position_.y(), 0),
-				V = Vector3(velocity_.x(), velocity_.y(), 0),
-				A = Vector3(),
-				fixedOmega = Vector3(),
-				fixedR = Vector3(),
-				fixedV = Vector3(),
-				fixedA = Vector3();
-
-			float
-				determinantPrefixCentralForceX,
-				determinantPrefixCentralForceY,
-				determinantCentralForceX,
-				determinantCentralForceY,
-				determinantTangentialForceX,
-				determinantTangentialForceY,
-				determinantCoriolisForceX,
-				determinantCoriolisForceY;
-
-			Vector2
-				newVX = Vector2(),
-				newVY = Vector2();
-
-			if (fabs(sim_->rotationNow_.x()) > 0.001f)
+			for (size_t i = 0; i < count; ++i)
 			{
-				auto parameterType = X;
-				omega = getOmega(parameterType, NOW);
-				dOmega = getDOmega(parameterType, NOW);
-
-				Vector3
-					prefixCentralForce,
-					centralForce,
-					tangentialForce,
-					CoriolisForce;
-
-				fixedR = Vector3(
-					R.x() * cos(omega.y()) + R.z() * sin(omega.y()),
-					R.y() * cos(omega.x()) + R.z() * sin(omega.y()),
-					R.z() * cos(omega.x()) - R.y() * sin(omega.x()) + R.z() * cos(omega.y()) + R.x() * sin(omega.y()));
-
-				fixedV = Vector3(
-					V.x() * cos(omega.y()) + V.z() * sin(omega.y()),
-					V.y() * cos(omega.x()) + V.z() * sin(omega.x()),
-					V.z() * cos(omega.x()) - V.y() * sin(omega.x()) + V.z() * cos(omega.y()) + V.x() * sin(omega.y()));
-
-				determinantPrefixCentralForceX = omega.y() * R.z() - omega.z() * R.y() - omega.x() * R.z() + omega.z() * R.x() + omega.x() * R.y() - omega.y() * R.x();
-				prefixCentralForce =
-					(determinantPrefixCentralForceX > 0) ?
-					getCross(omega, R) :
-					getCross(R, omega);
-
-				determinantCentralForceX = omega.y() * prefixCentralForce.z() - omega.z() * prefixCentralForce.y() - omega.x() * prefixCentralForce.z() + omega.z() * prefixCentralForce.x() + omega.x() * prefixCentralForce.y() - omega.y() * prefixCentralForce.x();
-				centralForce =
-					(determinantCentralForceX > 0) ?
-					getCross(omega, prefixCentralForce) :
-					getCross(prefixCentralForce, omega);
-
-				determinantTangentialForceX = dOmega.y() * R.z() - dOmega.z() * R.y() - dOmega.x() * R.z() + dOmega.z() * R.x() + dOmega.x() * R.y() - dOmega.y() * R.x();
-				tangentialForce =
-					(determinantTangentialForceX > 0) ?
-					getCross(dOmega, R) :
-					getCross(R, dOmega);
-
-				determinantCoriolisForceX = omega.y() * V.z() - omega.z() * V.y() - omega.x() * V.z() + omega.z() * V.x() + omega.x() * V.y() - omega.y() * V.x();
-				CoriolisForce =
-					(determinantCoriolisForceX > 0) ?
-					2 * getCross(omega, V) :
-					2 * getCross(V, omega);
-
-				fixedA = centralForce + tangentialForce - CoriolisForce;
-
-				A = Vector3(fixedA.x() / cos(omega.x()), fixedA.y() / cos(omega.y()), 0);
-
-				newVX = Vector2(A.x(), A.y());
-			}
+				if (i == groupIndex_)
+					continue;
 
-			if (fabs(sim_->rotationNow_.y()) > 0.001f)
-			{
-				auto parameterType = Y;
-				omega = getOmega(parameterType, NOW);
-				dOmega = getDOmega(parameterType, NOW);
-				
-				Vector3
-					prefixCentralForce,
-					centralForce,
-					tangentialForce,
-					CoriolisForce;
-
-				fixedR = Vector3(
-					R.x() * cos(omega.y()) + R.z() * sin(omega.y()),
-					R.y() * cos(omega.x()) + R.z() * sin(omega.y()),
-					R.z() * cos(omega.x()) - R.y() * sin(omega.x()) + R.z() * cos(omega.y()) - R.x() * sin(omega.y()));
-
-				fixedV = Vector3(
-					V.x() * cos(omega.y()) + V.z() * sin(omega.y()),
-					V.y() * cos(omega.x()) + V.z() * sin(omega.x()),
-					V.z() * cos(omega.x()) - V.y() * sin(omega.x()) + V.z() * cos(omega.y()) - V.x() * sin(omega.y()));
-
-				determinantPrefixCentralForceY = omega.y() * R.z() - omega.z() * R.y() - omega.x() * R.z() + omega.z() * R.x() + omega.x() * R.y() - omega.y() * R.x();
-				prefixCentralForce =
-					(determinantPrefixCentralForceY > 0) ?
-					getCross(omega, R) :
-					getCross(R, omega);
-
-				determinantCentralForceY = omega.y() * prefixCentralForce.z() - omega.z() * prefixCentralForce.y() - omega.x() * prefixCentralForce.z() + omega.z() * prefixCentralForce.x() + omega.x() * prefixCentralForce.y() - omega.y() * prefixCentralForce.x();
-				centralForce =
-					(determinantCentralForceY > 0) ?
-					getCross(omega, prefixCentralForce) :
-					getCross(prefixCentralForce, omega);
-
-				determinantTangentialForceY = dOmega.y() * R.z() - dOmega.z() * R.y() - dOmega.x() * R.z() + dOmega.z() * R.x() + dOmega.x() * R.y() - dOmega.y() * R.x();
-				tangentialForce =
-					(determinantTangentialForceY > 0) ?
-					getCross(dOmega, R) :
-					getCross(R, dOmega);
-
-				determinantCoriolisForceY = omega.y() * V.z() - omega.z() * V.y() - omega.x() * V.z() + omega.z() * V.x() + omega.x() * V.y() - omega.y() * V.x();
-				CoriolisForce =
-					(determinantCoriolisForceY > 0) ?
-					2 * getCross(omega, V) :
-					2 * getCross(V, omega);
-
-				fixedA = centralForce + tangentialForce - CoriolisForce;
-
-				A = Vector3(
-					fixedA.x() / cos(omega.x()),
-					fixedA.y() / cos(omega.y()),
-					0);
-
-				newVY = Vector2(A.x(), A.y());
+				auto anp = groups.positions_[begin + i];
+				auto normalizedDistance = normalize(position_ - anp);
+
+				auto first = sim_->repulsiveStrength_ * exp((2 * radius_ - getLength(normalizedDistance)) / sim_->repulsiveRange_);
+				auto second = sim_->attractiveStrength_ * exp((2 * radius_ - getLength(normalizedDistance)) / sim_->attractiveRange_);
+
+				correction += (first - second) * getPerception(&position_, &anp) * normalizedDistance;
 			}
 
-			auto result = (velocity_ + (newVX + newVY) * sim_->timeStep_);
+			return;
+		}
 
-			// heave
-			// TODO good heave
-			auto platformVeclocity = sim_->getPlatformVelocity();
-			
-			float
-				accelerationZ = platformVeclocity.z() * pow(sim_->timeStep_, 2),
-				oldAccelerationZ = oldPlatformVelocity_.z() * pow(sim_->timeStep_, 2);
+		// The forces of the other members are replaced by their count times the force of their centroid, which is exact when they lie in one direction
+		const auto others = static_cast<float>(count - 1);
+		auto centroid = (groups.centroids_[groupNo_] * static_cast<float>(count) - position_) / others;
 
-			auto difference = fabs(accelerationZ) - fabs(oldAccelerationZ);
+		if (position_ == centroid)
+			return;
 
-			if (difference > 0)	
-				result = result * (1 + fabs(difference));
-			else
-				result = result * (1 - fabs(difference));
+		auto normalizedDistance = normalize(position_ - centroid);
 
-			oldPlatformVelocity_ = platformVeclocity;
+		auto first = sim_->repulsiveStrength_ * exp((2 * radius_ - getLength(normalizedDistance)) / sim_->repulsiveRange_);
+		auto second = sim_->attractiveStrength_ * exp((2 * radius_ - getLength(normalizedDistance)) / sim_->attractiveRange_);
 
-			correction += result * platformFactor_;
-		}
+		correction += others * (first - second) * getPerception(&position_, &centroid) * normalizedDistance;
+	}
+
+	/// <summary> Moving platform force, computed for all agents by the simulator before the agent forces </summary>
+	void Agent::getMovingPlatformForce()
+	{
+		if (sim_->platformFrame_.isActive)
+			correction += sim_->agentStorage_->platformForces_[slot_];
 	}
 
 	/// <summary> Search for the best new velocity </summary>
@@ -571,29 +465,15 @@ namespace SF
 	}
 
 	/// <summary> Inserts an agent neighbor into the set of neighbors of this agent </summary>
-	/// <param name="agent"> A pointer to the agent to be inserted </param>
+	/// <param name="agentNo"> The storage slot of the agent to be inserted </param>
+	/// <param name="distSq"> The squared distance between this agent and the inserted one </param>
 	/// <param name="rangeSq"> The squared range around this agent </param>
-	void Agent::insertAgentNeighbor(const Agent* agent, float& rangeSq)
+	void Agent::insertAgentNeighbor(size_t agentNo, float distSq, float& rangeSq)
 	{
-		if (this != agent) 
+		if (slot_ != agentNo) 
 		{
-			const auto distSq = absSq(position_ - agent->position_);
-
-			if (distSq < rangeSq) 
+			if (distSq < rangeSq && agentNeighbors_.insert(distSq, agentNo, maxNeighbors_)) 
 			{
-				if (agentNeighbors_.size() < maxNeighbors_) 
-					agentNeighbors_.push_back(std::make_pair(distSq,agent));
-				
-				auto i = agentNeighbors_.size() - 1;
-			
-				while (i != 0 && distSq < agentNeighbors_[i-1].first) 
-				{
-					agentNeighbors_[i] = agentNeighbors_[i-1];
-					--i;
-				}
-				
-				agentNeighbors_[i] = std::make_pair(distSq, agent);
-
 				if (agentNeighbors_.size() == maxNeighbors_) 
 					rangeSq = agentNeighbors_.back().first;
 			}
@@ -601,41 +481,29 @@ namespace SF
 	}
 
 	/// <summary> Inserts a static obstacle neighbor into the set of neighbors of this agent </summary>
-	/// <param name="agent"> A pointer to the obstacle to be inserted </param>
+	/// <param name="obstacleNo"> The number of the obstacle segment to be inserted </param>
+	/// <param name="point1"> The first endpoint of the obstacle segment </param>
+	/// <param name="point2"> The second endpoint of the obstacle segment </param>
 	/// <param name="rangeSq"> The squared range around this agent </param>
-	void Agent::insertObstacleNeighbor(const Obstacle* obstacle, float rangeSq)
+	void Agent::insertObstacleNeighbor(size_t obstacleNo, const Vector2& point1, const Vector2& point2, float rangeSq)
 	{
-		const Obstacle* const nextObstacle = obstacle->nextObstacle;
-
-		const auto distSq = distSqPointLineSegment(obstacle->point_, nextObstacle->point_, position_);
+		const auto distSq = distSqPointLineSegment(point1, point2, position_);
 
 		if (distSq < rangeSq) 
-		{
-			obstacleNeighbors_.push_back(std::make_pair(distSq,obstacle));
-      
-			auto i = obstacleNeighbors_.size() - 1;
-			while (i != 0 && distSq < obstacleNeighbors_[i-1].first) 
-			{
-				obstacleNeighbors_[i] = obstacleNeighbors_[i-1];
-				--i;
-			}
-			
-			obstacleNeighbors_[i] = std::make_pair(distSq, obstacle);
-		}
+			obstacleNeighbors_.insert(distSq, obstacleNo, maxObstacleNeighbors_);
 	}
 
 	/// <summary> Inserts an neighbor agent identifier into the set of neighbors of this agent </summary>
-	/// <param name="agent"> A pointer to the agent ID to be inserted </param>
+	/// <param name="agentNo"> The storage slot of the agent to be inserted </param>
+	/// <param name="distSq"> The squared distance between this agent and the inserted one </param>
 	/// <param name="rangeSq"> The squared range around this agent </param>
-	void Agent::insertAgentNeighborsIndex(const Agent* agent, const float& rangeSq)
+	void Agent::insertAgentNeighborsIndex(size_t agentNo, float distSq, const float& rangeSq)
 	{
-		if (this != agent) 
+		if (slot_ != agentNo) 
 		{
-			const auto distSq = absSq(position_ - agent->position_);
-
 			if (distSq < rangeSq) 
 			{
-				agentNeighborsIndexList_.push_back(std::make_pair(agent->id_, distSq));
+				agentNeighborsIndexList_.push_back(std::make_pair(agentNo, distSq));
 				auto i = agentNeighborsIndexList_.size() - 1;
         
 				while (i != 0 && distSq < agentNeighborsIndexList_[i-1].second) 
@@ -644,28 +512,19 @@ namespace SF
 					--i;
 				}
 
-				agentNeighborsIndexList_[i] = std::make_pair(agent->id_, distSq);
+				agentNeighborsIndexList_[i] = std::make_pair(agentNo, distSq);
 			}
 		}
 	}
 
-	/// <summary> Gets point on line nearest to selected position  </summary>
-	/// <param name="start"> Position of start of line </param>
-	/// <param name="end"> Position of end of line </param>
-	/// <param name="point"> Selected point </param>
-	/// <returns> The nearest point </returns>
-	Vector2 Agent::getNearestPoint(Vector2 *start, Vector2 *end, Vector2 *point) const
+	/// <summary> Inserts an agent into the cached neighbor candidates of this agent </summary>
+	/// <param name="agentNo"> The storage slot of the agent to be inserted </param>
+	/// <param name="distSq"> The squared distance between this agent and the inserted one </param>
+	/// <param name="rangeSq"> The squared range around this agent, including the neighbor skin </param>
+	void Agent::insertAgentNeighborCandidate(size_t agentNo, float distSq, float rangeSq)
 	{
-		auto relativeEndPoint = *end - *start;
-		auto relativePoint = *point - *start;
-		double lambda = relativePoint * relativeEndPoint / relativeEndPoint.GetLengthSquared();
-
-		if(lambda <= 0)
-			return *start;
-		else if(lambda >= 1)
-			return *end;
-		else
-			return *start + static_cast<float>(lambda) * relativeEndPoint;
+		if (slot_ != agentNo && distSq < rangeSq)
+			agentNeighborCandidates_.push_back(agentNo);
 	}
 
 	/// <summary> Returns the smaller of two float numbers </summary>
@@ -718,88 +577,6 @@ namespace SF
         return radian * (180.0f / M_PI);
     }
 
-	/// <summary> Gets current roll </summary>
-	/// <param name="pt"> Rotation projection type </param>
-	/// <param name="tt"> Rotation time type </param>
-	/// <returns> Roll </returns>
-	Vector3 Agent::getRoll(ParameterType pt, TimeType tt) const
-	{
-		Vector3 rotation;
-		float value = 0;
-
-		if(tt == PAST)
-			rotation = sim_->rotationPast_;
-		else if(tt == PAST2NOW)
-			rotation = sim_->rotationPast2Now_;
-		else if(tt == NOW)
-			rotation = sim_->rotationNow_;
-		else if(tt == NOW2FUTURE)
-			rotation == sim_->rotationNow2Future_;
-		if(tt == FUTURE)
-			rotation = sim_->rotationFuture_;
-
-		if(pt == X)
-			value = rotation.x();
-		
-		if(pt == Y)
-			value = rotation.y();
-
-		if (pt == Z)
-			value = rotation.z();
-
-		return Vector3(value, value, value);
-	}
-
-	/// <summary> Gets Omega matrix </summary>
-	/// <param name="pt"> Rotation projection type </param>
-	/// <param name="tt"> Rotation time type </param>
-	/// <returns> Omega matrix </returns>
-	Vector3 Agent::getOmega(ParameterType pt, TimeType tt)
-	{
-		float value = 0;
-		
-		if(tt == NOW)
-			value = (getRoll(pt, NOW2FUTURE).x() - getRoll(pt, PAST2NOW).x()) / sim_->timeStep_;
-		else if(tt == NOW2FUTURE)
-			value = (getRoll(pt, FUTURE).x() - getRoll(pt, NOW).x()) / sim_->timeStep_;
-		else if(tt == PAST2NOW)
-			value = (getRoll(pt, NOW).x() - getRoll(pt, PAST).x()) / sim_->timeStep_;
-			
-		if(pt == X)
-			return Vector3(value, 0, 0);
-		
-		if(pt == Y)
-			return Vector3(0, value, 0);
-
-		if (pt == Z)
-			return Vector3(0, 0, value);
-
-		return Vector3();
-	}
-
-	/// <summary> Gets DOmega matrix </summary>
-	/// <param name="pt"> Rotation projection type </param>
-	/// <param name="tt"> Rotation time type </param>
-	/// <returns> DOmega matrix </returns>
-	Vector3 Agent::getDOmega(ParameterType pt, TimeType tt)
-	{
-		float value = 0;
-
-		if(tt == NOW)
-			value = (getOmega(pt, NOW2FUTURE).x() - getOmega(pt, PAST2NOW).x()) / sim_->timeStep_;
-			
-		if(pt == X)
-			return Vector3(value, 0, 0);
-		
-		if(pt == Y)
-			return Vector3(0, value, 0);
-
-		if (pt == Z)
-			return Vector3(0, 0, value);
-
-		return Vector3();
-	}
-
 	/// <summary> Has intersection computing method </summary>
 	/// <param name="a"> Start of first line </param>
 	/// <param name="b"> End of first line </param>
@@ -0,0 +1,258 @@
+#include <algorithm>
+
+#include "../include/SFSimulator.h"
+#include "../include/AgentGrid.h"
+#include "../include/Agent.h"
+#include "../include/AgentStorage.h"
+
+namespace SF
+{
+	/// <summary> Constructs an empty agent grid </summary>
+	/// <param name="sim"> The simulator instance </param>
+	AgentGrid::AgentGrid(SFSimulator* sim) :
+		cellStart_(),
+		cellFill_(),
+		cellAgents_(),
+		agentCells_(),
+		minX_(0.0f),
+		minY_(0.0f),
+		cellSize_(1.0f),
+		columns_(0),
+		rows_(0),
+		sim_(sim)
+	{ }
+
+	/// <summary> Destructor </summary>
+	AgentGrid::~AgentGrid() { }
+
+	/// <summary> Sorts the agents into the grid cells with a counting sort </summary>
+	void AgentGrid::build()
+	{
+		const auto& storage = *sim_->agentStorage_;
+
+		size_t count = 0;
+		auto maxX = 0.0f;
+		auto maxY = 0.0f;
+		auto maxNeighborDist = 0.0f;
+
+		for (size_t i = 0; i < storage.size(); ++i)
+		{
+			const auto& position = storage.positions_[i];
+
+			if (count == 0)
+			{
+				minX_ = maxX = position.x();
+				minY_ = maxY = position.y();
+			}
+			else
+			{
+				minX_ = std::min(minX_, position.x());
+				maxX = std::max(maxX, position.x());
+				minY_ = std::min(minY_, position.y());
+				maxY = std::max(maxY, position.y());
+			}
+
+			maxNeighborDist = std::max(maxNeighborDist, storage.neighborDists_[i]);
+			++count;
+		}
+
+		columns_ = rows_ = 0;
+		cellAgents_.clear();
+
+		if (count == 0)
+			return;
+
+		// A cell half as large as the neighbor distance keeps each query within 5 x 5 cells, small enough to skip the corner cells beyond the range; sparse scenes get larger cells to bound the memory
+		cellSize_ = std::max(maxNeighborDist / CELLS_PER_NEIGHBOR_DIST, SF_EPSILON);
+
+		while (true)
+		{
+			columns_ = static_cast<size_t>((maxX - minX_) / cellSize_) + 1;
+			rows_ = static_cast<size_t>((maxY - minY_) / cellSize_) + 1;
+
+			if (columns_ * rows_ <= MAX_CELLS_PER_AGENT * count)
+				break;
+
+			cellSize_ *= 2.0f;
+		}
+
+		// The cell buffers are reserved for the most cells the agents may get, so that they stop growing with the extent of the agents
+		cellStart_.reserve(MAX_CELLS_PER_AGENT * count + 1);
+		cellFill_.reserve(MAX_CELLS_PER_AGENT * count + 1);
+		cellStart_.assign(columns_ * rows_ + 1, 0);
+		agentCells_.resize(storage.size());
+		cellAgents_.resize(count);
+
+		for (size_t i = 0; i < storage.size(); ++i)
+		{
+			const auto column = std::min(columns_ - 1, static_cast<size_t>((storage.positions_[i].x() - minX_) / cellSize_));
+			const auto row = std::min(rows_ - 1, static_cast<size_t>((storage.positions_[i].y() - minY_) / cellSize_));
+
+			agentCells_[i] = row * columns_ + column;
+			++cellStart_[agentCells_[i] + 1];
+		}
+
+		for (size_t c = 1; c < cellStart_.size(); ++c)
+			cellStart_[c] += cellStart_[c - 1];
+
+		cellFill_.assign(cellStart_.begin(), cellStart_.end());
+
+		for (size_t i = 0; i < storage.size(); ++i)
+			cellAgents_[cellFill_[agentCells_[i]]++] = i;
+	}
+
+	/// <summary> Computes the range of cells overlapping a square around the specified point </summary>
+	/// <param name="position"> The center of the square </param>
+	/// <param name="range"> The half side of the square </param>
+	/// <param name="minColumn"> The first overlapped column </param>
+	/// <param name="maxColumn"> The last overlapped column </param>
+	/// <param name="minRow"> The first overlapped row </param>
+	/// <param name="maxRow"> The last overlapped row </param>
+	/// <returns> False if the square does not overlap the grid </returns>
+	bool AgentGrid::getCellRange(const Vector2& position, float range, size_t& minColumn, size_t& maxColumn, size_t& minRow, size_t& maxRow) const
+	{
+		if (columns_ == 0)
+			return false;
+
+		// The margin keeps agents lying on a cell border within the range despite rounding
+		const auto margin = range + 0.001f * cellSize_;
+		const auto left = (position.x() - margin - minX_) / cellSize_;
+		const auto right = (position.x() + margin - minX_) / cellSize_;
+		const auto bottom = (position.y() - margin - minY_) / cellSize_;
+		const auto top = (position.y() + margin - minY_) / cellSize_;
+
+		if (right < 0.0f || top < 0.0f || left >= static_cast<float>(columns_) || bottom >= static_cast<float>(rows_))
+			return false;
+
+		minColumn = static_cast<size_t>(std::max(0.0f, left));
+		maxColumn = std::min(columns_ - 1, static_cast<size_t>(right));
+		minRow = static_cast<size_t>(std::max(0.0f, bottom));
+		maxRow = std::min(rows_ - 1, static_cast<size_t>(top));
+
+		return true;
+	}
+
+	/// <summary> Computes the squared distance from the specified point to the specified cell </summary>
+	/// <param name="position"> The selected point </param>
+	/// <param name="column"> The column of the cell </param>
+	/// <param name="row"> The row of the cell </param>
+	/// <returns> The squared distance, zero if the point lies in the cell </returns>
+	float AgentGrid::distSqToCell(const Vector2& position, size_t column, size_t row) const
+	{
+		const auto margin = 0.001f * cellSize_;
+		const auto cellMinX = minX_ + column * cellSize_ - margin;
+		const auto cellMinY = minY_ + row * cellSize_ - margin;
+		const auto cellSize = cellSize_ + 2.0f * margin;
+
+		return sqr(std::max(0.0f, cellMinX - position.x())) + sqr(std::max(0.0f, position.x() - cellMinX - cellSize)) + sqr(std::max(0.0f, cellMinY - position.y())) + sqr(std::max(0.0f, position.y() - cellMinY - cellSize));
+	}
+
+	/// <summary> Computes the agent neighbors of the specified agent </summary>
+	/// <param name="agent"> A pointer to the agent for which agent neighbors are to be computed </param>
+	/// <param name="rangeSq"> The squared range around the agent </param>
+	void AgentGrid::computeAgentNeighbors(Agent* agent, float& rangeSq) const
+	{
+		size_t minColumn, maxColumn, minRow, maxRow;
+
+		if (!getCellRange(agent->position_, std::sqrt(rangeSq), minColumn, maxColumn, minRow, maxRow))
+			return;
+
+		const auto& positions = sim_->agentStorage_->positions_;
+		const auto centerColumn = std::min(maxColumn, std::max(minColumn, static_cast<size_t>(std::max(0.0f, (agent->position_.x() - minX_) / cellSize_))));
+		const auto centerRow = std::min(maxRow, std::max(minRow, static_cast<size_t>(std::max(0.0f, (agent->position_.y() - minY_) / cellSize_))));
+		const auto rings = std::max(std::max(centerColumn - minColumn, maxColumn - centerColumn), std::max(centerRow - minRow, maxRow - centerRow));
+
+		// Rings of cells around the agent are visited nearest first, so that the range shrinks early once the neighbor list is full
+		for (size_t ring = 0; ring <= rings; ++ring)
+		{
+			for (auto row = std::max(minRow, centerRow - std::min(centerRow, ring)); row <= std::min(maxRow, centerRow + ring); ++row)
+			{
+				const auto isRingRow = row + ring == centerRow || row == centerRow + ring;
+
+				for (auto column = std::max(minColumn, centerColumn - std::min(centerColumn, ring)); column <= std::min(maxColumn, centerColumn + ring); ++column)
+				{
+					if (!isRingRow && column + ring != centerColumn && column != centerColumn + ring)
+						continue;
+
+					if (distSqToCell(agent->position_, column, row) >= rangeSq)
+						continue;
+
+					const auto cell = row * columns_ + column;
+
+					for (auto i = cellStart_[cell]; i < cellStart_[cell + 1]; ++i)
+					{
+						const auto agentNo = cellAgents_[i];
+
+						agent->insertAgentNeighbor(agentNo, absSq(agent->position_ - positions[agentNo]), rangeSq);
+					}
+				}
+			}
+		}
+	}
+
+	/// <summary> Computes the agent ID neighbors of the specified agent </summary>
+	/// <param name="agent"> A pointer to the agent for which agent ID neighbors are to be computed </param>
+	/// <param name="rangeSq"> The squared range around the agent </param>
+	void AgentGrid::computeAgentNeighborsIndexList(Agent* agent, float& rangeSq) const
+	{
+		size_t minColumn, maxColumn, minRow, maxRow;
+
+		if (!getCellRange(agent->position_, std::sqrt(rangeSq), minColumn, maxColumn, minRow, maxRow))
+			return;
+
+		const auto& positions = sim_->agentStorage_->positions_;
+
+		for (auto row = minRow; row <= maxRow; ++row)
+		{
+			for (auto column = minColumn; column <= maxColumn; ++column)
+			{
+				const auto cell = row * columns_ + column;
+
+				for (auto i = cellStart_[cell]; i < cellStart_[cell + 1]; ++i)
+				{
+					const auto agentNo = cellAgents_[i];
+
+					agent->insertAgentNeighborsIndex(agentNo, absSq(agent->position_ - positions[agentNo]), rangeSq);
+				}
+			}
+		}
+	}
+
+	/// <summary> Collects the unsorted agent neighbor candidates of the specified agent </summary>
+	/// <param name="agent"> A pointer to the agent for which agent neighbor candidates are to be collected </param>
+	/// <param name="rangeSq"> The squared range around the agent </param>
+	void AgentGrid::computeAgentNeighborCandidates(Agent* agent, float rangeSq) const
+	{
+		size_t minColumn, maxColumn, minRow, maxRow;
+
+		if (!getCellRange(agent->position_, std::sqrt(rangeSq), minColumn, maxColumn, minRow, maxRow))
+			return;
+
+		const auto& positions = sim_->agentStorage_->positions_;
+
+		for (auto row = minRow; row <= maxRow; ++row)
+		{
+			for (auto column = minColumn; column <= maxColumn; ++column)
+			{
+				if (distSqToCell(agent->position_, column, row) >= rangeSq)
+					continue;
+
+				const auto cell = row * columns_ + column;
+
+				for (auto i = cellStart_[cell]; i < cellStart_[cell + 1]; ++i)
+				{
+					const auto agentNo = cellAgents_[i];
+
+					agent->insertAgentNeighborCandidate(agentNo, absSq(agent->position_ - positions[agentNo]), rangeSq);
+				}
+			}
+		}
+	}
+
+	/// <summary> Returns the storage slots of the indexed agents in the order of the grid cells </summary>
+	/// <returns> The agent slots </returns>
+	const std::vector<size_t>& AgentGrid::getAgentOrder() const
+	{
+		return cellAgents_;
+	}
+}
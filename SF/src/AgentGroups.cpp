@@ -0,0 +1,128 @@
+#include "../include/AgentGroups.h"
+#include "../include/Agent.h"
+
+namespace SF
+{
+	/// <summary> Constructs an empty group table </summary>
+	/// <param name="sim"> The simulator instance </param>
+	AgentGroups::AgentGroups(SFSimulator* sim) :
+		members_(),
+		positionOffsets_(1, 0),
+		positions_(),
+		centroids_(),
+		sim_(sim)
+	{ }
+
+	/// <summary> Destructor </summary>
+	AgentGroups::~AgentGroups() { }
+
+	/// <summary> Adds a group of the specified agents, moving them from their previous groups </summary>
+	/// <param name="agentNos"> The numbers of the agents; deleted agents and repeated numbers are ignored </param>
+	/// <returns> The number of the group </returns>
+	size_t AgentGroups::add(const std::vector<size_t>& agentNos)
+	{
+		const auto groupNo = members_.size();
+		members_.push_back(std::vector<size_t>());
+
+		for (auto agentNo : agentNos)
+		{
+			if (agentNo >= sim_->agents_.size())
+				continue;
+
+			auto agent = sim_->agents_[agentNo];
+
+			if (!agent->isDeleted_)
+				assign(agent, groupNo);
+		}
+
+		return groupNo;
+	}
+
+	/// <summary> Moves the specified agent to the specified group, creating it when its number is the count of groups </summary>
+	/// <param name="agent"> A pointer to the agent </param>
+	/// <param name="groupNo"> The number of the group, at most the count of groups, or SF::SF_ERROR to remove the agent from its group </param>
+	void AgentGroups::assign(Agent* agent, size_t groupNo)
+	{
+		if (agent->groupNo_ == groupNo)
+			return;
+
+		remove(agent);
+
+		if (groupNo == SF_ERROR)
+			return;
+
+		if (groupNo == members_.size())
+			members_.push_back(std::vector<size_t>());
+
+		agent->groupNo_ = groupNo;
+		agent->groupIndex_ = members_[groupNo].size();
+		members_[groupNo].push_back(agent->id_);
+	}
+
+	/// <summary> Removes the specified agent from its group, moving the last member of the group in its place </summary>
+	/// <param name="agent"> A pointer to the agent, ignored when not in a group </param>
+	void AgentGroups::remove(Agent* agent)
+	{
+		if (agent->groupNo_ == SF_ERROR)
+			return;
+
+		auto& members = members_[agent->groupNo_];
+		const auto last = members.back();
+
+		members[agent->groupIndex_] = last;
+		sim_->agents_[last]->groupIndex_ = agent->groupIndex_;
+		members.pop_back();
+
+		agent->groupNo_ = SF_ERROR;
+		agent->groupIndex_ = 0;
+	}
+
+	/// <summary> Removes all groups </summary>
+	void AgentGroups::clear()
+	{
+		for (const auto& members : members_)
+		{
+			for (auto agentNo : members)
+			{
+				sim_->agents_[agentNo]->groupNo_ = SF_ERROR;
+				sim_->agents_[agentNo]->groupIndex_ = 0;
+			}
+		}
+
+		members_.clear();
+	}
+
+	/// <summary> Packs the current positions of the members and computes the group centroids </summary>
+	void AgentGroups::update()
+	{
+		positionOffsets_.resize(members_.size() + 1);
+
+		for (size_t i = 0; i < members_.size(); ++i)
+			positionOffsets_[i + 1] = positionOffsets_[i] + members_[i].size();
+
+		positions_.resize(positionOffsets_.back());
+		centroids_.resize(members_.size());
+
+		for (size_t i = 0; i < members_.size(); ++i)
+		{
+			auto sum = Vector2();
+			auto position = positions_.begin() + positionOffsets_[i];
+
+			for (auto agentNo : members_[i])
+			{
+				*position = sim_->agents_[agentNo]->position_;
+				sum += *position;
+				++position;
+			}
+
+			centroids_[i] = members_[i].empty() ? Vector2() : sum / static_cast<float>(members_[i].size());
+		}
+	}
+
+	/// <summary> Returns the count of groups </summary>
+	/// <returns> The count of groups </returns>
+	size_t AgentGroups::size() const
+	{
+		return members_.size();
+	}
+}
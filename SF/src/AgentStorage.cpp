@@ -0,0 +1,133 @@
+#include "../include/AgentStorage.h"
+#include "../include/Agent.h"
+
+namespace SF
+{
+	/// <summary> Constructs an empty agent storage </summary>
+	AgentStorage::AgentStorage() :
+		positions_(),
+		velocities_(),
+		prefVelocities_(),
+		radii_(),
+		maxSpeeds_(),
+		neighborDists_(),
+		speeds_(),
+		platformFactors_(),
+		platformForces_(),
+		candidatePositions_(),
+		agents_()
+	{ }
+
+	/// <summary> Destructor </summary>
+	AgentStorage::~AgentStorage() { }
+
+	/// <summary> Appends the state of a new agent to the storage and assigns it the last slot </summary>
+	/// <param name="agent"> A pointer to the agent to be appended </param>
+	void AgentStorage::add(Agent* agent)
+	{
+		agent->slot_ = size();
+
+		positions_.push_back(agent->position_);
+		velocities_.push_back(agent->velocity_);
+		prefVelocities_.push_back(agent->prefVelocity_);
+		radii_.push_back(agent->radius_);
+		maxSpeeds_.push_back(agent->maxSpeed_);
+		neighborDists_.push_back(agent->neighborDist_);
+		speeds_.push_back(0.0f);
+		platformFactors_.push_back(agent->platformFactor_);
+		candidatePositions_.push_back(agent->position_);
+		agents_.push_back(agent);
+	}
+
+	/// <summary> Copies the state of the specified agent into its slot </summary>
+	/// <param name="agent"> A pointer to the agent to be stored; agents removed from the storage are ignored </param>
+	void AgentStorage::store(const Agent* agent)
+	{
+		const auto i = agent->slot_;
+
+		if (i == SF_ERROR)
+			return;
+
+		positions_[i] = agent->position_;
+		velocities_[i] = agent->velocity_;
+		prefVelocities_[i] = agent->prefVelocity_;
+		radii_[i] = agent->radius_;
+		maxSpeeds_[i] = agent->maxSpeed_;
+		neighborDists_[i] = agent->neighborDist_;
+		platformFactors_[i] = agent->platformFactor_;
+	}
+
+	/// <summary> Moves the agents not marked for deleting to the front slots keeping their order, and releases the others </summary>
+	/// <returns> True if any agent has been released </returns>
+	bool AgentStorage::compact()
+	{
+		size_t count = 0;
+
+		for (size_t i = 0; i < size(); ++i)
+		{
+			auto agent = agents_[i];
+
+			if (agent->isDeleted_)
+			{
+				agent->slot_ = SF_ERROR;
+				continue;
+			}
+
+			if (count != i)
+			{
+				positions_[count] = positions_[i];
+				velocities_[count] = velocities_[i];
+				prefVelocities_[count] = prefVelocities_[i];
+				radii_[count] = radii_[i];
+				maxSpeeds_[count] = maxSpeeds_[i];
+				neighborDists_[count] = neighborDists_[i];
+				speeds_[count] = speeds_[i];
+				platformFactors_[count] = platformFactors_[i];
+				candidatePositions_[count] = candidatePositions_[i];
+				agents_[count] = agent;
+				agent->slot_ = count;
+			}
+
+			++count;
+		}
+
+		if (count == size())
+			return false;
+
+		positions_.resize(count);
+		velocities_.resize(count);
+		prefVelocities_.resize(count);
+		radii_.resize(count);
+		maxSpeeds_.resize(count);
+		neighborDists_.resize(count);
+		speeds_.resize(count);
+		platformFactors_.resize(count);
+		candidatePositions_.resize(count);
+		agents_.resize(count);
+
+		return true;
+	}
+
+	/// <summary> Removes all agents from the storage </summary>
+	void AgentStorage::clear()
+	{
+		positions_.clear();
+		velocities_.clear();
+		prefVelocities_.clear();
+		radii_.clear();
+		maxSpeeds_.clear();
+		neighborDists_.clear();
+		speeds_.clear();
+		platformFactors_.clear();
+		platformForces_.clear();
+		candidatePositions_.clear();
+		agents_.clear();
+	}
+
+	/// <summary> Returns the count of agent slots in the storage </summary>
+	/// <returns> The count of agent slots </returns>
+	size_t AgentStorage::size() const
+	{
+		return positions_.size();
+	}
+}
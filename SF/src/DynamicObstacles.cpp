@@ -0,0 +1,281 @@
+#include <algorithm>
+
+#include "../include/DynamicObstacles.h"
+#include "../include/SFSimulator.h"
+#include "../include/Agent.h"
+#include "../include/ObstacleSegments.h"
+
+namespace SF
+{
+	/// <summary> Constructs an empty set of dynamic obstacles </summary>
+	/// <param name="sim"> The simulator instance </param>
+	DynamicObstacles::DynamicObstacles(SFSimulator* sim) :
+		obstacles_(),
+		enabledNos_(),
+		minX_(),
+		minY_(),
+		maxX_(),
+		maxY_(),
+		sim_(sim)
+	{ }
+
+	/// <summary> Destructor </summary>
+	DynamicObstacles::~DynamicObstacles() { }
+
+	/// <summary> Adds an enabled obstacle and appends its segments to the segment table </summary>
+	/// <param name="vertices"> The vertices of the polygonal obstacle in counterclockwise order </param>
+	/// <returns> The number of the obstacle, or SF::SF_ERROR when the number of vertices is less than two </returns>
+	size_t DynamicObstacles::add(const std::vector<Vector2>& vertices)
+	{
+		if (vertices.size() < 2)
+			return SF_ERROR;
+
+		auto& segments = *sim_->obstacleSegments_;
+
+		DynamicObstacle obstacle;
+		obstacle.vertices = vertices;
+		obstacle.offset = Vector2();
+		obstacle.firstSegment = segments.size();
+		obstacle.enabledIndex = 0;
+		obstacle.isEnabled = false;
+		obstacle.isRemoved = false;
+
+		const auto obstacleNo = obstacles_.size();
+		obstacles_.push_back(obstacle);
+
+		segments.resize(segments.size() + vertices.size());
+		writeObstacle(obstacleNo);
+		setEnabled(obstacleNo, true);
+
+		return obstacleNo;
+	}
+
+	/// <summary> Removes the specified obstacle; its segments are released when the obstacles are processed </summary>
+	/// <param name="obstacleNo"> The number of the obstacle </param>
+	void DynamicObstacles::remove(size_t obstacleNo)
+	{
+		setEnabled(obstacleNo, false);
+		obstacles_[obstacleNo].isRemoved = true;
+	}
+
+	/// <summary> Enables or disables the specified obstacle </summary>
+	/// <param name="obstacleNo"> The number of the obstacle, ignored when removed </param>
+	/// <param name="isEnabled"> True to let the obstacle take part in the simulation </param>
+	void DynamicObstacles::setEnabled(size_t obstacleNo, bool isEnabled)
+	{
+		auto& obstacle = obstacles_[obstacleNo];
+
+		if (obstacle.isRemoved || obstacle.isEnabled == isEnabled)
+			return;
+
+		obstacle.isEnabled = isEnabled;
+
+		if (isEnabled)
+		{
+			obstacle.enabledIndex = enabledNos_.size();
+			enabledNos_.push_back(obstacleNo);
+			minX_.push_back(0.0f);
+			minY_.push_back(0.0f);
+			maxX_.push_back(0.0f);
+			maxY_.push_back(0.0f);
+
+			writeObstacle(obstacleNo);
+			return;
+		}
+
+		// The last enabled obstacle takes the place of the disabled one
+		const auto index = obstacle.enabledIndex;
+		const auto last = enabledNos_.size() - 1;
+
+		enabledNos_[index] = enabledNos_[last];
+		minX_[index] = minX_[last];
+		minY_[index] = minY_[last];
+		maxX_[index] = maxX_[last];
+		maxY_[index] = maxY_[last];
+		obstacles_[enabledNos_[index]].enabledIndex = index;
+
+		enabledNos_.pop_back();
+		minX_.pop_back();
+		minY_.pop_back();
+		maxX_.pop_back();
+		maxY_.pop_back();
+	}
+
+	/// <summary> Moves the specified obstacle </summary>
+	/// <param name="obstacleNo"> The number of the obstacle, ignored when removed </param>
+	/// <param name="offset"> The translation of the vertices from their positions when added </param>
+	void DynamicObstacles::setOffset(size_t obstacleNo, const Vector2& offset)
+	{
+		if (obstacles_[obstacleNo].isRemoved)
+			return;
+
+		obstacles_[obstacleNo].offset = offset;
+		writeObstacle(obstacleNo);
+	}
+
+	/// <summary> Appends the segments of all obstacles to the static segments of the segment table, releasing those of the removed obstacles </summary>
+	void DynamicObstacles::writeSegments()
+	{
+		auto& segments = *sim_->obstacleSegments_;
+		auto count = segments.staticCount_;
+
+		for (auto& obstacle : obstacles_)
+		{
+			if (obstacle.isRemoved)
+				continue;
+
+			obstacle.firstSegment = count;
+			count += obstacle.vertices.size();
+		}
+
+		segments.resize(count);
+
+		for (size_t i = 0; i < obstacles_.size(); ++i)
+			if (!obstacles_[i].isRemoved)
+				writeObstacle(i);
+	}
+
+	/// <summary> Writes the segments of the specified obstacle into the segment table, and its bounding box when enabled </summary>
+	/// <param name="obstacleNo"> The number of the obstacle </param>
+	void DynamicObstacles::writeObstacle(size_t obstacleNo)
+	{
+		auto& segments = *sim_->obstacleSegments_;
+		const auto& obstacle = obstacles_[obstacleNo];
+		const auto& vertices = obstacle.vertices;
+		const auto count = vertices.size();
+
+		auto minX = vertices[0].x();
+		auto minY = vertices[0].y();
+		auto maxX = minX;
+		auto maxY = minY;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const auto& next = vertices[i == count - 1 ? 0 : i + 1];
+
+			segments.set(obstacle.firstSegment + i, vertices[i] + obstacle.offset, next + obstacle.offset, obstacle.firstSegment);
+
+			minX = std::min(minX, vertices[i].x());
+			minY = std::min(minY, vertices[i].y());
+			maxX = std::max(maxX, vertices[i].x());
+			maxY = std::max(maxY, vertices[i].y());
+		}
+
+		if (obstacle.isEnabled)
+		{
+			const auto index = obstacle.enabledIndex;
+
+			minX_[index] = minX + obstacle.offset.x();
+			minY_[index] = minY + obstacle.offset.y();
+			maxX_[index] = maxX + obstacle.offset.x();
+			maxY_[index] = maxY + obstacle.offset.y();
+		}
+	}
+
+	/// <summary> Inserts the segments of the enabled obstacles within range into the obstacle neighbors of the specified agent </summary>
+	/// <param name="agent"> A pointer to the agent for which obstacle neighbors are to be computed </param>
+	/// <param name="rangeSq"> The squared range around the agent </param>
+	void DynamicObstacles::computeObstacleNeighbors(Agent* agent, float rangeSq) const
+	{
+		const auto& segments = *sim_->obstacleSegments_;
+		const auto x = agent->position_.x();
+		const auto y = agent->position_.y();
+
+		for (size_t i = 0; i < enabledNos_.size(); ++i)
+		{
+			const auto dx = std::max(0.0f, std::max(minX_[i] - x, x - maxX_[i]));
+			const auto dy = std::max(0.0f, std::max(minY_[i] - y, y - maxY_[i]));
+
+			if (sqr(dx) + sqr(dy) >= rangeSq)
+				continue;
+
+			const auto& obstacle = obstacles_[enabledNos_[i]];
+			const auto end = obstacle.firstSegment + obstacle.vertices.size();
+
+			for (auto segmentNo = obstacle.firstSegment; segmentNo < end; ++segmentNo)
+				agent->insertObstacleNeighbor(segmentNo, segments.getStart(segmentNo), segments.getEnd(segmentNo), rangeSq);
+		}
+	}
+
+	/// <summary> Queries the visibility between two points within a specified radius with respect to the enabled obstacles, which block the view from both sides </summary>
+	/// <param name="q1"> The first point between which visibility is to be tested </param>
+	/// <param name="q2"> The second point between which visibility is to be tested </param>
+	/// <param name="radius"> The radius within which visibility is to be tested </param>
+	/// <returns> True if q1 and q2 are mutually visible within the radius; false otherwise </returns>
+	bool DynamicObstacles::queryVisibility(const Vector2& q1, const Vector2& q2, float radius) const
+	{
+		const auto& segments = *sim_->obstacleSegments_;
+		const auto radiusSq = sqr(radius);
+
+		const auto minX = std::min(q1.x(), q2.x()) - radius;
+		const auto minY = std::min(q1.y(), q2.y()) - radius;
+		const auto maxX = std::max(q1.x(), q2.x()) + radius;
+		const auto maxY = std::max(q1.y(), q2.y()) + radius;
+
+		for (size_t i = 0; i < enabledNos_.size(); ++i)
+		{
+			if (minX_[i] > maxX || maxX_[i] < minX || minY_[i] > maxY || maxY_[i] < minY)
+				continue;
+
+			const auto& obstacle = obstacles_[enabledNos_[i]];
+			const auto end = obstacle.firstSegment + obstacle.vertices.size();
+
+			for (auto segmentNo = obstacle.firstSegment; segmentNo < end; ++segmentNo)
+			{
+				const auto start = segments.getStart(segmentNo);
+				const auto finish = segments.getEnd(segmentNo);
+
+				// Two segments come within the radius when they cross or an endpoint of one lies within the radius of the other
+				const auto q1Side = leftOf(start, finish, q1);
+				const auto q2Side = leftOf(start, finish, q2);
+				const auto startSide = leftOf(q1, q2, start);
+				const auto finishSide = leftOf(q1, q2, finish);
+
+				if (q1Side * q2Side < 0.0f && startSide * finishSide < 0.0f)
+					return false;
+
+				if (distSqPointLineSegment(start, finish, q1) < radiusSq || distSqPointLineSegment(start, finish, q2) < radiusSq ||
+					distSqPointLineSegment(q1, q2, start) < radiusSq || distSqPointLineSegment(q1, q2, finish) < radiusSq)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	/// <summary> Sweeps a circle along the specified displacement against the enabled obstacles whose bounding boxes it may reach </summary>
+	/// <param name="from"> The starting center of the circle </param>
+	/// <param name="displacement"> The displacement of the center </param>
+	/// <param name="radius"> The radius of the circle </param>
+	/// <param name="time"> The fraction of the displacement at the earliest contact so far, lowered when an obstacle is touched before it </param>
+	/// <param name="normal"> The unit normal of the earliest contact, pointing from the obstacle to the circle </param>
+	/// <returns> True if an obstacle is touched before the earliest contact so far </returns>
+	bool DynamicObstacles::querySweep(const Vector2& from, const Vector2& displacement, float radius, float& time, Vector2& normal) const
+	{
+		const auto& segments = *sim_->obstacleSegments_;
+		const auto to = from + displacement;
+		auto hasContact = false;
+
+		const auto minX = std::min(from.x(), to.x()) - radius;
+		const auto minY = std::min(from.y(), to.y()) - radius;
+		const auto maxX = std::max(from.x(), to.x()) + radius;
+		const auto maxY = std::max(from.y(), to.y()) + radius;
+
+		for (size_t i = 0; i < enabledNos_.size(); ++i)
+		{
+			if (minX_[i] > maxX || maxX_[i] < minX || minY_[i] > maxY || maxY_[i] < minY)
+				continue;
+
+			const auto& obstacle = obstacles_[enabledNos_[i]];
+			const auto end = obstacle.firstSegment + obstacle.vertices.size();
+
+			for (auto segmentNo = obstacle.firstSegment; segmentNo < end; ++segmentNo)
+			{
+				if (sweepCircleLineSegment(from, displacement, radius, segments.getStart(segmentNo), segments.getEnd(segmentNo), time, normal))
+					hasContact = true;
+			}
+		}
+
+		return hasContact;
+	}
+}
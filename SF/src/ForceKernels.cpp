@@ -0,0 +1,1844 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "../include/ForceKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SF_X86_KERNELS 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if SF_X86_KERNELS && !defined(_MSC_VER)
+#define SF_TARGET_AVX2 __attribute__((target("avx2")))
+#if defined(__clang__)
+#define SF_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+// GCC would fuse the products and sums of the AVX-512 kernels into FMA instructions, which changes their rounding from the scalar kernels
+#define SF_TARGET_AVX512 __attribute__((target("avx512f"), optimize("fp-contract=off")))
+#endif
+#else
+#define SF_TARGET_AVX2
+#define SF_TARGET_AVX512
+#endif
+
+namespace SF
+{
+	// The count of lanes of the widest kernels, to which the batches are padded
+	static const size_t KERNEL_MAX_WIDTH = 16;
+
+	// The coefficients of the Cephes single precision exponential, accurate to about 2 ulp over the reduced range
+	static const float EXP_MIN_ARGUMENT = -87.0f;
+	static const float EXP_MAX_ARGUMENT = 88.0f;
+	static const float EXP_LOG2E = 1.44269504088896341f;
+	static const float EXP_LN2_HIGH = 0.693359375f;
+	static const float EXP_LN2_LOW = -2.12194440e-4f;
+	static const float EXP_P0 = 1.9875691500e-4f;
+	static const float EXP_P1 = 1.3981999507e-3f;
+	static const float EXP_P2 = 8.3334519073e-3f;
+	static const float EXP_P3 = 4.1665795894e-2f;
+	static const float EXP_P4 = 1.6666665459e-1f;
+	static const float EXP_P5 = 5.0000001201e-1f;
+	static const double EXP_LN2 = 0.693147180559945309;	// ln 2 for the range reduction in double precision
+
+	// The coefficients of the quartic exponential of the fast math mode, fitted for the relative error over the reduced range
+	static const float EXP_FAST_P2 = 5.0005116026e-1f;
+	static const float EXP_FAST_P3 = 1.6753514085e-1f;
+	static const float EXP_FAST_P4 = 4.1277747966e-2f;
+
+	/// <summary> Computes the repulsive force exerted on an agent by its agent neighbors one neighbor at a time </summary>
+	/// <param name="input"> The agent and the state of its neighbors </param>
+	/// <param name="neighbors"> The squared distances and slots of the neighbors </param>
+	/// <param name="count"> The count of neighbors </param>
+	/// <param name="output"> The accumulated force </param>
+	void computeRepulsiveAgentForceScalar(const RepulsiveAgentInput& input, const std::pair<float, size_t>* neighbors, size_t count, RepulsiveAgentOutput& output)
+	{
+		double pressure = 0;
+		auto forceSum = Vector2();
+		auto maxForceLength = FLT_MIN;
+		auto position = input.position;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const auto agentNo = neighbors[i].second;
+			auto pos = input.positions[agentNo];
+
+			if (position == pos)
+				continue;
+
+			auto y = input.velocities[agentNo] * input.speeds[agentNo] * input.timeStep;
+			auto d = position - pos;
+			auto radius = input.speeds[agentNo] * input.timeStep;
+			auto dLength = getLength(d);
+			auto eLength = getLength(d - y);
+			auto b = std::sqrt(static_cast<double>(std::max(0.0f, sqr(dLength + eLength) - sqr(radius)))) / 2;
+			auto potential = input.repulsiveAgent * std::exp(-b / input.repulsiveAgent);
+			auto ratio = (dLength + eLength) / 2 * b;
+			auto sum = (d / dLength + (d - y) / eLength);
+			auto perception = getLength(position) * getLength(pos) * getCos(position, pos) > 0 ? 1.0f : input.perception;
+			auto force = potential * ratio * sum * perception * input.repulsiveAgentFactor;
+
+			auto length = getLength(force);
+			pressure += length;
+
+			if (maxForceLength < length)
+				maxForceLength = length;
+
+			forceSum += force;
+		}
+
+		output.forceSum = forceSum;
+		output.pressure = pressure;
+		output.maxForceLength = maxForceLength;
+	}
+
+	/// <summary> Approximates the exponential of a float with a quartic polynomial, within 6e-6 relative error </summary>
+	/// <param name="x"> The exponent </param>
+	/// <returns> The exponential </returns>
+	static inline float expFast(float x)
+	{
+		x = std::min(std::max(x, EXP_MIN_ARGUMENT), EXP_MAX_ARGUMENT);
+
+		const auto n = static_cast<int>(x * EXP_LOG2E + (x < 0.0f ? -0.5f : 0.5f));
+		const auto fn = static_cast<float>(n);
+
+		x = x - fn * EXP_LN2_HIGH - fn * EXP_LN2_LOW;
+
+		const auto y = ((EXP_FAST_P4 * x + EXP_FAST_P3) * x + EXP_FAST_P2) * x * x + x + 1.0f;
+		const auto bits = static_cast<uint32_t>(n + 127) << 23;
+		float scale;
+		std::memcpy(&scale, &bits, sizeof(scale));
+
+		return y * scale;
+	}
+
+	/// <summary> Computes the repulsive force exerted on an agent by its agent neighbors one neighbor at a time, in single precision with the fast exponential </summary>
+	/// <param name="input"> The agent and the state of its neighbors </param>
+	/// <param name="neighbors"> The squared distances and slots of the neighbors </param>
+	/// <param name="count"> The count of neighbors </param>
+	/// <param name="output"> The accumulated force </param>
+	static void computeRepulsiveAgentForceScalarFast(const RepulsiveAgentInput& input, const std::pair<float, size_t>* neighbors, size_t count, RepulsiveAgentOutput& output)
+	{
+		double pressure = 0;
+		auto forceSum = Vector2();
+		auto maxForceLength = FLT_MIN;
+		const auto position = input.position;
+		const auto inverseRepulsiveAgent = 1.0f / input.repulsiveAgent;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const auto agentNo = neighbors[i].second;
+			const auto pos = input.positions[agentNo];
+
+			if (position == pos)
+				continue;
+
+			const auto radius = input.speeds[agentNo] * input.timeStep;
+			const auto d = position - pos;
+			const auto e = d - input.velocities[agentNo] * radius;
+			const auto dInverse = 1.0f / std::sqrt(absSq(d));
+			const auto eInverse = 1.0f / std::sqrt(absSq(e));
+			const auto lengthSum = absSq(d) * dInverse + absSq(e) * eInverse;
+			const auto b = std::sqrt(std::max(0.0f, lengthSum * lengthSum - radius * radius)) * 0.5f;
+			const auto potential = input.repulsiveAgent * expFast(-b * inverseRepulsiveAgent);
+			const auto ratio = lengthSum * 0.5f * b;
+			const auto perception = position * pos > 0 ? 1.0f : input.perception;
+			const auto force = (d * dInverse + e * eInverse) * (potential * ratio * perception * input.repulsiveAgentFactor);
+
+			const auto length = abs(force);
+			pressure += length;
+
+			if (maxForceLength < length)
+				maxForceLength = length;
+
+			forceSum += force;
+		}
+
+		output.forceSum = forceSum;
+		output.pressure = pressure;
+		output.maxForceLength = maxForceLength;
+	}
+
+	/// <summary> Allocates the buffers for the specified count of segments, padded to a whole count of the widest vectors </summary>
+	/// <param name="arena"> The scratch arena of the calling thread </param>
+	/// <param name="count"> The count of segments </param>
+	void ObstacleSegmentBatch::allocate(ScratchArena& arena, size_t count)
+	{
+		const auto paddedCount = (count + KERNEL_MAX_WIDTH - 1) / KERNEL_MAX_WIDTH * KERNEL_MAX_WIDTH;
+
+		startX = arena.allocate<float>(paddedCount);
+		startY = arena.allocate<float>(paddedCount);
+		endX = arena.allocate<float>(paddedCount);
+		endY = arena.allocate<float>(paddedCount);
+		closestX = arena.allocate<float>(paddedCount);
+		closestY = arena.allocate<float>(paddedCount);
+		pointX = arena.allocate<float>(paddedCount);
+		pointY = arena.allocate<float>(paddedCount);
+		forceX = arena.allocate<float>(paddedCount);
+		forceY = arena.allocate<float>(paddedCount);
+		closestOrder = arena.allocate<std::pair<float, size_t>>(count);
+		closestRank = arena.allocate<size_t>(count);
+		endpointOrder = arena.allocate<std::pair<float, size_t>>(2 * count);
+		isSelected = arena.allocate<char>(count);
+	}
+
+	/// <summary> Selects the closest points exerting the repulsive obstacle force. A closest point is dropped if it coincides with the closest point of a preceding segment, or if it coincides with an endpoint of a segment whose own closest point lies elsewhere </summary>
+	/// <param name="batch"> The segments and their closest points. Receives the selected points </param>
+	/// <param name="count"> The count of segments </param>
+	/// <param name="toleranceSq"> The squared distance under which two points coincide </param>
+	/// <returns> The count of selected points </returns>
+	size_t selectRepulsiveObstaclePoints(ObstacleSegmentBatch& batch, size_t count, double toleranceSq)
+	{
+		typedef std::pair<float, size_t> Key;
+
+		const auto x = batch.closestX;
+		const auto y = batch.closestY;
+		const auto order = batch.closestOrder;
+		const auto endpointOrder = batch.endpointOrder;
+
+		// Two points may only coincide if their x-coordinates do, so each point is only compared with its neighborhood in the x order.
+		// The points of degenerate segments are not a number, never coincide and are sorted last
+		for (size_t i = 0; i < count; ++i)
+			order[i] = Key(x[i], i);
+
+		std::sort(order, order + count, [](const Key& a, const Key& b) { return a.first < b.first || (a.first == a.first && b.first != b.first); });
+
+		for (size_t k = 0; k < count; ++k)
+			batch.closestRank[order[k].second] = k;
+
+		const auto isCoincident = [&](size_t i, size_t j)
+		{
+			return j < i && batch.isSelected[j] && (Vector2(x[j], y[j]) - Vector2(x[i], y[i])).GetLengthSquared() < toleranceSq;
+		};
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto isSelected = true;
+			const auto rank = batch.closestRank[i];
+
+			for (auto k = rank; isSelected && k-- > 0;)
+			{
+				const auto dx = order[k].first - x[i];
+
+				if (!(dx * dx < toleranceSq))
+					break;
+
+				isSelected = !isCoincident(i, order[k].second);
+			}
+
+			for (auto k = rank + 1; isSelected && k < count; ++k)
+			{
+				const auto dx = order[k].first - x[i];
+
+				if (!(dx * dx < toleranceSq))
+					break;
+
+				isSelected = !isCoincident(i, order[k].second);
+			}
+
+			batch.isSelected[i] = isSelected;
+		}
+
+		// A selected point lying on an endpoint of a segment is a corner, which is dropped if that segment is nearer elsewhere
+		for (size_t i = 0; i < count; ++i)
+		{
+			endpointOrder[2 * i] = Key(batch.startX[i], 2 * i);
+			endpointOrder[2 * i + 1] = Key(batch.endX[i], 2 * i + 1);
+		}
+
+		const auto endpointEnd = endpointOrder + 2 * count;
+		std::sort(endpointOrder, endpointEnd, [](const Key& a, const Key& b) { return a.first < b.first; });
+
+		const auto isDroppedCorner = [&](const Vector2& point, size_t e)
+		{
+			const auto segment = e / 2;
+			const auto endpoint = (e % 2 == 0) ? Vector2(batch.startX[segment], batch.startY[segment]) : Vector2(batch.endX[segment], batch.endY[segment]);
+
+			return (point - endpoint).GetLengthSquared() < toleranceSq
+				&& (point - Vector2(x[segment], y[segment])).GetLengthSquared() > toleranceSq;
+		};
+
+		size_t selectedCount = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!batch.isSelected[i])
+				continue;
+
+			const auto point = Vector2(x[i], y[i]);
+			const auto first = static_cast<size_t>(std::lower_bound(endpointOrder, endpointEnd, point.x(), [](const Key& key, float value) { return key.first < value; }) - endpointOrder);
+			auto isSelected = true;
+
+			for (auto k = first; isSelected && k-- > 0;)
+			{
+				const auto dx = endpointOrder[k].first - point.x();
+
+				if (!(dx * dx < toleranceSq))
+					break;
+
+				isSelected = !isDroppedCorner(point, endpointOrder[k].second);
+			}
+
+			for (auto k = first; isSelected && k < 2 * count; ++k)
+			{
+				const auto dx = endpointOrder[k].first - point.x();
+
+				if (!(dx * dx < toleranceSq))
+					break;
+
+				isSelected = !isDroppedCorner(point, endpointOrder[k].second);
+			}
+
+			if (!isSelected)
+				continue;
+
+			batch.pointX[selectedCount] = point.x();
+			batch.pointY[selectedCount] = point.y();
+			++selectedCount;
+		}
+
+		return selectedCount;
+	}
+
+	/// <summary> Computes the points of line segments closest to a point one segment at a time </summary>
+	/// <param name="batch"> The segments. Receives the closest points </param>
+	/// <param name="count"> The count of segments </param>
+	/// <param name="point"> The point </param>
+	void computeClosestPointsScalar(ObstacleSegmentBatch& batch, size_t count, const Vector2& point)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto start = Vector2(batch.startX[i], batch.startY[i]);
+			auto end = Vector2(batch.endX[i], batch.endY[i]);
+			auto relativeEndPoint = end - start;
+			auto relativePoint = point - start;
+			double lambda = relativePoint * relativeEndPoint / relativeEndPoint.GetLengthSquared();
+
+			Vector2 closestPoint;
+
+			if (lambda <= 0)
+				closestPoint = start;
+			else if (lambda >= 1)
+				closestPoint = end;
+			else
+				closestPoint = start + static_cast<float>(lambda) * relativeEndPoint;
+
+			batch.closestX[i] = closestPoint.x();
+			batch.closestY[i] = closestPoint.y();
+		}
+	}
+
+	/// <summary> Computes the repulsive force exerted on an agent by the selected closest points one point at a time. Each force is weighted by its share of the sum of the force lengths </summary>
+	/// <param name="input"> The agent </param>
+	/// <param name="batch"> The selected closest points. Receives the forces </param>
+	/// <param name="count"> The count of selected closest points </param>
+	/// <returns> The weighted sum of the forces </returns>
+	Vector2 computeRepulsiveObstacleForceScalar(const RepulsiveObstacleInput& input, ObstacleSegmentBatch& batch, size_t count)
+	{
+		float lengthSum = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto closestPoint = Vector2(batch.pointX[i], batch.pointY[i]);
+			auto diff = input.position - closestPoint;
+			auto distanceSquared = diff.GetLengthSquared();
+			auto absoluteDistanceToObstacle = sqrt(distanceSquared);
+			auto distance = absoluteDistanceToObstacle - input.radius;
+			auto forceAmount = input.repulsiveObstacleFactor * exp(-distance / input.repulsiveObstacle);
+			auto force = forceAmount * diff.normalized();
+
+			batch.forceX[i] = force.x();
+			batch.forceY[i] = force.y();
+			lengthSum += getLength(force);
+		}
+
+		auto total = Vector2();
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto force = Vector2(batch.forceX[i], batch.forceY[i]);
+			total += force * (getLength(force) / lengthSum);
+		}
+
+		return total;
+	}
+
+	/// <summary> Computes the repulsive force exerted on an agent by the selected closest points one point at a time, in single precision with the fast exponential. Each force is weighted by its share of the sum of the force lengths </summary>
+	/// <param name="input"> The agent </param>
+	/// <param name="batch"> The selected closest points. Receives the forces </param>
+	/// <param name="count"> The count of selected closest points </param>
+	/// <returns> The weighted sum of the forces </returns>
+	static Vector2 computeRepulsiveObstacleForceScalarFast(const RepulsiveObstacleInput& input, ObstacleSegmentBatch& batch, size_t count)
+	{
+		float lengthSum = 0;
+		const auto inverseRepulsiveObstacle = 1.0f / input.repulsiveObstacle;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const auto diff = input.position - Vector2(batch.pointX[i], batch.pointY[i]);
+			const auto distanceSq = absSq(diff);
+			auto force = Vector2();
+
+			if (distanceSq >= FLT_EPSILON * FLT_EPSILON)
+			{
+				const auto inverseDistance = 1.0f / std::sqrt(distanceSq);
+				const auto forceAmount = input.repulsiveObstacleFactor * expFast((input.radius - distanceSq * inverseDistance) * inverseRepulsiveObstacle);
+				force = diff * (forceAmount * inverseDistance);
+			}
+
+			batch.forceX[i] = force.x();
+			batch.forceY[i] = force.y();
+			lengthSum += abs(force);
+		}
+
+		auto total = Vector2();
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const auto force = Vector2(batch.forceX[i], batch.forceY[i]);
+			total += force * (abs(force) / lengthSum);
+		}
+
+		return total;
+	}
+
+	/// <summary> Computes the moving platform forces exerted on a range of agents one agent at a time </summary>
+	/// <param name="input"> The state of the agents and the platform kinematics </param>
+	/// <param name="begin"> The slot of the first agent </param>
+	/// <param name="end"> The slot past the last agent </param>
+	/// <param name="forces"> The forces indexed by agent slot </param>
+	void computeMovingPlatformForcesScalar(const MovingPlatformInput& input, size_t begin, size_t end, Vector2* forces)
+	{
+		const PlatformRoll* rolls[] = { &input.frame->rollX, &input.frame->rollY };
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			const auto x = input.positions[i].x();
+			const auto y = input.positions[i].y();
+			const auto vx = input.velocities[i].x();
+			const auto vy = input.velocities[i].y();
+			auto acceleration = Vector2();
+
+			for (auto roll : rolls)
+			{
+				if (!roll->isRolling)
+					continue;
+
+				const auto& omega = roll->omega;
+				const auto& dOmega = roll->dOmega;
+
+				// The cross products are oriented by the sign of their determinant, the agent lying in the plane z = 0
+				auto prefixX = -(omega.z() * y);
+				auto prefixY = omega.z() * x;
+				auto prefixZ = omega.x() * y - omega.y() * x;
+				const auto prefixSign = prefixX + prefixY + omega.x() * y - omega.y() * x > 0 ? 1.0f : -1.0f;
+				prefixX *= prefixSign;
+				prefixY *= prefixSign;
+				prefixZ *= prefixSign;
+
+				const auto centralSign = omega.y() * prefixZ - omega.z() * prefixY - omega.x() * prefixZ + omega.z() * prefixX + omega.x() * prefixY - omega.y() * prefixX > 0 ? 1.0f : -1.0f;
+				const auto centralX = (omega.y() * prefixZ - omega.z() * prefixY) * centralSign;
+				const auto centralY = (omega.z() * prefixX - omega.x() * prefixZ) * centralSign;
+
+				auto tangentialX = -(dOmega.z() * y);
+				auto tangentialY = dOmega.z() * x;
+				const auto tangentialSign = tangentialX + tangentialY + dOmega.x() * y - dOmega.y() * x > 0 ? 1.0f : -1.0f;
+				tangentialX *= tangentialSign;
+				tangentialY *= tangentialSign;
+
+				auto coriolisX = -(omega.z() * vy);
+				auto coriolisY = omega.z() * vx;
+				const auto coriolisSign = coriolisX + coriolisY + omega.x() * vy - omega.y() * vx > 0 ? 2.0f : -2.0f;
+				coriolisX *= coriolisSign;
+				coriolisY *= coriolisSign;
+
+				acceleration += Vector2(
+					(centralX + tangentialX - coriolisX) / roll->omegaCosX,
+					(centralY + tangentialY - coriolisY) / roll->omegaCosY);
+			}
+
+			forces[i] = (input.velocities[i] + acceleration * input.timeStep) * input.frame->heaveFactor * input.platformFactors[i];
+		}
+	}
+
+#if SF_X86_KERNELS
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC takes the undefined upper lanes that the AVX-512 intrinsics leave on purpose for uninitialized variables of the kernels inlining them
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+	/// <summary> Gathers the state of up to the specified count of neighbors into lanes, padding the missing lanes with the agent itself </summary>
+	/// <param name="input"> The agent and the state of its neighbors </param>
+	/// <param name="neighbors"> The squared distances and slots of the neighbors </param>
+	/// <param name="count"> The count of the remaining neighbors </param>
+	/// <param name="width"> The count of lanes </param>
+	/// <param name="lanes"> The x-coordinates, y-coordinates, velocity x-coordinates, velocity y-coordinates and speeds, each of the lane width </param>
+	static inline void gatherRepulsiveAgentLanes(const RepulsiveAgentInput& input, const std::pair<float, size_t>* neighbors, size_t count, size_t width, float* lanes)
+	{
+		for (size_t lane = 0; lane < width; ++lane)
+		{
+			if (lane < count)
+			{
+				const auto agentNo = neighbors[lane].second;
+
+				lanes[lane] = input.positions[agentNo].x();
+				lanes[width + lane] = input.positions[agentNo].y();
+				lanes[2 * width + lane] = input.velocities[agentNo].x();
+				lanes[3 * width + lane] = input.velocities[agentNo].y();
+				lanes[4 * width + lane] = input.speeds[agentNo];
+			}
+			else
+			{
+				// A lane at the position of the agent is masked out like a coincident neighbor
+				lanes[lane] = input.position.x();
+				lanes[width + lane] = input.position.y();
+				lanes[2 * width + lane] = 0.0f;
+				lanes[3 * width + lane] = 0.0f;
+				lanes[4 * width + lane] = 0.0f;
+			}
+		}
+	}
+
+	/// <summary> Evaluates the exponentials of four floats from their arguments reduced by multiples of ln 2 </summary>
+	/// <param name="x"> The reduced exponents, within ln 2 / 2 of zero </param>
+	/// <param name="n"> The multiples of ln 2 taken from the exponents </param>
+	/// <returns> The exponentials </returns>
+	static inline __m128 expReduced128(__m128 x, __m128i n)
+	{
+		auto y = _mm_set1_ps(EXP_P0);
+		y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P1));
+		y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P2));
+		y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P3));
+		y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P4));
+		y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P5));
+		y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, x), x), x), _mm_set1_ps(1.0f));
+
+		return _mm_mul_ps(y, _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23)));
+	}
+
+	/// <summary> Computes the exponential of four floats </summary>
+	/// <param name="x"> The exponents </param>
+	/// <returns> The exponentials </returns>
+	static inline __m128 exp128(__m128 x)
+	{
+		x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(EXP_MIN_ARGUMENT)), _mm_set1_ps(EXP_MAX_ARGUMENT));
+
+		const auto n = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(EXP_LOG2E)));
+		const auto fn = _mm_cvtepi32_ps(n);
+
+		x = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(fn, _mm_set1_ps(EXP_LN2_HIGH))), _mm_mul_ps(fn, _mm_set1_ps(EXP_LN2_LOW)));
+
+		return expReduced128(x, n);
+	}
+
+	/// <summary> Approximates the exponential of four floats with a quartic polynomial, within 6e-6 relative error </summary>
+	/// <param name="x"> The exponents </param>
+	/// <returns> The exponentials </returns>
+	static inline __m128 expFast128(__m128 x)
+	{
+		x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(EXP_MIN_ARGUMENT)), _mm_set1_ps(EXP_MAX_ARGUMENT));
+
+		const auto n = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(EXP_LOG2E)));
+		const auto fn = _mm_cvtepi32_ps(n);
+
+		x = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(fn, _mm_set1_ps(EXP_LN2_HIGH))), _mm_mul_ps(fn, _mm_set1_ps(EXP_LN2_LOW)));
+
+		auto y = _mm_set1_ps(EXP_FAST_P4);
+		y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_FAST_P3));
+		y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_FAST_P2));
+		y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, x), x), x), _mm_set1_ps(1.0f));
+
+		return _mm_mul_ps(y, _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23)));
+	}
+
+	/// <summary> Computes the inverse square roots of four floats, refining the hardware estimate with a Newton step in the fast math mode </summary>
+	/// <param name="x"> The positive values </param>
+	/// <returns> The inverse square roots </returns>
+	template <bool IS_FAST>
+	static inline __m128 inverseSqrt128(__m128 x)
+	{
+		if (!IS_FAST)
+			return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(x));
+
+		const auto estimate = _mm_rsqrt_ps(x);
+
+		return _mm_mul_ps(estimate, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), x), _mm_mul_ps(estimate, estimate))));
+	}
+
+	/// <summary> Computes the lengths of four vectors in double precision, rounded once to float like the scalar kernel </summary>
+	/// <param name="x"> The x-coordinates </param>
+	/// <param name="y"> The y-coordinates </param>
+	/// <returns> The lengths </returns>
+	static inline __m128 length128(__m128 x, __m128 y)
+	{
+		const auto xLow = _mm_cvtps_pd(x);
+		const auto yLow = _mm_cvtps_pd(y);
+		const auto xHigh = _mm_cvtps_pd(_mm_movehl_ps(x, x));
+		const auto yHigh = _mm_cvtps_pd(_mm_movehl_ps(y, y));
+		const auto low = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(xLow, xLow), _mm_mul_pd(yLow, yLow)));
+		const auto high = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(xHigh, xHigh), _mm_mul_pd(yHigh, yHigh)));
+
+		return _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+	}
+
+	/// <summary> Computes the repulsive agent potentials of four neighbors. The semi-minor axes and the reduced exponents are computed in double precision like the scalar kernel, since the exponential magnifies the rounding of its argument </summary>
+	/// <param name="axisSq"> The squared semi-minor axes, times four </param>
+	/// <param name="repulsiveAgent"> The repulsive exponential agent coefficient </param>
+	/// <param name="b"> Receives the semi-minor axes </param>
+	/// <returns> The potentials </returns>
+	static inline __m128 repulsiveAgentPotential128(__m128 axisSq, float repulsiveAgent, __m128& b)
+	{
+		const auto half = _mm_set1_pd(0.5);
+		const auto minimum = _mm_set1_pd(EXP_MIN_ARGUMENT);
+		const auto coefficient = _mm_set1_pd(-1.0 / repulsiveAgent);
+		const auto bLow = _mm_mul_pd(_mm_sqrt_pd(_mm_cvtps_pd(axisSq)), half);
+		const auto bHigh = _mm_mul_pd(_mm_sqrt_pd(_mm_cvtps_pd(_mm_movehl_ps(axisSq, axisSq))), half);
+		const auto xLow = _mm_max_pd(_mm_mul_pd(bLow, coefficient), minimum);
+		const auto xHigh = _mm_max_pd(_mm_mul_pd(bHigh, coefficient), minimum);
+		const auto nLow = _mm_cvtpd_epi32(_mm_mul_pd(xLow, _mm_set1_pd(EXP_LOG2E)));
+		const auto nHigh = _mm_cvtpd_epi32(_mm_mul_pd(xHigh, _mm_set1_pd(EXP_LOG2E)));
+		const auto rLow = _mm_sub_pd(xLow, _mm_mul_pd(_mm_cvtepi32_pd(nLow), _mm_set1_pd(EXP_LN2)));
+		const auto rHigh = _mm_sub_pd(xHigh, _mm_mul_pd(_mm_cvtepi32_pd(nHigh), _mm_set1_pd(EXP_LN2)));
+
+		b = _mm_movelh_ps(_mm_cvtpd_ps(bLow), _mm_cvtpd_ps(bHigh));
+
+		return _mm_mul_ps(_mm_set1_ps(repulsiveAgent), expReduced128(_mm_movelh_ps(_mm_cvtpd_ps(rLow), _mm_cvtpd_ps(rHigh)), _mm_unpacklo_epi64(nLow, nHigh)));
+	}
+
+	/// <summary> Computes the repulsive force exerted on an agent by its agent neighbors four neighbors at a time with SSE2 </summary>
+	/// <param name="input"> The agent and the state of its neighbors </param>
+	/// <param name="neighbors"> The squared distances and slots of the neighbors </param>
+	/// <param name="count"> The count of neighbors </param>
+	/// <param name="output"> The accumulated force </param>
+	template <bool IS_FAST>
+	static void computeRepulsiveAgentForceSse2(const RepulsiveAgentInput& input, const std::pair<float, size_t>* neighbors, size_t count, RepulsiveAgentOutput& output)
+	{
+		const size_t width = 4;
+		alignas(16) float lanes[5 * width];
+
+		const auto positionX = _mm_set1_ps(input.position.x());
+		const auto positionY = _mm_set1_ps(input.position.y());
+		const auto timeStep = _mm_set1_ps(input.timeStep);
+		const auto repulsiveAgent = _mm_set1_ps(input.repulsiveAgent);
+		const auto inverseRepulsiveAgent = _mm_set1_ps(1.0f / input.repulsiveAgent);
+		const auto factor = _mm_set1_ps(input.repulsiveAgentFactor);
+		const auto perception = _mm_set1_ps(input.perception);
+		const auto zero = _mm_setzero_ps();
+		const auto one = _mm_set1_ps(1.0f);
+		const auto half = _mm_set1_ps(0.5f);
+		const auto epsilon = _mm_set1_ps(FLT_EPSILON);
+		const auto signMask = _mm_set1_ps(-0.0f);
+
+		auto sumX = zero;
+		auto sumY = zero;
+		auto sumLength = zero;
+		auto maxLength = zero;
+
+		for (size_t i = 0; i < count; i += width)
+		{
+			gatherRepulsiveAgentLanes(input, neighbors + i, count - i, width, lanes);
+
+			const auto x = _mm_load_ps(lanes);
+			const auto y = _mm_load_ps(lanes + width);
+			const auto speed = _mm_load_ps(lanes + 4 * width);
+			const auto radius = _mm_mul_ps(speed, timeStep);
+			const auto shiftX = _mm_mul_ps(_mm_mul_ps(_mm_load_ps(lanes + 2 * width), speed), timeStep);
+			const auto shiftY = _mm_mul_ps(_mm_mul_ps(_mm_load_ps(lanes + 3 * width), speed), timeStep);
+
+			const auto dX = _mm_sub_ps(positionX, x);
+			const auto dY = _mm_sub_ps(positionY, y);
+			const auto eX = _mm_sub_ps(dX, shiftX);
+			const auto eY = _mm_sub_ps(dY, shiftY);
+			const auto dLengthSq = _mm_add_ps(_mm_mul_ps(dX, dX), _mm_mul_ps(dY, dY));
+			const auto eLengthSq = _mm_add_ps(_mm_mul_ps(eX, eX), _mm_mul_ps(eY, eY));
+			const auto dLength = IS_FAST ? zero : length128(dX, dY);
+			const auto eLength = IS_FAST ? zero : length128(eX, eY);
+			const auto dInverse = IS_FAST ? inverseSqrt128<true>(dLengthSq) : _mm_div_ps(one, dLength);
+			const auto eInverse = IS_FAST ? inverseSqrt128<true>(eLengthSq) : _mm_div_ps(one, eLength);
+			const auto lengthSum = IS_FAST ? _mm_add_ps(_mm_mul_ps(dLengthSq, dInverse), _mm_mul_ps(eLengthSq, eInverse)) : _mm_add_ps(dLength, eLength);
+
+			const auto axisSq = _mm_max_ps(zero, _mm_sub_ps(_mm_mul_ps(lengthSum, lengthSum), _mm_mul_ps(radius, radius)));
+			auto b = _mm_mul_ps(_mm_sqrt_ps(axisSq), half);
+			const auto potential = IS_FAST ? _mm_mul_ps(repulsiveAgent, expFast128(_mm_mul_ps(_mm_sub_ps(zero, b), inverseRepulsiveAgent))) : repulsiveAgentPotential128(axisSq, input.repulsiveAgent, b);
+			const auto ratio = _mm_mul_ps(_mm_mul_ps(lengthSum, half), b);
+
+			const auto isAhead = _mm_cmpgt_ps(_mm_add_ps(_mm_mul_ps(positionX, x), _mm_mul_ps(positionY, y)), zero);
+			const auto weight = _mm_or_ps(_mm_and_ps(isAhead, one), _mm_andnot_ps(isAhead, perception));
+			const auto isApart = _mm_or_ps(_mm_cmpge_ps(_mm_andnot_ps(signMask, dX), epsilon), _mm_cmpge_ps(_mm_andnot_ps(signMask, dY), epsilon));
+			const auto coefficient = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(potential, ratio), weight), factor);
+
+			const auto forceX = _mm_and_ps(isApart, _mm_mul_ps(coefficient, _mm_add_ps(_mm_mul_ps(dX, dInverse), _mm_mul_ps(eX, eInverse))));
+			const auto forceY = _mm_and_ps(isApart, _mm_mul_ps(coefficient, _mm_add_ps(_mm_mul_ps(dY, dInverse), _mm_mul_ps(eY, eInverse))));
+			const auto length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(forceX, forceX), _mm_mul_ps(forceY, forceY)));
+
+			sumX = _mm_add_ps(sumX, forceX);
+			sumY = _mm_add_ps(sumY, forceY);
+			sumLength = _mm_add_ps(sumLength, length);
+			maxLength = _mm_max_ps(maxLength, length);
+		}
+
+		alignas(16) float sums[4 * width];
+		_mm_store_ps(sums, sumX);
+		_mm_store_ps(sums + width, sumY);
+		_mm_store_ps(sums + 2 * width, sumLength);
+		_mm_store_ps(sums + 3 * width, maxLength);
+
+		output.forceSum = Vector2();
+		output.pressure = 0;
+		output.maxForceLength = FLT_MIN;
+
+		for (size_t lane = 0; lane < width; ++lane)
+		{
+			output.forceSum += Vector2(sums[lane], sums[width + lane]);
+			output.pressure += sums[2 * width + lane];
+			output.maxForceLength = std::max(output.maxForceLength, sums[3 * width + lane]);
+		}
+	}
+
+	/// <summary> Evaluates the exponentials of eight floats from their arguments reduced by multiples of ln 2 </summary>
+	/// <param name="x"> The reduced exponents, within ln 2 / 2 of zero </param>
+	/// <param name="n"> The multiples of ln 2 taken from the exponents </param>
+	/// <returns> The exponentials </returns>
+	SF_TARGET_AVX2 static inline __m256 expReduced256(__m256 x, __m256i n)
+	{
+		auto y = _mm256_set1_ps(EXP_P0);
+		y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P1));
+		y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P2));
+		y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P3));
+		y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P4));
+		y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P5));
+		y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(y, x), x), x), _mm256_set1_ps(1.0f));
+
+		return _mm256_mul_ps(y, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23)));
+	}
+
+	/// <summary> Computes the exponential of eight floats </summary>
+	/// <param name="x"> The exponents </param>
+	/// <returns> The exponentials </returns>
+	SF_TARGET_AVX2 static inline __m256 exp256(__m256 x)
+	{
+		x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(EXP_MIN_ARGUMENT)), _mm256_set1_ps(EXP_MAX_ARGUMENT));
+
+		const auto n = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(EXP_LOG2E)));
+		const auto fn = _mm256_cvtepi32_ps(n);
+
+		x = _mm256_sub_ps(_mm256_sub_ps(x, _mm256_mul_ps(fn, _mm256_set1_ps(EXP_LN2_HIGH))), _mm256_mul_ps(fn, _mm256_set1_ps(EXP_LN2_LOW)));
+
+		return expReduced256(x, n);
+	}
+
+	/// <summary> Approximates the exponential of eight floats with a quartic polynomial, within 6e-6 relative error </summary>
+	/// <param name="x"> The exponents </param>
+	/// <returns> The exponentials </returns>
+	SF_TARGET_AVX2 static inline __m256 expFast256(__m256 x)
+	{
+		x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(EXP_MIN_ARGUMENT)), _mm256_set1_ps(EXP_MAX_ARGUMENT));
+
+		const auto n = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(EXP_LOG2E)));
+		const auto fn = _mm256_cvtepi32_ps(n);
+
+		x = _mm256_sub_ps(_mm256_sub_ps(x, _mm256_mul_ps(fn, _mm256_set1_ps(EXP_LN2_HIGH))), _mm256_mul_ps(fn, _mm256_set1_ps(EXP_LN2_LOW)));
+
+		auto y = _mm256_set1_ps(EXP_FAST_P4);
+		y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_FAST_P3));
+		y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_FAST_P2));
+		y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(y, x), x), x), _mm256_set1_ps(1.0f));
+
+		return _mm256_mul_ps(y, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23)));
+	}
+
+	/// <summary> Computes the inverse square roots of eight floats, refining the hardware estimate with a Newton step in the fast math mode </summary>
+	/// <param name="x"> The positive values </param>
+	/// <returns> The inverse square roots </returns>
+	template <bool IS_FAST>
+	SF_TARGET_AVX2 static inline __m256 inverseSqrt256(__m256 x)
+	{
+		if (!IS_FAST)
+			return _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(x));
+
+		const auto estimate = _mm256_rsqrt_ps(x);
+
+		return _mm256_mul_ps(estimate, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), x), _mm256_mul_ps(estimate, estimate))));
+	}
+
+	/// <summary> Computes the lengths of eight vectors in double precision, rounded once to float like the scalar kernel </summary>
+	/// <param name="x"> The x-coordinates </param>
+	/// <param name="y"> The y-coordinates </param>
+	/// <returns> The lengths </returns>
+	SF_TARGET_AVX2 static inline __m256 length256(__m256 x, __m256 y)
+	{
+		const auto xLow = _mm256_cvtps_pd(_mm256_castps256_ps128(x));
+		const auto yLow = _mm256_cvtps_pd(_mm256_castps256_ps128(y));
+		const auto xHigh = _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1));
+		const auto yHigh = _mm256_cvtps_pd(_mm256_extractf128_ps(y, 1));
+		const auto low = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(xLow, xLow), _mm256_mul_pd(yLow, yLow)));
+		const auto high = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(xHigh, xHigh), _mm256_mul_pd(yHigh, yHigh)));
+
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(low)), _mm256_cvtpd_ps(high), 1);
+	}
+
+	/// <summary> Computes the repulsive agent potentials of eight neighbors. The semi-minor axes and the reduced exponents are computed in double precision like the scalar kernel, since the exponential magnifies the rounding of its argument </summary>
+	/// <param name="axisSq"> The squared semi-minor axes, times four </param>
+	/// <param name="repulsiveAgent"> The repulsive exponential agent coefficient </param>
+	/// <param name="b"> Receives the semi-minor axes </param>
+	/// <returns> The potentials </returns>
+	SF_TARGET_AVX2 static inline __m256 repulsiveAgentPotential256(__m256 axisSq, float repulsiveAgent, __m256& b)
+	{
+		const auto half = _mm256_set1_pd(0.5);
+		const auto minimum = _mm256_set1_pd(EXP_MIN_ARGUMENT);
+		const auto coefficient = _mm256_set1_pd(-1.0 / repulsiveAgent);
+		const auto bLow = _mm256_mul_pd(_mm256_sqrt_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(axisSq))), half);
+		const auto bHigh = _mm256_mul_pd(_mm256_sqrt_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(axisSq, 1))), half);
+		const auto xLow = _mm256_max_pd(_mm256_mul_pd(bLow, coefficient), minimum);
+		const auto xHigh = _mm256_max_pd(_mm256_mul_pd(bHigh, coefficient), minimum);
+		const auto nLow = _mm256_cvtpd_epi32(_mm256_mul_pd(xLow, _mm256_set1_pd(EXP_LOG2E)));
+		const auto nHigh = _mm256_cvtpd_epi32(_mm256_mul_pd(xHigh, _mm256_set1_pd(EXP_LOG2E)));
+		const auto rLow = _mm256_sub_pd(xLow, _mm256_mul_pd(_mm256_cvtepi32_pd(nLow), _mm256_set1_pd(EXP_LN2)));
+		const auto rHigh = _mm256_sub_pd(xHigh, _mm256_mul_pd(_mm256_cvtepi32_pd(nHigh), _mm256_set1_pd(EXP_LN2)));
+
+		b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(bLow)), _mm256_cvtpd_ps(bHigh), 1);
+
+		const auto r = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(rLow)), _mm256_cvtpd_ps(rHigh), 1);
+		const auto n = _mm256_inserti128_si256(_mm256_castsi128_si256(nLow), nHigh, 1);
+
+		return _mm256_mul_ps(_mm256_set1_ps(repulsiveAgent), expReduced256(r, n));
+	}
+
+	/// <summary> Computes the repulsive force exerted on an agent by its agent neighbors eight neighbors at a time with AVX2 </summary>
+	/// <param name="input"> The agent and the state of its neighbors </param>
+	/// <param name="neighbors"> The squared distances and slots of the neighbors </param>
+	/// <param name="count"> The count of neighbors </param>
+	/// <param name="output"> The accumulated force </param>
+	template <bool IS_FAST>
+	SF_TARGET_AVX2 static void computeRepulsiveAgentForceAvx2(const RepulsiveAgentInput& input, const std::pair<float, size_t>* neighbors, size_t count, RepulsiveAgentOutput& output)
+	{
+		const size_t width = 8;
+		alignas(32) float lanes[5 * width];
+
+		const auto positionX = _mm256_set1_ps(input.position.x());
+		const auto positionY = _mm256_set1_ps(input.position.y());
+		const auto timeStep = _mm256_set1_ps(input.timeStep);
+		const auto repulsiveAgent = _mm256_set1_ps(input.repulsiveAgent);
+		const auto inverseRepulsiveAgent = _mm256_set1_ps(1.0f / input.repulsiveAgent);
+		const auto factor = _mm256_set1_ps(input.repulsiveAgentFactor);
+		const auto perception = _mm256_set1_ps(input.perception);
+		const auto zero = _mm256_setzero_ps();
+		const auto one = _mm256_set1_ps(1.0f);
+		const auto half = _mm256_set1_ps(0.5f);
+		const auto epsilon = _mm256_set1_ps(FLT_EPSILON);
+		const auto signMask = _mm256_set1_ps(-0.0f);
+
+		auto sumX = zero;
+		auto sumY = zero;
+		auto sumLength = zero;
+		auto maxLength = zero;
+
+		for (size_t i = 0; i < count; i += width)
+		{
+			gatherRepulsiveAgentLanes(input, neighbors + i, count - i, width, lanes);
+
+			const auto x = _mm256_load_ps(lanes);
+			const auto y = _mm256_load_ps(lanes + width);
+			const auto speed = _mm256_load_ps(lanes + 4 * width);
+			const auto radius = _mm256_mul_ps(speed, timeStep);
+			const auto shiftX = _mm256_mul_ps(_mm256_mul_ps(_mm256_load_ps(lanes + 2 * width), speed), timeStep);
+			const auto shiftY = _mm256_mul_ps(_mm256_mul_ps(_mm256_load_ps(lanes + 3 * width), speed), timeStep);
+
+			const auto dX = _mm256_sub_ps(positionX, x);
+			const auto dY = _mm256_sub_ps(positionY, y);
+			const auto eX = _mm256_sub_ps(dX, shiftX);
+			const auto eY = _mm256_sub_ps(dY, shiftY);
+			const auto dLengthSq = _mm256_add_ps(_mm256_mul_ps(dX, dX), _mm256_mul_ps(dY, dY));
+			const auto eLengthSq = _mm256_add_ps(_mm256_mul_ps(eX, eX), _mm256_mul_ps(eY, eY));
+			const auto dLength = IS_FAST ? zero : length256(dX, dY);
+			const auto eLength = IS_FAST ? zero : length256(eX, eY);
+			const auto dInverse = IS_FAST ? inverseSqrt256<true>(dLengthSq) : _mm256_div_ps(one, dLength);
+			const auto eInverse = IS_FAST ? inverseSqrt256<true>(eLengthSq) : _mm256_div_ps(one, eLength);
+			const auto lengthSum = IS_FAST ? _mm256_add_ps(_mm256_mul_ps(dLengthSq, dInverse), _mm256_mul_ps(eLengthSq, eInverse)) : _mm256_add_ps(dLength, eLength);
+
+			const auto axisSq = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_mul_ps(lengthSum, lengthSum), _mm256_mul_ps(radius, radius)));
+			auto b = _mm256_mul_ps(_mm256_sqrt_ps(axisSq), half);
+			const auto potential = IS_FAST ? _mm256_mul_ps(repulsiveAgent, expFast256(_mm256_mul_ps(_mm256_sub_ps(zero, b), inverseRepulsiveAgent))) : repulsiveAgentPotential256(axisSq, input.repulsiveAgent, b);
+			const auto ratio = _mm256_mul_ps(_mm256_mul_ps(lengthSum, half), b);
+
+			const auto isAhead = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(positionX, x), _mm256_mul_ps(positionY, y)), zero, _CMP_GT_OQ);
+			const auto weight = _mm256_blendv_ps(perception, one, isAhead);
+			const auto isApart = _mm256_or_ps(_mm256_cmp_ps(_mm256_andnot_ps(signMask, dX), epsilon, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_andnot_ps(signMask, dY), epsilon, _CMP_GE_OQ));
+			const auto coefficient = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(potential, ratio), weight), factor);
+
+			const auto forceX = _mm256_and_ps(isApart, _mm256_mul_ps(coefficient, _mm256_add_ps(_mm256_mul_ps(dX, dInverse), _mm256_mul_ps(eX, eInverse))));
+			const auto forceY = _mm256_and_ps(isApart, _mm256_mul_ps(coefficient, _mm256_add_ps(_mm256_mul_ps(dY, dInverse), _mm256_mul_ps(eY, eInverse))));
+			const auto length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(forceX, forceX), _mm256_mul_ps(forceY, forceY)));
+
+			sumX = _mm256_add_ps(sumX, forceX);
+			sumY = _mm256_add_ps(sumY, forceY);
+			sumLength = _mm256_add_ps(sumLength, length);
+			maxLength = _mm256_max_ps(maxLength, length);
+		}
+
+		alignas(32) float sums[4 * width];
+		_mm256_store_ps(sums, sumX);
+		_mm256_store_ps(sums + width, sumY);
+		_mm256_store_ps(sums + 2 * width, sumLength);
+		_mm256_store_ps(sums + 3 * width, maxLength);
+
+		output.forceSum = Vector2();
+		output.pressure = 0;
+		output.maxForceLength = FLT_MIN;
+
+		for (size_t lane = 0; lane < width; ++lane)
+		{
+			output.forceSum += Vector2(sums[lane], sums[width + lane]);
+			output.pressure += sums[2 * width + lane];
+			output.maxForceLength = std::max(output.maxForceLength, sums[3 * width + lane]);
+		}
+	}
+
+	/// <summary> Evaluates the exponentials of sixteen floats from their arguments reduced by multiples of ln 2 </summary>
+	/// <param name="x"> The reduced exponents, within ln 2 / 2 of zero </param>
+	/// <param name="n"> The multiples of ln 2 taken from the exponents </param>
+	/// <returns> The exponentials </returns>
+	SF_TARGET_AVX512 static inline __m512 expReduced512(__m512 x, __m512i n)
+	{
+		auto y = _mm512_set1_ps(EXP_P0);
+		y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(EXP_P1));
+		y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(EXP_P2));
+		y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(EXP_P3));
+		y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(EXP_P4));
+		y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(EXP_P5));
+		y = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(_mm512_mul_ps(y, x), x), x), _mm512_set1_ps(1.0f));
+
+		return _mm512_mul_ps(y, _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(n, _mm512_set1_epi32(127)), 23)));
+	}
+
+	/// <summary> Computes the exponential of sixteen floats </summary>
+	/// <param name="x"> The exponents </param>
+	/// <returns> The exponentials </returns>
+	SF_TARGET_AVX512 static inline __m512 exp512(__m512 x)
+	{
+		x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(EXP_MIN_ARGUMENT)), _mm512_set1_ps(EXP_MAX_ARGUMENT));
+
+		const auto n = _mm512_cvtps_epi32(_mm512_mul_ps(x, _mm512_set1_ps(EXP_LOG2E)));
+		const auto fn = _mm512_cvtepi32_ps(n);
+
+		x = _mm512_sub_ps(_mm512_sub_ps(x, _mm512_mul_ps(fn, _mm512_set1_ps(EXP_LN2_HIGH))), _mm512_mul_ps(fn, _mm512_set1_ps(EXP_LN2_LOW)));
+
+		return expReduced512(x, n);
+	}
+
+	/// <summary> Approximates the exponential of sixteen floats with a quartic polynomial, within 6e-6 relative error </summary>
+	/// <param name="x"> The exponents </param>
+	/// <returns> The exponentials </returns>
+	SF_TARGET_AVX512 static inline __m512 expFast512(__m512 x)
+	{
+		x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(EXP_MIN_ARGUMENT)), _mm512_set1_ps(EXP_MAX_ARGUMENT));
+
+		const auto n = _mm512_cvtps_epi32(_mm512_mul_ps(x, _mm512_set1_ps(EXP_LOG2E)));
+		const auto fn = _mm512_cvtepi32_ps(n);
+
+		x = _mm512_sub_ps(_mm512_sub_ps(x, _mm512_mul_ps(fn, _mm512_set1_ps(EXP_LN2_HIGH))), _mm512_mul_ps(fn, _mm512_set1_ps(EXP_LN2_LOW)));
+
+		auto y = _mm512_set1_ps(EXP_FAST_P4);
+		y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(EXP_FAST_P3));
+		y = _mm512_add_ps(_mm512_mul_ps(y, x), _mm512_set1_ps(EXP_FAST_P2));
+		y = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(_mm512_mul_ps(y, x), x), x), _mm512_set1_ps(1.0f));
+
+		return _mm512_mul_ps(y, _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(n, _mm512_set1_epi32(127)), 23)));
+	}
+
+	/// <summary> Computes the inverse square roots of sixteen floats, refining the hardware estimate with a Newton step in the fast math mode </summary>
+	/// <param name="x"> The positive values </param>
+	/// <returns> The inverse square roots </returns>
+	template <bool IS_FAST>
+	SF_TARGET_AVX512 static inline __m512 inverseSqrt512(__m512 x)
+	{
+		if (!IS_FAST)
+			return _mm512_div_ps(_mm512_set1_ps(1.0f), _mm512_sqrt_ps(x));
+
+		const auto estimate = _mm512_rsqrt14_ps(x);
+
+		return _mm512_mul_ps(estimate, _mm512_sub_ps(_mm512_set1_ps(1.5f), _mm512_mul_ps(_mm512_mul_ps(_mm512_set1_ps(0.5f), x), _mm512_mul_ps(estimate, estimate))));
+	}
+
+	/// <summary> Computes the lengths of sixteen vectors in double precision, rounded once to float like the scalar kernel </summary>
+	/// <param name="x"> The x-coordinates </param>
+	/// <param name="y"> The y-coordinates </param>
+	/// <returns> The lengths </returns>
+	SF_TARGET_AVX512 static inline __m512 length512(__m512 x, __m512 y)
+	{
+		const auto xLow = _mm512_cvtps_pd(_mm512_castps512_ps256(x));
+		const auto yLow = _mm512_cvtps_pd(_mm512_castps512_ps256(y));
+		const auto xHigh = _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(x), 1)));
+		const auto yHigh = _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(y), 1)));
+		const auto low = _mm512_sqrt_pd(_mm512_add_pd(_mm512_mul_pd(xLow, xLow), _mm512_mul_pd(yLow, yLow)));
+		const auto high = _mm512_sqrt_pd(_mm512_add_pd(_mm512_mul_pd(xHigh, xHigh), _mm512_mul_pd(yHigh, yHigh)));
+
+		return _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castps_pd(_mm512_castps256_ps512(_mm512_cvtpd_ps(low))), _mm256_castps_pd(_mm512_cvtpd_ps(high)), 1));
+	}
+
+	/// <summary> Computes the repulsive agent potentials of sixteen neighbors. The semi-minor axes and the reduced exponents are computed in double precision like the scalar kernel, since the exponential magnifies the rounding of its argument </summary>
+	/// <param name="axisSq"> The squared semi-minor axes, times four </param>
+	/// <param name="repulsiveAgent"> The repulsive exponential agent coefficient </param>
+	/// <param name="b"> Receives the semi-minor axes </param>
+	/// <returns> The potentials </returns>
+	SF_TARGET_AVX512 static inline __m512 repulsiveAgentPotential512(__m512 axisSq, float repulsiveAgent, __m512& b)
+	{
+		const auto half = _mm512_set1_pd(0.5);
+		const auto minimum = _mm512_set1_pd(EXP_MIN_ARGUMENT);
+		const auto coefficient = _mm512_set1_pd(-1.0 / repulsiveAgent);
+		const auto bLow = _mm512_mul_pd(_mm512_sqrt_pd(_mm512_cvtps_pd(_mm512_castps512_ps256(axisSq))), half);
+		const auto bHigh = _mm512_mul_pd(_mm512_sqrt_pd(_mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(axisSq), 1)))), half);
+		const auto xLow = _mm512_max_pd(_mm512_mul_pd(bLow, coefficient), minimum);
+		const auto xHigh = _mm512_max_pd(_mm512_mul_pd(bHigh, coefficient), minimum);
+		const auto nLow = _mm512_cvtpd_epi32(_mm512_mul_pd(xLow, _mm512_set1_pd(EXP_LOG2E)));
+		const auto nHigh = _mm512_cvtpd_epi32(_mm512_mul_pd(xHigh, _mm512_set1_pd(EXP_LOG2E)));
+		const auto rLow = _mm512_sub_pd(xLow, _mm512_mul_pd(_mm512_cvtepi32_pd(nLow), _mm512_set1_pd(EXP_LN2)));
+		const auto rHigh = _mm512_sub_pd(xHigh, _mm512_mul_pd(_mm512_cvtepi32_pd(nHigh), _mm512_set1_pd(EXP_LN2)));
+
+		b = _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castps_pd(_mm512_castps256_ps512(_mm512_cvtpd_ps(bLow))), _mm256_castps_pd(_mm512_cvtpd_ps(bHigh)), 1));
+
+		const auto r = _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castps_pd(_mm512_castps256_ps512(_mm512_cvtpd_ps(rLow))), _mm256_castps_pd(_mm512_cvtpd_ps(rHigh)), 1));
+		const auto n = _mm512_inserti64x4(_mm512_castsi256_si512(nLow), nHigh, 1);
+
+		return _mm512_mul_ps(_mm512_set1_ps(repulsiveAgent), expReduced512(r, n));
+	}
+
+	/// <summary> Computes the repulsive force exerted on an agent by its agent neighbors sixteen neighbors at a time with AVX-512 </summary>
+	/// <param name="input"> The agent and the state of its neighbors </param>
+	/// <param name="neighbors"> The squared distances and slots of the neighbors </param>
+	/// <param name="count"> The count of neighbors </param>
+	/// <param name="output"> The accumulated force </param>
+	template <bool IS_FAST>
+	SF_TARGET_AVX512 static void computeRepulsiveAgentForceAvx512(const RepulsiveAgentInput& input, const std::pair<float, size_t>* neighbors, size_t count, RepulsiveAgentOutput& output)
+	{
+		const size_t width = 16;
+		alignas(64) float lanes[5 * width];
+
+		const auto positionX = _mm512_set1_ps(input.position.x());
+		const auto positionY = _mm512_set1_ps(input.position.y());
+		const auto timeStep = _mm512_set1_ps(input.timeStep);
+		const auto repulsiveAgent = _mm512_set1_ps(input.repulsiveAgent);
+		const auto inverseRepulsiveAgent = _mm512_set1_ps(1.0f / input.repulsiveAgent);
+		const auto factor = _mm512_set1_ps(input.repulsiveAgentFactor);
+		const auto perception = _mm512_set1_ps(input.perception);
+		const auto zero = _mm512_setzero_ps();
+		const auto one = _mm512_set1_ps(1.0f);
+		const auto half = _mm512_set1_ps(0.5f);
+		const auto epsilon = _mm512_set1_ps(FLT_EPSILON);
+
+		auto sumX = zero;
+		auto sumY = zero;
+		auto sumLength = zero;
+		auto maxLength = zero;
+
+		for (size_t i = 0; i < count; i += width)
+		{
+			gatherRepulsiveAgentLanes(input, neighbors + i, count - i, width, lanes);
+
+			const auto x = _mm512_load_ps(lanes);
+			const auto y = _mm512_load_ps(lanes + width);
+			const auto speed = _mm512_load_ps(lanes + 4 * width);
+			const auto radius = _mm512_mul_ps(speed, timeStep);
+			const auto shiftX = _mm512_mul_ps(_mm512_mul_ps(_mm512_load_ps(lanes + 2 * width), speed), timeStep);
+			const auto shiftY = _mm512_mul_ps(_mm512_mul_ps(_mm512_load_ps(lanes + 3 * width), speed), timeStep);
+
+			const auto dX = _mm512_sub_ps(positionX, x);
+			const auto dY = _mm512_sub_ps(positionY, y);
+			const auto eX = _mm512_sub_ps(dX, shiftX);
+			const auto eY = _mm512_sub_ps(dY, shiftY);
+			const auto dLengthSq = _mm512_add_ps(_mm512_mul_ps(dX, dX), _mm512_mul_ps(dY, dY));
+			const auto eLengthSq = _mm512_add_ps(_mm512_mul_ps(eX, eX), _mm512_mul_ps(eY, eY));
+			const auto dLength = IS_FAST ? zero : length512(dX, dY);
+			const auto eLength = IS_FAST ? zero : length512(eX, eY);
+			const auto dInverse = IS_FAST ? inverseSqrt512<true>(dLengthSq) : _mm512_div_ps(one, dLength);
+			const auto eInverse = IS_FAST ? inverseSqrt512<true>(eLengthSq) : _mm512_div_ps(one, eLength);
+			const auto lengthSum = IS_FAST ? _mm512_add_ps(_mm512_mul_ps(dLengthSq, dInverse), _mm512_mul_ps(eLengthSq, eInverse)) : _mm512_add_ps(dLength, eLength);
+
+			const auto axisSq = _mm512_max_ps(zero, _mm512_sub_ps(_mm512_mul_ps(lengthSum, lengthSum), _mm512_mul_ps(radius, radius)));
+			auto b = _mm512_mul_ps(_mm512_sqrt_ps(axisSq), half);
+			const auto potential = IS_FAST ? _mm512_mul_ps(repulsiveAgent, expFast512(_mm512_mul_ps(_mm512_sub_ps(zero, b), inverseRepulsiveAgent))) : repulsiveAgentPotential512(axisSq, input.repulsiveAgent, b);
+			const auto ratio = _mm512_mul_ps(_mm512_mul_ps(lengthSum, half), b);
+
+			const auto isAhead = _mm512_cmp_ps_mask(_mm512_add_ps(_mm512_mul_ps(positionX, x), _mm512_mul_ps(positionY, y)), zero, _CMP_GT_OQ);
+			const auto weight = _mm512_mask_blend_ps(isAhead, perception, one);
+			const auto isApart = static_cast<__mmask16>(_mm512_cmp_ps_mask(_mm512_abs_ps(dX), epsilon, _CMP_GE_OQ) | _mm512_cmp_ps_mask(_mm512_abs_ps(dY), epsilon, _CMP_GE_OQ));
+			const auto coefficient = _mm512_mul_ps(_mm512_mul_ps(_mm512_mul_ps(potential, ratio), weight), factor);
+
+			const auto forceX = _mm512_maskz_mul_ps(isApart, coefficient, _mm512_add_ps(_mm512_mul_ps(dX, dInverse), _mm512_mul_ps(eX, eInverse)));
+			const auto forceY = _mm512_maskz_mul_ps(isApart, coefficient, _mm512_add_ps(_mm512_mul_ps(dY, dInverse), _mm512_mul_ps(eY, eInverse)));
+			const auto length = _mm512_sqrt_ps(_mm512_add_ps(_mm512_mul_ps(forceX, forceX), _mm512_mul_ps(forceY, forceY)));
+
+			sumX = _mm512_add_ps(sumX, forceX);
+			sumY = _mm512_add_ps(sumY, forceY);
+			sumLength = _mm512_add_ps(sumLength, length);
+			maxLength = _mm512_max_ps(maxLength, length);
+		}
+
+		alignas(64) float sums[4 * width];
+		_mm512_store_ps(sums, sumX);
+		_mm512_store_ps(sums + width, sumY);
+		_mm512_store_ps(sums + 2 * width, sumLength);
+		_mm512_store_ps(sums + 3 * width, maxLength);
+
+		output.forceSum = Vector2();
+		output.pressure = 0;
+		output.maxForceLength = FLT_MIN;
+
+		for (size_t lane = 0; lane < width; ++lane)
+		{
+			output.forceSum += Vector2(sums[lane], sums[width + lane]);
+			output.pressure += sums[2 * width + lane];
+			output.maxForceLength = std::max(output.maxForceLength, sums[3 * width + lane]);
+		}
+	}
+
+	/// <summary> Reduces the lanes of the repulsive obstacle force sums </summary>
+	/// <param name="sums"> The force length sums, the weighted x-coordinate sums and the weighted y-coordinate sums, each of the lane width </param>
+	/// <param name="width"> The count of lanes </param>
+	/// <returns> The weighted sum of the forces </returns>
+	static inline Vector2 reduceRepulsiveObstacleLanes(const float* sums, size_t width)
+	{
+		float lengthSum = 0;
+		auto weightedSum = Vector2();
+
+		for (size_t lane = 0; lane < width; ++lane)
+		{
+			lengthSum += sums[lane];
+			weightedSum += Vector2(sums[width + lane], sums[2 * width + lane]);
+		}
+
+		return weightedSum / lengthSum;
+	}
+
+	/// <summary> Computes the points of line segments closest to a point four segments at a time with SSE2 </summary>
+	/// <param name="batch"> The segments. Receives the closest points </param>
+	/// <param name="count"> The count of segments </param>
+	/// <param name="point"> The point </param>
+	static void computeClosestPointsSse2(ObstacleSegmentBatch& batch, size_t count, const Vector2& point)
+	{
+		const size_t width = 4;
+
+		const auto pointX = _mm_set1_ps(point.x());
+		const auto pointY = _mm_set1_ps(point.y());
+		const auto zero = _mm_setzero_ps();
+		const auto one = _mm_set1_ps(1.0f);
+
+		for (size_t i = 0; i < count; i += width)
+		{
+			const auto startX = _mm_loadu_ps(batch.startX + i);
+			const auto startY = _mm_loadu_ps(batch.startY + i);
+			const auto endX = _mm_loadu_ps(batch.endX + i);
+			const auto endY = _mm_loadu_ps(batch.endY + i);
+
+			const auto segmentX = _mm_sub_ps(endX, startX);
+			const auto segmentY = _mm_sub_ps(endY, startY);
+			const auto relativeX = _mm_sub_ps(pointX, startX);
+			const auto relativeY = _mm_sub_ps(pointY, startY);
+			const auto lambda = _mm_div_ps(_mm_add_ps(_mm_mul_ps(relativeX, segmentX), _mm_mul_ps(relativeY, segmentY)), _mm_add_ps(_mm_mul_ps(segmentX, segmentX), _mm_mul_ps(segmentY, segmentY)));
+
+			const auto isBefore = _mm_cmple_ps(lambda, zero);
+			const auto isAfter = _mm_cmpge_ps(lambda, one);
+			auto closestX = _mm_add_ps(startX, _mm_mul_ps(lambda, segmentX));
+			auto closestY = _mm_add_ps(startY, _mm_mul_ps(lambda, segmentY));
+			closestX = _mm_or_ps(_mm_and_ps(isAfter, endX), _mm_andnot_ps(isAfter, closestX));
+			closestY = _mm_or_ps(_mm_and_ps(isAfter, endY), _mm_andnot_ps(isAfter, closestY));
+			closestX = _mm_or_ps(_mm_and_ps(isBefore, startX), _mm_andnot_ps(isBefore, closestX));
+			closestY = _mm_or_ps(_mm_and_ps(isBefore, startY), _mm_andnot_ps(isBefore, closestY));
+
+			_mm_storeu_ps(batch.closestX + i, closestX);
+			_mm_storeu_ps(batch.closestY + i, closestY);
+		}
+	}
+
+	/// <summary> Computes the repulsive force exerted on an agent by the selected closest points four points at a time with SSE2. Each force is weighted by its share of the sum of the force lengths </summary>
+	/// <param name="input"> The agent </param>
+	/// <param name="batch"> The selected closest points. Receives the forces </param>
+	/// <param name="count"> The count of selected closest points </param>
+	/// <returns> The weighted sum of the forces </returns>
+	template <bool IS_FAST>
+	static Vector2 computeRepulsiveObstacleForceSse2(const RepulsiveObstacleInput& input, ObstacleSegmentBatch& batch, size_t count)
+	{
+		const size_t width = 4;
+
+		const auto positionX = _mm_set1_ps(input.position.x());
+		const auto positionY = _mm_set1_ps(input.position.y());
+		const auto radius = _mm_set1_ps(input.radius);
+		const auto repulsiveObstacle = _mm_set1_ps(input.repulsiveObstacle);
+		const auto inverseRepulsiveObstacle = _mm_set1_ps(1.0f / input.repulsiveObstacle);
+		const auto factor = _mm_set1_ps(input.repulsiveObstacleFactor);
+		const auto epsilonSq = _mm_set1_ps(FLT_EPSILON * FLT_EPSILON);
+		const auto zero = _mm_setzero_ps();
+		const auto lanes = _mm_setr_epi32(0, 1, 2, 3);
+		const auto laneCount = _mm_set1_epi32(static_cast<int>(count));
+
+		auto lengthSum = zero;
+		auto weightedX = zero;
+		auto weightedY = zero;
+
+		for (size_t i = 0; i < count; i += width)
+		{
+			const auto diffX = _mm_sub_ps(positionX, _mm_loadu_ps(batch.pointX + i));
+			const auto diffY = _mm_sub_ps(positionY, _mm_loadu_ps(batch.pointY + i));
+			const auto distanceSq = _mm_add_ps(_mm_mul_ps(diffX, diffX), _mm_mul_ps(diffY, diffY));
+			const auto inverseDistance = inverseSqrt128<IS_FAST>(distanceSq);
+			const auto distance = _mm_mul_ps(distanceSq, inverseDistance);
+			const auto amount = _mm_mul_ps(factor, IS_FAST ? expFast128(_mm_mul_ps(_mm_sub_ps(radius, distance), inverseRepulsiveObstacle)) : exp128(_mm_div_ps(_mm_sub_ps(radius, distance), repulsiveObstacle)));
+
+			// A point at the position of the agent has no direction and exerts no force, like a padding lane
+			const auto isLane = _mm_castsi128_ps(_mm_cmplt_epi32(_mm_add_epi32(_mm_set1_epi32(static_cast<int>(i)), lanes), laneCount));
+			const auto isActive = _mm_and_ps(isLane, _mm_cmpge_ps(distanceSq, epsilonSq));
+			const auto forceX = _mm_and_ps(isActive, _mm_mul_ps(amount, _mm_mul_ps(diffX, inverseDistance)));
+			const auto forceY = _mm_and_ps(isActive, _mm_mul_ps(amount, _mm_mul_ps(diffY, inverseDistance)));
+			const auto length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(forceX, forceX), _mm_mul_ps(forceY, forceY)));
+
+			_mm_storeu_ps(batch.forceX + i, forceX);
+			_mm_storeu_ps(batch.forceY + i, forceY);
+
+			lengthSum = _mm_add_ps(lengthSum, length);
+			weightedX = _mm_add_ps(weightedX, _mm_mul_ps(forceX, length));
+			weightedY = _mm_add_ps(weightedY, _mm_mul_ps(forceY, length));
+		}
+
+		alignas(16) float sums[3 * width];
+		_mm_store_ps(sums, lengthSum);
+		_mm_store_ps(sums + width, weightedX);
+		_mm_store_ps(sums + 2 * width, weightedY);
+
+		return reduceRepulsiveObstacleLanes(sums, width);
+	}
+
+	/// <summary> Computes the points of line segments closest to a point eight segments at a time with AVX2 </summary>
+	/// <param name="batch"> The segments. Receives the closest points </param>
+	/// <param name="count"> The count of segments </param>
+	/// <param name="point"> The point </param>
+	SF_TARGET_AVX2 static void computeClosestPointsAvx2(ObstacleSegmentBatch& batch, size_t count, const Vector2& point)
+	{
+		const size_t width = 8;
+
+		const auto pointX = _mm256_set1_ps(point.x());
+		const auto pointY = _mm256_set1_ps(point.y());
+		const auto zero = _mm256_setzero_ps();
+		const auto one = _mm256_set1_ps(1.0f);
+
+		for (size_t i = 0; i < count; i += width)
+		{
+			const auto startX = _mm256_loadu_ps(batch.startX + i);
+			const auto startY = _mm256_loadu_ps(batch.startY + i);
+			const auto endX = _mm256_loadu_ps(batch.endX + i);
+			const auto endY = _mm256_loadu_ps(batch.endY + i);
+
+			const auto segmentX = _mm256_sub_ps(endX, startX);
+			const auto segmentY = _mm256_sub_ps(endY, startY);
+			const auto relativeX = _mm256_sub_ps(pointX, startX);
+			const auto relativeY = _mm256_sub_ps(pointY, startY);
+			const auto lambda = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(relativeX, segmentX), _mm256_mul_ps(relativeY, segmentY)), _mm256_add_ps(_mm256_mul_ps(segmentX, segmentX), _mm256_mul_ps(segmentY, segmentY)));
+
+			const auto isBefore = _mm256_cmp_ps(lambda, zero, _CMP_LE_OQ);
+			const auto isAfter = _mm256_cmp_ps(lambda, one, _CMP_GE_OQ);
+			auto closestX = _mm256_add_ps(startX, _mm256_mul_ps(lambda, segmentX));
+			auto closestY = _mm256_add_ps(startY, _mm256_mul_ps(lambda, segmentY));
+			closestX = _mm256_blendv_ps(_mm256_blendv_ps(closestX, endX, isAfter), startX, isBefore);
+			closestY = _mm256_blendv_ps(_mm256_blendv_ps(closestY, endY, isAfter), startY, isBefore);
+
+			_mm256_storeu_ps(batch.closestX + i, closestX);
+			_mm256_storeu_ps(batch.closestY + i, closestY);
+		}
+	}
+
+	/// <summary> Computes the repulsive force exerted on an agent by the selected closest points eight points at a time with AVX2. Each force is weighted by its share of the sum of the force lengths </summary>
+	/// <param name="input"> The agent </param>
+	/// <param name="batch"> The selected closest points. Receives the forces </param>
+	/// <param name="count"> The count of selected closest points </param>
+	/// <returns> The weighted sum of the forces </returns>
+	template <bool IS_FAST>
+	SF_TARGET_AVX2 static Vector2 computeRepulsiveObstacleForceAvx2(const RepulsiveObstacleInput& input, ObstacleSegmentBatch& batch, size_t count)
+	{
+		const size_t width = 8;
+
+		const auto positionX = _mm256_set1_ps(input.position.x());
+		const auto positionY = _mm256_set1_ps(input.position.y());
+		const auto radius = _mm256_set1_ps(input.radius);
+		const auto repulsiveObstacle = _mm256_set1_ps(input.repulsiveObstacle);
+		const auto inverseRepulsiveObstacle = _mm256_set1_ps(1.0f / input.repulsiveObstacle);
+		const auto factor = _mm256_set1_ps(input.repulsiveObstacleFactor);
+		const auto epsilonSq = _mm256_set1_ps(FLT_EPSILON * FLT_EPSILON);
+		const auto zero = _mm256_setzero_ps();
+		const auto lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const auto laneCount = _mm256_set1_epi32(static_cast<int>(count));
+
+		auto lengthSum = zero;
+		auto weightedX = zero;
+		auto weightedY = zero;
+
+		for (size_t i = 0; i < count; i += width)
+		{
+			const auto diffX = _mm256_sub_ps(positionX, _mm256_loadu_ps(batch.pointX + i));
+			const auto diffY = _mm256_sub_ps(positionY, _mm256_loadu_ps(batch.pointY + i));
+			const auto distanceSq = _mm256_add_ps(_mm256_mul_ps(diffX, diffX), _mm256_mul_ps(diffY, diffY));
+			const auto inverseDistance = inverseSqrt256<IS_FAST>(distanceSq);
+			const auto distance = _mm256_mul_ps(distanceSq, inverseDistance);
+			const auto amount = _mm256_mul_ps(factor, IS_FAST ? expFast256(_mm256_mul_ps(_mm256_sub_ps(radius, distance), inverseRepulsiveObstacle)) : exp256(_mm256_div_ps(_mm256_sub_ps(radius, distance), repulsiveObstacle)));
+
+			// A point at the position of the agent has no direction and exerts no force, like a padding lane
+			const auto isLane = _mm256_castsi256_ps(_mm256_cmpgt_epi32(laneCount, _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i)), lanes)));
+			const auto isActive = _mm256_and_ps(isLane, _mm256_cmp_ps(distanceSq, epsilonSq, _CMP_GE_OQ));
+			const auto forceX = _mm256_and_ps(isActive, _mm256_mul_ps(amount, _mm256_mul_ps(diffX, inverseDistance)));
+			const auto forceY = _mm256_and_ps(isActive, _mm256_mul_ps(amount, _mm256_mul_ps(diffY, inverseDistance)));
+			const auto length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(forceX, forceX), _mm256_mul_ps(forceY, forceY)));
+
+			_mm256_storeu_ps(batch.forceX + i, forceX);
+			_mm256_storeu_ps(batch.forceY + i, forceY);
+
+			lengthSum = _mm256_add_ps(lengthSum, length);
+			weightedX = _mm256_add_ps(weightedX, _mm256_mul_ps(forceX, length));
+			weightedY = _mm256_add_ps(weightedY, _mm256_mul_ps(forceY, length));
+		}
+
+		alignas(32) float sums[3 * width];
+		_mm256_store_ps(sums, lengthSum);
+		_mm256_store_ps(sums + width, weightedX);
+		_mm256_store_ps(sums + 2 * width, weightedY);
+
+		return reduceRepulsiveObstacleLanes(sums, width);
+	}
+
+	/// <summary> Computes the points of line segments closest to a point sixteen segments at a time with AVX-512 </summary>
+	/// <param name="batch"> The segments. Receives the closest points </param>
+	/// <param name="count"> The count of segments </param>
+	/// <param name="point"> The point </param>
+	SF_TARGET_AVX512 static void computeClosestPointsAvx512(ObstacleSegmentBatch& batch, size_t count, const Vector2& point)
+	{
+		const size_t width = 16;
+
+		const auto pointX = _mm512_set1_ps(point.x());
+		const auto pointY = _mm512_set1_ps(point.y());
+		const auto zero = _mm512_setzero_ps();
+		const auto one = _mm512_set1_ps(1.0f);
+
+		for (size_t i = 0; i < count; i += width)
+		{
+			const auto startX = _mm512_loadu_ps(batch.startX + i);
+			const auto startY = _mm512_loadu_ps(batch.startY + i);
+			const auto endX = _mm512_loadu_ps(batch.endX + i);
+			const auto endY = _mm512_loadu_ps(batch.endY + i);
+
+			const auto segmentX = _mm512_sub_ps(endX, startX);
+			const auto segmentY = _mm512_sub_ps(endY, startY);
+			const auto relativeX = _mm512_sub_ps(pointX, startX);
+			const auto relativeY = _mm512_sub_ps(pointY, startY);
+			const auto lambda = _mm512_div_ps(_mm512_add_ps(_mm512_mul_ps(relativeX, segmentX), _mm512_mul_ps(relativeY, segmentY)), _mm512_add_ps(_mm512_mul_ps(segmentX, segmentX), _mm512_mul_ps(segmentY, segmentY)));
+
+			const auto isBefore = _mm512_cmp_ps_mask(lambda, zero, _CMP_LE_OQ);
+			const auto isAfter = _mm512_cmp_ps_mask(lambda, one, _CMP_GE_OQ);
+			auto closestX = _mm512_add_ps(startX, _mm512_mul_ps(lambda, segmentX));
+			auto closestY = _mm512_add_ps(startY, _mm512_mul_ps(lambda, segmentY));
+			closestX = _mm512_mask_blend_ps(isBefore, _mm512_mask_blend_ps(isAfter, closestX, endX), startX);
+			closestY = _mm512_mask_blend_ps(isBefore, _mm512_mask_blend_ps(isAfter, closestY, endY), startY);
+
+			_mm512_storeu_ps(batch.closestX + i, closestX);
+			_mm512_storeu_ps(batch.closestY + i, closestY);
+		}
+	}
+
+	/// <summary> Computes the repulsive force exerted on an agent by the selected closest points sixteen points at a time with AVX-512. Each force is weighted by its share of the sum of the force lengths </summary>
+	/// <param name="input"> The agent </param>
+	/// <param name="batch"> The selected closest points. Receives the forces </param>
+	/// <param name="count"> The count of selected closest points </param>
+	/// <returns> The weighted sum of the forces </returns>
+	template <bool IS_FAST>
+	SF_TARGET_AVX512 static Vector2 computeRepulsiveObstacleForceAvx512(const RepulsiveObstacleInput& input, ObstacleSegmentBatch& batch, size_t count)
+	{
+		const size_t width = 16;
+
+		const auto positionX = _mm512_set1_ps(input.position.x());
+		const auto positionY = _mm512_set1_ps(input.position.y());
+		const auto radius = _mm512_set1_ps(input.radius);
+		const auto repulsiveObstacle = _mm512_set1_ps(input.repulsiveObstacle);
+		const auto inverseRepulsiveObstacle = _mm512_set1_ps(1.0f / input.repulsiveObstacle);
+		const auto factor = _mm512_set1_ps(input.repulsiveObstacleFactor);
+		const auto epsilonSq = _mm512_set1_ps(FLT_EPSILON * FLT_EPSILON);
+		const auto zero = _mm512_setzero_ps();
+
+		auto lengthSum = zero;
+		auto weightedX = zero;
+		auto weightedY = zero;
+
+		for (size_t i = 0; i < count; i += width)
+		{
+			const auto diffX = _mm512_sub_ps(positionX, _mm512_loadu_ps(batch.pointX + i));
+			const auto diffY = _mm512_sub_ps(positionY, _mm512_loadu_ps(batch.pointY + i));
+			const auto distanceSq = _mm512_add_ps(_mm512_mul_ps(diffX, diffX), _mm512_mul_ps(diffY, diffY));
+			const auto inverseDistance = inverseSqrt512<IS_FAST>(distanceSq);
+			const auto distance = _mm512_mul_ps(distanceSq, inverseDistance);
+			const auto amount = _mm512_mul_ps(factor, IS_FAST ? expFast512(_mm512_mul_ps(_mm512_sub_ps(radius, distance), inverseRepulsiveObstacle)) : exp512(_mm512_div_ps(_mm512_sub_ps(radius, distance), repulsiveObstacle)));
+
+			// A point at the position of the agent has no direction and exerts no force, like a padding lane
+			const auto isLane = static_cast<__mmask16>(count - i >= width ? 0xFFFF : (1u << (count - i)) - 1);
+			const auto isActive = static_cast<__mmask16>(isLane & _mm512_cmp_ps_mask(distanceSq, epsilonSq, _CMP_GE_OQ));
+			const auto forceX = _mm512_maskz_mul_ps(isActive, amount, _mm512_mul_ps(diffX, inverseDistance));
+			const auto forceY = _mm512_maskz_mul_ps(isActive, amount, _mm512_mul_ps(diffY, inverseDistance));
+			const auto length = _mm512_sqrt_ps(_mm512_add_ps(_mm512_mul_ps(forceX, forceX), _mm512_mul_ps(forceY, forceY)));
+
+			_mm512_storeu_ps(batch.forceX + i, forceX);
+			_mm512_storeu_ps(batch.forceY + i, forceY);
+
+			lengthSum = _mm512_add_ps(lengthSum, length);
+			weightedX = _mm512_add_ps(weightedX, _mm512_mul_ps(forceX, length));
+			weightedY = _mm512_add_ps(weightedY, _mm512_mul_ps(forceY, length));
+		}
+
+		alignas(64) float sums[3 * width];
+		_mm512_store_ps(sums, lengthSum);
+		_mm512_store_ps(sums + width, weightedX);
+		_mm512_store_ps(sums + 2 * width, weightedY);
+
+		return reduceRepulsiveObstacleLanes(sums, width);
+	}
+
+	/// <summary> Accumulates the accelerations of four agents due to the roll of the moving platform about one axis </summary>
+	/// <param name="roll"> The roll of the platform </param>
+	/// <param name="x"> The x-coordinates of the positions </param>
+	/// <param name="y"> The y-coordinates of the positions </param>
+	/// <param name="vx"> The x-coordinates of the velocities </param>
+	/// <param name="vy"> The y-coordinates of the velocities </param>
+	/// <param name="accelerationX"> The x-coordinates of the accelerations </param>
+	/// <param name="accelerationY"> The y-coordinates of the accelerations </param>
+	static inline void accumulatePlatformRoll128(const PlatformRoll& roll, __m128 x, __m128 y, __m128 vx, __m128 vy, __m128& accelerationX, __m128& accelerationY)
+	{
+		const auto omegaX = _mm_set1_ps(roll.omega.x());
+		const auto omegaY = _mm_set1_ps(roll.omega.y());
+		const auto omegaZ = _mm_set1_ps(roll.omega.z());
+		const auto dOmegaX = _mm_set1_ps(roll.dOmega.x());
+		const auto dOmegaY = _mm_set1_ps(roll.dOmega.y());
+		const auto dOmegaZ = _mm_set1_ps(roll.dOmega.z());
+		const auto zero = _mm_setzero_ps();
+		const auto signMask = _mm_set1_ps(-0.0f);
+
+		// The cross products are oriented by the sign of their determinant, the agents lying in the plane z = 0
+		auto prefixX = _mm_xor_ps(_mm_mul_ps(omegaZ, y), signMask);
+		auto prefixY = _mm_mul_ps(omegaZ, x);
+		auto prefixZ = _mm_sub_ps(_mm_mul_ps(omegaX, y), _mm_mul_ps(omegaY, x));
+		const auto prefixSign = _mm_andnot_ps(_mm_cmpgt_ps(_mm_sub_ps(_mm_add_ps(_mm_add_ps(prefixX, prefixY), _mm_mul_ps(omegaX, y)), _mm_mul_ps(omegaY, x)), zero), signMask);
+		prefixX = _mm_xor_ps(prefixX, prefixSign);
+		prefixY = _mm_xor_ps(prefixY, prefixSign);
+		prefixZ = _mm_xor_ps(prefixZ, prefixSign);
+
+		const auto centralDeterminant = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(omegaY, prefixZ), _mm_mul_ps(omegaZ, prefixY)), _mm_mul_ps(omegaX, prefixZ)), _mm_mul_ps(omegaZ, prefixX)), _mm_mul_ps(omegaX, prefixY)), _mm_mul_ps(omegaY, prefixX));
+		const auto centralSign = _mm_andnot_ps(_mm_cmpgt_ps(centralDeterminant, zero), signMask);
+		const auto centralX = _mm_xor_ps(_mm_sub_ps(_mm_mul_ps(omegaY, prefixZ), _mm_mul_ps(omegaZ, prefixY)), centralSign);
+		const auto centralY = _mm_xor_ps(_mm_sub_ps(_mm_mul_ps(omegaZ, prefixX), _mm_mul_ps(omegaX, prefixZ)), centralSign);
+
+		auto tangentialX = _mm_xor_ps(_mm_mul_ps(dOmegaZ, y), signMask);
+		auto tangentialY = _mm_mul_ps(dOmegaZ, x);
+		const auto tangentialSign = _mm_andnot_ps(_mm_cmpgt_ps(_mm_sub_ps(_mm_add_ps(_mm_add_ps(tangentialX, tangentialY), _mm_mul_ps(dOmegaX, y)), _mm_mul_ps(dOmegaY, x)), zero), signMask);
+		tangentialX = _mm_xor_ps(tangentialX, tangentialSign);
+		tangentialY = _mm_xor_ps(tangentialY, tangentialSign);
+
+		auto coriolisX = _mm_xor_ps(_mm_mul_ps(omegaZ, vy), signMask);
+		auto coriolisY = _mm_mul_ps(omegaZ, vx);
+		const auto coriolisSign = _mm_andnot_ps(_mm_cmpgt_ps(_mm_sub_ps(_mm_add_ps(_mm_add_ps(coriolisX, coriolisY), _mm_mul_ps(omegaX, vy)), _mm_mul_ps(omegaY, vx)), zero), signMask);
+		coriolisX = _mm_add_ps(_mm_xor_ps(coriolisX, coriolisSign), _mm_xor_ps(coriolisX, coriolisSign));
+		coriolisY = _mm_add_ps(_mm_xor_ps(coriolisY, coriolisSign), _mm_xor_ps(coriolisY, coriolisSign));
+
+		accelerationX = _mm_add_ps(accelerationX, _mm_div_ps(_mm_sub_ps(_mm_add_ps(centralX, tangentialX), coriolisX), _mm_set1_ps(roll.omegaCosX)));
+		accelerationY = _mm_add_ps(accelerationY, _mm_div_ps(_mm_sub_ps(_mm_add_ps(centralY, tangentialY), coriolisY), _mm_set1_ps(roll.omegaCosY)));
+	}
+
+	/// <summary> Computes the moving platform forces exerted on a range of agents four agents at a time with SSE2 </summary>
+	/// <param name="input"> The state of the agents and the platform kinematics </param>
+	/// <param name="begin"> The slot of the first agent </param>
+	/// <param name="end"> The slot past the last agent </param>
+	/// <param name="forces"> The forces indexed by agent slot </param>
+	static void computeMovingPlatformForcesSse2(const MovingPlatformInput& input, size_t begin, size_t end, Vector2* forces)
+	{
+		const size_t width = 4;
+		const auto& frame = *input.frame;
+		const auto timeStep = _mm_set1_ps(input.timeStep);
+		const auto heaveFactor = _mm_set1_ps(frame.heaveFactor);
+		const auto positions = reinterpret_cast<const float*>(input.positions);
+		const auto velocities = reinterpret_cast<const float*>(input.velocities);
+		const auto output = reinterpret_cast<float*>(forces);
+		auto i = begin;
+
+		// The interleaved coordinates are split within each 128-bit lane, which orders the agents by lane. The same split interleaves the forces back, and the factors are permuted to match
+		for (; i + width <= end; i += width)
+		{
+			const auto positionLow = _mm_loadu_ps(positions + 2 * i);
+			const auto positionHigh = _mm_loadu_ps(positions + 2 * i + width);
+			const auto velocityLow = _mm_loadu_ps(velocities + 2 * i);
+			const auto velocityHigh = _mm_loadu_ps(velocities + 2 * i + width);
+			const auto x = _mm_shuffle_ps(positionLow, positionHigh, _MM_SHUFFLE(2, 0, 2, 0));
+			const auto y = _mm_shuffle_ps(positionLow, positionHigh, _MM_SHUFFLE(3, 1, 3, 1));
+			const auto vx = _mm_shuffle_ps(velocityLow, velocityHigh, _MM_SHUFFLE(2, 0, 2, 0));
+			const auto vy = _mm_shuffle_ps(velocityLow, velocityHigh, _MM_SHUFFLE(3, 1, 3, 1));
+			const auto factor = _mm_loadu_ps(input.platformFactors + i);
+
+			auto accelerationX = _mm_setzero_ps();
+			auto accelerationY = _mm_setzero_ps();
+
+			if (frame.rollX.isRolling)
+				accumulatePlatformRoll128(frame.rollX, x, y, vx, vy, accelerationX, accelerationY);
+
+			if (frame.rollY.isRolling)
+				accumulatePlatformRoll128(frame.rollY, x, y, vx, vy, accelerationX, accelerationY);
+
+			const auto forceX = _mm_mul_ps(_mm_mul_ps(_mm_add_ps(vx, _mm_mul_ps(accelerationX, timeStep)), heaveFactor), factor);
+			const auto forceY = _mm_mul_ps(_mm_mul_ps(_mm_add_ps(vy, _mm_mul_ps(accelerationY, timeStep)), heaveFactor), factor);
+
+			_mm_storeu_ps(output + 2 * i, _mm_unpacklo_ps(forceX, forceY));
+			_mm_storeu_ps(output + 2 * i + width, _mm_unpackhi_ps(forceX, forceY));
+		}
+
+		computeMovingPlatformForcesScalar(input, i, end, forces);
+	}
+
+	/// <summary> Accumulates the accelerations of eight agents due to the roll of the moving platform about one axis </summary>
+	/// <param name="roll"> The roll of the platform </param>
+	/// <param name="x"> The x-coordinates of the positions </param>
+	/// <param name="y"> The y-coordinates of the positions </param>
+	/// <param name="vx"> The x-coordinates of the velocities </param>
+	/// <param name="vy"> The y-coordinates of the velocities </param>
+	/// <param name="accelerationX"> The x-coordinates of the accelerations </param>
+	/// <param name="accelerationY"> The y-coordinates of the accelerations </param>
+	SF_TARGET_AVX2 static inline void accumulatePlatformRoll256(const PlatformRoll& roll, __m256 x, __m256 y, __m256 vx, __m256 vy, __m256& accelerationX, __m256& accelerationY)
+	{
+		const auto omegaX = _mm256_set1_ps(roll.omega.x());
+		const auto omegaY = _mm256_set1_ps(roll.omega.y());
+		const auto omegaZ = _mm256_set1_ps(roll.omega.z());
+		const auto dOmegaX = _mm256_set1_ps(roll.dOmega.x());
+		const auto dOmegaY = _mm256_set1_ps(roll.dOmega.y());
+		const auto dOmegaZ = _mm256_set1_ps(roll.dOmega.z());
+		const auto zero = _mm256_setzero_ps();
+		const auto signMask = _mm256_set1_ps(-0.0f);
+
+		// The cross products are oriented by the sign of their determinant, the agents lying in the plane z = 0
+		auto prefixX = _mm256_xor_ps(_mm256_mul_ps(omegaZ, y), signMask);
+		auto prefixY = _mm256_mul_ps(omegaZ, x);
+		auto prefixZ = _mm256_sub_ps(_mm256_mul_ps(omegaX, y), _mm256_mul_ps(omegaY, x));
+		const auto prefixSign = _mm256_andnot_ps(_mm256_cmp_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(prefixX, prefixY), _mm256_mul_ps(omegaX, y)), _mm256_mul_ps(omegaY, x)), zero, _CMP_GT_OQ), signMask);
+		prefixX = _mm256_xor_ps(prefixX, prefixSign);
+		prefixY = _mm256_xor_ps(prefixY, prefixSign);
+		prefixZ = _mm256_xor_ps(prefixZ, prefixSign);
+
+		const auto centralDeterminant = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_mul_ps(omegaY, prefixZ), _mm256_mul_ps(omegaZ, prefixY)), _mm256_mul_ps(omegaX, prefixZ)), _mm256_mul_ps(omegaZ, prefixX)), _mm256_mul_ps(omegaX, prefixY)), _mm256_mul_ps(omegaY, prefixX));
+		const auto centralSign = _mm256_andnot_ps(_mm256_cmp_ps(centralDeterminant, zero, _CMP_GT_OQ), signMask);
+		const auto centralX = _mm256_xor_ps(_mm256_sub_ps(_mm256_mul_ps(omegaY, prefixZ), _mm256_mul_ps(omegaZ, prefixY)), centralSign);
+		const auto centralY = _mm256_xor_ps(_mm256_sub_ps(_mm256_mul_ps(omegaZ, prefixX), _mm256_mul_ps(omegaX, prefixZ)), centralSign);
+
+		auto tangentialX = _mm256_xor_ps(_mm256_mul_ps(dOmegaZ, y), signMask);
+		auto tangentialY = _mm256_mul_ps(dOmegaZ, x);
+		const auto tangentialSign = _mm256_andnot_ps(_mm256_cmp_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(tangentialX, tangentialY), _mm256_mul_ps(dOmegaX, y)), _mm256_mul_ps(dOmegaY, x)), zero, _CMP_GT_OQ), signMask);
+		tangentialX = _mm256_xor_ps(tangentialX, tangentialSign);
+		tangentialY = _mm256_xor_ps(tangentialY, tangentialSign);
+
+		auto coriolisX = _mm256_xor_ps(_mm256_mul_ps(omegaZ, vy), signMask);
+		auto coriolisY = _mm256_mul_ps(omegaZ, vx);
+		const auto coriolisSign = _mm256_andnot_ps(_mm256_cmp_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(coriolisX, coriolisY), _mm256_mul_ps(omegaX, vy)), _mm256_mul_ps(omegaY, vx)), zero, _CMP_GT_OQ), signMask);
+		coriolisX = _mm256_add_ps(_mm256_xor_ps(coriolisX, coriolisSign), _mm256_xor_ps(coriolisX, coriolisSign));
+		coriolisY = _mm256_add_ps(_mm256_xor_ps(coriolisY, coriolisSign), _mm256_xor_ps(coriolisY, coriolisSign));
+
+		accelerationX = _mm256_add_ps(accelerationX, _mm256_div_ps(_mm256_sub_ps(_mm256_add_ps(centralX, tangentialX), coriolisX), _mm256_set1_ps(roll.omegaCosX)));
+		accelerationY = _mm256_add_ps(accelerationY, _mm256_div_ps(_mm256_sub_ps(_mm256_add_ps(centralY, tangentialY), coriolisY), _mm256_set1_ps(roll.omegaCosY)));
+	}
+
+	/// <summary> Computes the moving platform forces exerted on a range of agents eight agents at a time with AVX2 </summary>
+	/// <param name="input"> The state of the agents and the platform kinematics </param>
+	/// <param name="begin"> The slot of the first agent </param>
+	/// <param name="end"> The slot past the last agent </param>
+	/// <param name="forces"> The forces indexed by agent slot </param>
+	SF_TARGET_AVX2 static void computeMovingPlatformForcesAvx2(const MovingPlatformInput& input, size_t begin, size_t end, Vector2* forces)
+	{
+		const size_t width = 8;
+		const auto& frame = *input.frame;
+		const auto timeStep = _mm256_set1_ps(input.timeStep);
+		const auto heaveFactor = _mm256_set1_ps(frame.heaveFactor);
+		const auto positions = reinterpret_cast<const float*>(input.positions);
+		const auto velocities = reinterpret_cast<const float*>(input.velocities);
+		const auto output = reinterpret_cast<float*>(forces);
+		auto i = begin;
+
+		// The interleaved coordinates are split within each 128-bit lane, which orders the agents by lane. The same split interleaves the forces back, and the factors are permuted to match
+		for (; i + width <= end; i += width)
+		{
+			const auto positionLow = _mm256_loadu_ps(positions + 2 * i);
+			const auto positionHigh = _mm256_loadu_ps(positions + 2 * i + width);
+			const auto velocityLow = _mm256_loadu_ps(velocities + 2 * i);
+			const auto velocityHigh = _mm256_loadu_ps(velocities + 2 * i + width);
+			const auto x = _mm256_shuffle_ps(positionLow, positionHigh, _MM_SHUFFLE(2, 0, 2, 0));
+			const auto y = _mm256_shuffle_ps(positionLow, positionHigh, _MM_SHUFFLE(3, 1, 3, 1));
+			const auto vx = _mm256_shuffle_ps(velocityLow, velocityHigh, _MM_SHUFFLE(2, 0, 2, 0));
+			const auto vy = _mm256_shuffle_ps(velocityLow, velocityHigh, _MM_SHUFFLE(3, 1, 3, 1));
+			const auto factor = _mm256_permutevar8x32_ps(_mm256_loadu_ps(input.platformFactors + i), _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7));
+
+			auto accelerationX = _mm256_setzero_ps();
+			auto accelerationY = _mm256_setzero_ps();
+
+			if (frame.rollX.isRolling)
+				accumulatePlatformRoll256(frame.rollX, x, y, vx, vy, accelerationX, accelerationY);
+
+			if (frame.rollY.isRolling)
+				accumulatePlatformRoll256(frame.rollY, x, y, vx, vy, accelerationX, accelerationY);
+
+			const auto forceX = _mm256_mul_ps(_mm256_mul_ps(_mm256_add_ps(vx, _mm256_mul_ps(accelerationX, timeStep)), heaveFactor), factor);
+			const auto forceY = _mm256_mul_ps(_mm256_mul_ps(_mm256_add_ps(vy, _mm256_mul_ps(accelerationY, timeStep)), heaveFactor), factor);
+
+			_mm256_storeu_ps(output + 2 * i, _mm256_unpacklo_ps(forceX, forceY));
+			_mm256_storeu_ps(output + 2 * i + width, _mm256_unpackhi_ps(forceX, forceY));
+		}
+
+		computeMovingPlatformForcesScalar(input, i, end, forces);
+	}
+
+	/// <summary> Accumulates the accelerations of sixteen agents due to the roll of the moving platform about one axis </summary>
+	/// <param name="roll"> The roll of the platform </param>
+	/// <param name="x"> The x-coordinates of the positions </param>
+	/// <param name="y"> The y-coordinates of the positions </param>
+	/// <param name="vx"> The x-coordinates of the velocities </param>
+	/// <param name="vy"> The y-coordinates of the velocities </param>
+	/// <param name="accelerationX"> The x-coordinates of the accelerations </param>
+	/// <param name="accelerationY"> The y-coordinates of the accelerations </param>
+	SF_TARGET_AVX512 static inline void accumulatePlatformRoll512(const PlatformRoll& roll, __m512 x, __m512 y, __m512 vx, __m512 vy, __m512& accelerationX, __m512& accelerationY)
+	{
+		const auto omegaX = _mm512_set1_ps(roll.omega.x());
+		const auto omegaY = _mm512_set1_ps(roll.omega.y());
+		const auto omegaZ = _mm512_set1_ps(roll.omega.z());
+		const auto dOmegaX = _mm512_set1_ps(roll.dOmega.x());
+		const auto dOmegaY = _mm512_set1_ps(roll.dOmega.y());
+		const auto dOmegaZ = _mm512_set1_ps(roll.dOmega.z());
+		const auto zero = _mm512_setzero_ps();
+		const auto signMask = _mm512_set1_ps(-0.0f);
+
+		// The cross products are oriented by the sign of their determinant, the agents lying in the plane z = 0
+		auto prefixX = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_mul_ps(omegaZ, y)), _mm512_castps_si512(signMask)));
+		auto prefixY = _mm512_mul_ps(omegaZ, x);
+		auto prefixZ = _mm512_sub_ps(_mm512_mul_ps(omegaX, y), _mm512_mul_ps(omegaY, x));
+		const auto prefixSign = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(_mm512_sub_ps(_mm512_add_ps(_mm512_add_ps(prefixX, prefixY), _mm512_mul_ps(omegaX, y)), _mm512_mul_ps(omegaY, x)), zero, _CMP_NGT_UQ), signMask);
+		prefixX = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(prefixX), _mm512_castps_si512(prefixSign)));
+		prefixY = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(prefixY), _mm512_castps_si512(prefixSign)));
+		prefixZ = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(prefixZ), _mm512_castps_si512(prefixSign)));
+
+		const auto centralDeterminant = _mm512_sub_ps(_mm512_add_ps(_mm512_add_ps(_mm512_sub_ps(_mm512_sub_ps(_mm512_mul_ps(omegaY, prefixZ), _mm512_mul_ps(omegaZ, prefixY)), _mm512_mul_ps(omegaX, prefixZ)), _mm512_mul_ps(omegaZ, prefixX)), _mm512_mul_ps(omegaX, prefixY)), _mm512_mul_ps(omegaY, prefixX));
+		const auto centralSign = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(centralDeterminant, zero, _CMP_NGT_UQ), signMask);
+		const auto centralX = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_sub_ps(_mm512_mul_ps(omegaY, prefixZ), _mm512_mul_ps(omegaZ, prefixY))), _mm512_castps_si512(centralSign)));
+		const auto centralY = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_sub_ps(_mm512_mul_ps(omegaZ, prefixX), _mm512_mul_ps(omegaX, prefixZ))), _mm512_castps_si512(centralSign)));
+
+		auto tangentialX = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_mul_ps(dOmegaZ, y)), _mm512_castps_si512(signMask)));
+		auto tangentialY = _mm512_mul_ps(dOmegaZ, x);
+		const auto tangentialSign = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(_mm512_sub_ps(_mm512_add_ps(_mm512_add_ps(tangentialX, tangentialY), _mm512_mul_ps(dOmegaX, y)), _mm512_mul_ps(dOmegaY, x)), zero, _CMP_NGT_UQ), signMask);
+		tangentialX = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(tangentialX), _mm512_castps_si512(tangentialSign)));
+		tangentialY = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(tangentialY), _mm512_castps_si512(tangentialSign)));
+
+		auto coriolisX = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_mul_ps(omegaZ, vy)), _mm512_castps_si512(signMask)));
+		auto coriolisY = _mm512_mul_ps(omegaZ, vx);
+		const auto coriolisSign = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(_mm512_sub_ps(_mm512_add_ps(_mm512_add_ps(coriolisX, coriolisY), _mm512_mul_ps(omegaX, vy)), _mm512_mul_ps(omegaY, vx)), zero, _CMP_NGT_UQ), signMask);
+		coriolisX = _mm512_add_ps(_mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(coriolisX), _mm512_castps_si512(coriolisSign))), _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(coriolisX), _mm512_castps_si512(coriolisSign))));
+		coriolisY = _mm512_add_ps(_mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(coriolisY), _mm512_castps_si512(coriolisSign))), _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(coriolisY), _mm512_castps_si512(coriolisSign))));
+
+		accelerationX = _mm512_add_ps(accelerationX, _mm512_div_ps(_mm512_sub_ps(_mm512_add_ps(centralX, tangentialX), coriolisX), _mm512_set1_ps(roll.omegaCosX)));
+		accelerationY = _mm512_add_ps(accelerationY, _mm512_div_ps(_mm512_sub_ps(_mm512_add_ps(centralY, tangentialY), coriolisY), _mm512_set1_ps(roll.omegaCosY)));
+	}
+
+	/// <summary> Computes the moving platform forces exerted on a range of agents sixteen agents at a time with AVX-512 </summary>
+	/// <param name="input"> The state of the agents and the platform kinematics </param>
+	/// <param name="begin"> The slot of the first agent </param>
+	/// <param name="end"> The slot past the last agent </param>
+	/// <param name="forces"> The forces indexed by agent slot </param>
+	SF_TARGET_AVX512 static void computeMovingPlatformForcesAvx512(const MovingPlatformInput& input, size_t begin, size_t end, Vector2* forces)
+	{
+		const size_t width = 16;
+		const auto& frame = *input.frame;
+		const auto timeStep = _mm512_set1_ps(input.timeStep);
+		const auto heaveFactor = _mm512_set1_ps(frame.heaveFactor);
+		const auto positions = reinterpret_cast<const float*>(input.positions);
+		const auto velocities = reinterpret_cast<const float*>(input.velocities);
+		const auto output = reinterpret_cast<float*>(forces);
+		auto i = begin;
+
+		// The interleaved coordinates are split within each 128-bit lane, which orders the agents by lane. The same split interleaves the forces back, and the factors are permuted to match
+		for (; i + width <= end; i += width)
+		{
+			const auto positionLow = _mm512_loadu_ps(positions + 2 * i);
+			const auto positionHigh = _mm512_loadu_ps(positions + 2 * i + width);
+			const auto velocityLow = _mm512_loadu_ps(velocities + 2 * i);
+			const auto velocityHigh = _mm512_loadu_ps(velocities + 2 * i + width);
+			const auto x = _mm512_shuffle_ps(positionLow, positionHigh, _MM_SHUFFLE(2, 0, 2, 0));
+			const auto y = _mm512_shuffle_ps(positionLow, positionHigh, _MM_SHUFFLE(3, 1, 3, 1));
+			const auto vx = _mm512_shuffle_ps(velocityLow, velocityHigh, _MM_SHUFFLE(2, 0, 2, 0));
+			const auto vy = _mm512_shuffle_ps(velocityLow, velocityHigh, _MM_SHUFFLE(3, 1, 3, 1));
+			const auto factor = _mm512_permutexvar_ps(_mm512_setr_epi32(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15), _mm512_loadu_ps(input.platformFactors + i));
+
+			auto accelerationX = _mm512_setzero_ps();
+			auto accelerationY = _mm512_setzero_ps();
+
+			if (frame.rollX.isRolling)
+				accumulatePlatformRoll512(frame.rollX, x, y, vx, vy, accelerationX, accelerationY);
+
+			if (frame.rollY.isRolling)
+				accumulatePlatformRoll512(frame.rollY, x, y, vx, vy, accelerationX, accelerationY);
+
+			const auto forceX = _mm512_mul_ps(_mm512_mul_ps(_mm512_add_ps(vx, _mm512_mul_ps(accelerationX, timeStep)), heaveFactor), factor);
+			const auto forceY = _mm512_mul_ps(_mm512_mul_ps(_mm512_add_ps(vy, _mm512_mul_ps(accelerationY, timeStep)), heaveFactor), factor);
+
+			_mm512_storeu_ps(output + 2 * i, _mm512_unpacklo_ps(forceX, forceY));
+			_mm512_storeu_ps(output + 2 * i + width, _mm512_unpackhi_ps(forceX, forceY));
+		}
+
+		computeMovingPlatformForcesScalar(input, i, end, forces);
+	}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+	/// <summary> Detects the widest instruction set supported by the CPU and the operating system </summary>
+	/// <returns> The widest supported instruction set </returns>
+	SFSimulator::InstructionSet getSupportedInstructionSet()
+	{
+#if SF_X86_KERNELS && defined(_MSC_VER)
+		int info[4];
+
+		__cpuid(info, 0);
+		const auto maxLeaf = info[0];
+
+		__cpuid(info, 1);
+
+		if ((info[3] & (1 << 26)) == 0)
+			return SFSimulator::SCALAR;
+
+		// AVX state must be enabled by the operating system, which is reported through OSXSAVE and XCR0
+		if (maxLeaf < 7 || (info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+			return SFSimulator::SSE2;
+
+		const auto xcr0 = _xgetbv(0);
+
+		if ((xcr0 & 0x6) != 0x6)
+			return SFSimulator::SSE2;
+
+		__cpuidex(info, 7, 0);
+
+		if ((info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6)
+			return SFSimulator::AVX512;
+
+		if ((info[1] & (1 << 5)) != 0)
+			return SFSimulator::AVX2;
+
+		return SFSimulator::SSE2;
+#elif SF_X86_KERNELS
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("avx512f"))
+			return SFSimulator::AVX512;
+
+		if (__builtin_cpu_supports("avx2"))
+			return SFSimulator::AVX2;
+
+		if (__builtin_cpu_supports("sse2"))
+			return SFSimulator::SSE2;
+
+		return SFSimulator::SCALAR;
+#else
+		return SFSimulator::SCALAR;
+#endif
+	}
+
+	/// <summary> Returns the repulsive agent force kernel using the specified instruction set and math mode </summary>
+	/// <param name="instructionSet"> The instruction set, which must be supported </param>
+	/// <param name="mathMode"> The math mode </param>
+	/// <returns> The kernel </returns>
+	RepulsiveAgentKernel getRepulsiveAgentKernel(SFSimulator::InstructionSet instructionSet, SFSimulator::MathMode mathMode)
+	{
+		const auto isFast = mathMode == SFSimulator::FAST;
+
+#if SF_X86_KERNELS
+		switch (instructionSet)
+		{
+		case SFSimulator::AVX512:
+			return isFast ? computeRepulsiveAgentForceAvx512<true> : computeRepulsiveAgentForceAvx512<false>;
+		case SFSimulator::AVX2:
+			return isFast ? computeRepulsiveAgentForceAvx2<true> : computeRepulsiveAgentForceAvx2<false>;
+		case SFSimulator::SSE2:
+			return isFast ? computeRepulsiveAgentForceSse2<true> : computeRepulsiveAgentForceSse2<false>;
+		default:
+			break;
+		}
+#endif
+
+		return isFast ? computeRepulsiveAgentForceScalarFast : computeRepulsiveAgentForceScalar;
+	}
+
+	/// <summary> Returns the closest point kernel using the specified instruction set </summary>
+	/// <param name="instructionSet"> The instruction set, which must be supported </param>
+	/// <returns> The kernel </returns>
+	ClosestPointKernel getClosestPointKernel(SFSimulator::InstructionSet instructionSet)
+	{
+#if SF_X86_KERNELS
+		switch (instructionSet)
+		{
+		case SFSimulator::AVX512:
+			return computeClosestPointsAvx512;
+		case SFSimulator::AVX2:
+			return computeClosestPointsAvx2;
+		case SFSimulator::SSE2:
+			return computeClosestPointsSse2;
+		default:
+			break;
+		}
+#endif
+
+		return computeClosestPointsScalar;
+	}
+
+	/// <summary> Returns the repulsive obstacle force kernel using the specified instruction set and math mode </summary>
+	/// <param name="instructionSet"> The instruction set, which must be supported </param>
+	/// <param name="mathMode"> The math mode </param>
+	/// <returns> The kernel </returns>
+	RepulsiveObstacleKernel getRepulsiveObstacleKernel(SFSimulator::InstructionSet instructionSet, SFSimulator::MathMode mathMode)
+	{
+		const auto isFast = mathMode == SFSimulator::FAST;
+
+#if SF_X86_KERNELS
+		switch (instructionSet)
+		{
+		case SFSimulator::AVX512:
+			return isFast ? computeRepulsiveObstacleForceAvx512<true> : computeRepulsiveObstacleForceAvx512<false>;
+		case SFSimulator::AVX2:
+			return isFast ? computeRepulsiveObstacleForceAvx2<true> : computeRepulsiveObstacleForceAvx2<false>;
+		case SFSimulator::SSE2:
+			return isFast ? computeRepulsiveObstacleForceSse2<true> : computeRepulsiveObstacleForceSse2<false>;
+		default:
+			break;
+		}
+#endif
+
+		return isFast ? computeRepulsiveObstacleForceScalarFast : computeRepulsiveObstacleForceScalar;
+	}
+
+	/// <summary> Returns the moving platform force kernel using the specified instruction set </summary>
+	/// <param name="instructionSet"> The instruction set, which must be supported </param>
+	/// <returns> The kernel </returns>
+	MovingPlatformKernel getMovingPlatformKernel(SFSimulator::InstructionSet instructionSet)
+	{
+#if SF_X86_KERNELS
+		switch (instructionSet)
+		{
+		case SFSimulator::AVX512:
+			return computeMovingPlatformForcesAvx512;
+		case SFSimulator::AVX2:
+			return computeMovingPlatformForcesAvx2;
+		case SFSimulator::SSE2:
+			return computeMovingPlatformForcesSse2;
+		default:
+			break;
+		}
+#endif
+
+		return computeMovingPlatformForcesScalar;
+	}
+}
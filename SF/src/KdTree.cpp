@@ -3,7 +3,17 @@
 #include "../include/SFSimulator.h"
 #include "../include/KdTree.h"
 #include "../include/Agent.h"
+#include "../include/AgentStorage.h"
 #include "../include/Obstacle.h"
+#include "../include/ScratchArena.h"
+
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif
+
+#if HAVE_OPENMP || _OPENMP
+	#include <omp.h>
+#endif
 
 namespace SF
 {
@@ -11,57 +21,150 @@ namespace SF
 	/// <param name="sim"> The simulator instance </param>
 	KdTree::KdTree(SFSimulator* sim) : 
 		agents_(), 
+		agentsAdded_(0), 
+		agentBuffer_(), 
 		agentTree_(), 
-		obstacleTree_(nullptr), 
+		isAgentTreeRefit_(false), 
+		maxAgentTreeOverlap_(0.1f), 
+		obstacleTreeExhaustiveSize_(128), 
+		obstacleTree_(), 
+		obstacleTreeDepth_(0), 
 		sim_(sim)
 	{  }
 
 	/// <summary> Destructor </summary>
-	KdTree::~KdTree()
+	KdTree::~KdTree() { }
+
+	/// <summary> Builds the agent kd-tree over the current agent positions </summary>
+	void KdTree::build()
 	{
-		deleteObstacleTree(obstacleTree_);
+		buildAgentTree();
 	}
 
 	/// <summary> Builds an agent kd-tree </summary>
 	void KdTree::buildAgentTree()
 	{
-		if (agents_.size() < sim_->agents_.size()) 
+		const auto& storage = *sim_->agentStorage_;
+		const auto builtSize = agents_.size();
+
+		if (agentsAdded_ < storage.size()) 
 		{
-			for (auto i = agents_.size(); i < sim_->agents_.size(); ++i) 
-				if (!sim_->agents_[i]->isDeleted_)
-					agents_.push_back(sim_->agents_[i]);
-			
-			agentTree_.resize(2 * agents_.size() - 1);
+			for (auto i = agentsAdded_; i < storage.size(); ++i) 
+				agents_.push_back(i);
+
+			agentsAdded_ = storage.size();
+
+			if (!agents_.empty())
+				agentTree_.resize(2 * agents_.size() - 1);
 		}
     
-		if (!agents_.empty()) 
-			buildAgentTreeRecursive(0, agents_.size(), 0);
+		if (agents_.empty()) 
+			return;
+
+		// The partition of the previous step is only reusable when no agents have been added since
+		if (isAgentTreeRefit_ && builtSize == agents_.size())
+			refitAgentTreeRecursive(0);
+		else
+		{
+#if HAVE_OPENMP || _OPENMP
+			const auto threadCount = static_cast<size_t>(omp_get_max_threads());
+#else
+			const size_t threadCount = 1;
+#endif
+
+			if (threadCount > 1 && agents_.size() >= PARALLEL_BUILD_SIZE)
+			{
+				// The top levels are split with parallel loops until there are enough subtrees to build them concurrently.
+				// The subtrees are disjoint and not empty, so there are at most as many as agents.
+				// The stable partition orders the agents unlike the serial swaps, so the tree differs from the serial one in
+				// the stepping order of the agents and in the choice among equally distant neighbors beyond maxNeighbors
+				auto& arena = sim_->getScratchArena();
+				ScratchArena::Scope scope(arena);
+
+				const auto subtrees = arena.allocate<AgentTreeTask>(agents_.size());
+				const auto cutoff = std::max(PARALLEL_BUILD_SIZE / 4, agents_.size() / (8 * threadCount));
+				size_t subtreeCount = 0;
+
+				agentBuffer_.resize(agents_.size());
+				buildAgentTreeTopRecursive(0, agents_.size(), 0, cutoff, subtrees, subtreeCount);
+
+#pragma omp parallel for schedule(dynamic)
+
+				for (int i = 0; i < static_cast<int>(subtreeCount); ++i)
+					buildAgentTreeRecursive(subtrees[i].begin, subtrees[i].end, subtrees[i].node);
+			}
+			else
+				buildAgentTreeRecursive(0, agents_.size(), 0);
+		}
 	}
 
-	/// <summary> Builds an agent kd-tree </summary>
-	/// <param name="begin"> Begin node  </param>
-	/// <param name="end"> End node  </param>
+	/// <summary> Computes the bounding box of the agents of the specified agent tree node </summary>
 	/// <param name="node"> Selected node  </param>
-	void KdTree::buildAgentTreeRecursive(size_t begin, size_t end, size_t node)
+	void KdTree::computeAgentTreeBounds(size_t node)
 	{
-		agentTree_[node].begin = begin;
-		agentTree_[node].end = end;
-		agentTree_[node].minX = agentTree_[node].maxX = agents_[begin]->position_.x();
-		agentTree_[node].minY = agentTree_[node].maxY = agents_[begin]->position_.y();
-    
-		for (auto i = begin + 1; i < end; ++i) 
+		const auto& positions = sim_->agentStorage_->positions_;
+		auto tree = agentTree_[node];
+
+		tree.minX = tree.maxX = positions[agents_[tree.begin]].x();
+		tree.minY = tree.maxY = positions[agents_[tree.begin]].y();
+
+		for (auto i = tree.begin + 1; i < tree.end; ++i) 
 		{
-			auto tree = agentTree_[node];
-			auto position = agents_[i]->position_;
+			const auto& position = positions[agents_[i]];
 
 			tree.maxX = std::max(tree.maxX, position.x());
 			tree.minX = std::min(tree.minX, position.x());
 			tree.maxY = std::max(tree.maxY, position.y());
 			tree.minY = std::min(tree.minY, position.y());
+		}
 
-			agentTree_[node] = tree;
+		agentTree_[node] = tree;
+	}
+
+	/// <summary> Updates the bounding boxes of an agent kd-tree bottom-up keeping its partition </summary>
+	/// <param name="node"> Selected node  </param>
+	void KdTree::refitAgentTreeRecursive(size_t node)
+	{
+		if (agentTree_[node].end - agentTree_[node].begin <= MAX_LEAF_SIZE) 
+		{
+			computeAgentTreeBounds(node);
+			return;
 		}
 
+		refitAgentTreeRecursive(agentTree_[node].left);
+		refitAgentTreeRecursive(agentTree_[node].right);
+
+		const auto& left = agentTree_[agentTree_[node].left];
+		const auto& right = agentTree_[agentTree_[node].right];
+		auto& tree = agentTree_[node];
+
+		tree.minX = std::min(left.minX, right.minX);
+		tree.maxX = std::max(left.maxX, right.maxX);
+		tree.minY = std::min(left.minY, right.minY);
+		tree.maxY = std::max(left.maxY, right.maxY);
+
+		// Agents crossing the split line make the children overlap; the subtree is then partitioned again
+		const auto overlapX = std::max(0.0f, std::min(left.maxX, right.maxX) - std::max(left.minX, right.minX));
+		const auto overlapY = std::max(0.0f, std::min(left.maxY, right.maxY) - std::max(left.minY, right.minY));
+		const auto area = (tree.maxX - tree.minX) * (tree.maxY - tree.minY);
+
+		if (overlapX * overlapY > maxAgentTreeOverlap_ * area)
+			buildAgentTreeRecursive(tree.begin, tree.end, node);
+	}
+
+	/// <summary> Builds an agent kd-tree </summary>
+	/// <param name="begin"> Begin node  </param>
+	/// <param name="end"> End node  </param>
+	/// <param name="node"> Selected node  </param>
+	void KdTree::buildAgentTreeRecursive(size_t begin, size_t end, size_t node)
+	{
+		const auto& positions = sim_->agentStorage_->positions_;
+
+		agentTree_[node].begin = begin;
+		agentTree_[node].end = end;
+
+		computeAgentTreeBounds(node);
+
 		if (end - begin > MAX_LEAF_SIZE) 
 		{
 			// No leaf node
@@ -73,10 +176,10 @@ namespace SF
 
 			while (left < right) 
 			{
-				while (left < right && (isVertical ? agents_[left]->position_.x() : agents_[left]->position_.y()) < splitValue) 
+				while (left < right && (isVertical ? positions[agents_[left]].x() : positions[agents_[left]].y()) < splitValue) 
 					++left;
 				
-				while (right > left && (isVertical ? agents_[right-1]->position_.x() : agents_[right-1]->position_.y()) >= splitValue)
+				while (right > left && (isVertical ? positions[agents_[right-1]].x() : positions[agents_[right-1]].y()) >= splitValue)
 					--right;
 				
 				if (left < right) 
@@ -103,35 +206,208 @@ namespace SF
 		}
 	}
 
+	/// <summary> Builds the top levels of an agent kd-tree with parallel loops and collects the remaining subtrees </summary>
+	/// <param name="begin"> Begin node  </param>
+	/// <param name="end"> End node  </param>
+	/// <param name="node"> Selected node  </param>
+	/// <param name="cutoff"> The agent count below which a subtree is deferred </param>
+	/// <param name="subtrees"> The deferred subtrees </param>
+	/// <param name="subtreeCount"> The count of deferred subtrees </param>
+	void KdTree::buildAgentTreeTopRecursive(size_t begin, size_t end, size_t node, size_t cutoff, AgentTreeTask* subtrees, size_t& subtreeCount)
+	{
+		if (end - begin <= cutoff)
+		{
+			AgentTreeTask task = { begin, end, node };
+			subtrees[subtreeCount++] = task;
+			return;
+		}
+
+		agentTree_[node].begin = begin;
+		agentTree_[node].end = end;
+
+		computeAgentTreeBoundsParallel(node);
+
+		const auto isVertical = (agentTree_[node].maxX - agentTree_[node].minX > agentTree_[node].maxY - agentTree_[node].minY);
+		const auto splitValue = (isVertical ? 0.5f * (agentTree_[node].maxX + agentTree_[node].minX) : 0.5f * (agentTree_[node].maxY + agentTree_[node].minY));
+
+		auto left = partitionAgentsParallel(begin, end, isVertical, splitValue);
+		auto leftSize = left - begin;
+
+		if (leftSize == 0) {
+			++leftSize;
+			++left;
+		}
+
+		agentTree_[node].left = node + 1;
+		agentTree_[node].right = node + 1 + (2 * leftSize - 1);
+
+		buildAgentTreeTopRecursive(begin, left, agentTree_[node].left, cutoff, subtrees, subtreeCount);
+		buildAgentTreeTopRecursive(left, end, agentTree_[node].right, cutoff, subtrees, subtreeCount);
+	}
+
+	/// <summary> Computes the bounding box of the agents of the specified agent tree node with a parallel reduction </summary>
+	/// <param name="node"> Selected node  </param>
+	void KdTree::computeAgentTreeBoundsParallel(size_t node)
+	{
+		const auto& positions = sim_->agentStorage_->positions_;
+		auto tree = agentTree_[node];
+
+		tree.minX = tree.maxX = positions[agents_[tree.begin]].x();
+		tree.minY = tree.maxY = positions[agents_[tree.begin]].y();
+
+#pragma omp parallel
+		{
+			auto local = tree;
+
+#pragma omp for nowait
+
+			for (int i = static_cast<int>(tree.begin + 1); i < static_cast<int>(tree.end); ++i)
+			{
+				const auto& position = positions[agents_[i]];
+
+				local.maxX = std::max(local.maxX, position.x());
+				local.minX = std::min(local.minX, position.x());
+				local.maxY = std::max(local.maxY, position.y());
+				local.minY = std::min(local.minY, position.y());
+			}
+
+#pragma omp critical
+			{
+				tree.maxX = std::max(tree.maxX, local.maxX);
+				tree.minX = std::min(tree.minX, local.minX);
+				tree.maxY = std::max(tree.maxY, local.maxY);
+				tree.minY = std::min(tree.minY, local.minY);
+			}
+		}
+
+		agentTree_[node] = tree;
+	}
+
+	/// <summary> Stably partitions the agents of a range by a split line with parallel loops. The serial build swaps the agents in place instead, so the agents of a node end up in a different order </summary>
+	/// <param name="begin"> Begin node  </param>
+	/// <param name="end"> End node  </param>
+	/// <param name="isVertical"> True if the split line is vertical </param>
+	/// <param name="splitValue"> The coordinate of the split line </param>
+	/// <returns> The beginning of the agents lying at or beyond the split line </returns>
+	size_t KdTree::partitionAgentsParallel(size_t begin, size_t end, bool isVertical, float splitValue)
+	{
+		const auto& positions = sim_->agentStorage_->positions_;
+
+#if HAVE_OPENMP || _OPENMP
+		const auto maxThreadCount = static_cast<size_t>(omp_get_max_threads());
+#else
+		const size_t maxThreadCount = 1;
+#endif
+
+		auto& arena = sim_->getScratchArena();
+		ScratchArena::Scope scope(arena);
+
+		const auto leftOffsets = arena.allocate<size_t>(maxThreadCount + 1);
+		const auto rightOffsets = arena.allocate<size_t>(maxThreadCount + 1);
+		std::fill(leftOffsets, leftOffsets + maxThreadCount + 1, 0);
+		std::fill(rightOffsets, rightOffsets + maxThreadCount + 1, 0);
+		size_t leftCount = 0;
+
+#pragma omp parallel
+		{
+#if HAVE_OPENMP || _OPENMP
+			const auto thread = static_cast<size_t>(omp_get_thread_num());
+			const auto threadCount = static_cast<size_t>(omp_get_num_threads());
+#else
+			const size_t thread = 0;
+			const size_t threadCount = 1;
+#endif
+
+			const auto chunk = (end - begin + threadCount - 1) / threadCount;
+			const auto chunkBegin = std::min(end, begin + thread * chunk);
+			const auto chunkEnd = std::min(end, chunkBegin + chunk);
+
+			for (auto i = chunkBegin; i < chunkEnd; ++i)
+			{
+				if ((isVertical ? positions[agents_[i]].x() : positions[agents_[i]].y()) < splitValue)
+					++leftOffsets[thread + 1];
+				else
+					++rightOffsets[thread + 1];
+			}
+
+#pragma omp barrier
+#pragma omp single
+			{
+				for (size_t t = 1; t <= threadCount; ++t)
+				{
+					leftOffsets[t] += leftOffsets[t - 1];
+					rightOffsets[t] += rightOffsets[t - 1];
+				}
+
+				leftCount = leftOffsets[threadCount];
+			}
+
+			auto leftOut = begin + leftOffsets[thread];
+			auto rightOut = begin + leftCount + rightOffsets[thread];
+
+			for (auto i = chunkBegin; i < chunkEnd; ++i)
+			{
+				if ((isVertical ? positions[agents_[i]].x() : positions[agents_[i]].y()) < splitValue)
+					agentBuffer_[leftOut++] = agents_[i];
+				else
+					agentBuffer_[rightOut++] = agents_[i];
+			}
+
+#pragma omp barrier
+#pragma omp for
+
+			for (int i = static_cast<int>(begin); i < static_cast<int>(end); ++i)
+				agents_[i] = agentBuffer_[i];
+		}
+
+		return begin + leftCount;
+	}
+
 	/// <summary> Builds an obstacle kd-tree </summary>
 	void KdTree::buildObstacleTree()
 	{
-		deleteObstacleTree(obstacleTree_);
+		obstacleTree_.clear();
+		obstacleTreeDepth_ = 0;
 
 		std::vector<Obstacle*> obstacles(sim_->obstacles_.size());
 
 		for (size_t i = 0; i < sim_->obstacles_.size(); ++i)
 			obstacles[i] = sim_->obstacles_[i];
 
-		obstacleTree_ = buildObstacleTreeRecursive(obstacles);
+		buildObstacleTreeRecursive(obstacles, 1);
 	}
 
 	/// <summary> Builds an obstacle kd-tree </summary>
 	/// <param name="obstacles"> Obstacles set  </param>
-	/// <returns> The tree </returns>
-	KdTree::ObstacleTreeNode* KdTree::buildObstacleTreeRecursive(const std::vector<Obstacle*>& obstacles)
+	/// <param name="depth"> The depth of the subtree root </param>
+	/// <returns> The node number of the subtree root, or NO_OBSTACLE_NODE when the set is empty </returns>
+	uint32_t KdTree::buildObstacleTreeRecursive(const std::vector<Obstacle*>& obstacles, size_t depth)
 	{
 		if (obstacles.empty())
-			return nullptr;
+			return NO_OBSTACLE_NODE;
+
+		// The node is appended before its subtrees, so that the tree is laid out depth-first
+		const auto node = static_cast<uint32_t>(obstacleTree_.size());
+		obstacleTree_.push_back(ObstacleTreeNode());
+		obstacleTreeDepth_ = std::max(obstacleTreeDepth_, depth);
+
+		// Large sets try only the obstacles near the median, so that a level costs linear time instead of quadratic
+		const auto isExhaustive = obstacles.size() <= obstacleTreeExhaustiveSize_ || obstacles.size() <= 2 * OBSTACLE_SPLIT_CANDIDATES;
+		std::vector<size_t> candidates;
 
-		const auto node = new ObstacleTreeNode;
+		if (!isExhaustive)
+			collectObstacleSplitCandidates(obstacles, candidates);
+
+		const auto candidateCount = isExhaustive ? obstacles.size() : candidates.size();
 
 		size_t optimalSplit = 0;
 		auto minLeft = obstacles.size();
 		auto minRight = minLeft;
 
-		for (size_t i = 0; i < obstacles.size(); ++i) 
+		for (size_t k = 0; k < candidateCount; ++k) 
 		{
+			const auto i = isExhaustive ? k : candidates[k];
+
 			size_t leftSize = 0;
 			size_t rightSize = 0;
 
@@ -171,11 +447,10 @@ namespace SF
 			}
 		}
 
-		std::vector<Obstacle*> leftObstacles(minLeft);
-		std::vector<Obstacle*> rightObstacles(minRight);
-
-		size_t leftCounter = 0;
-		size_t rightCounter = 0;
+		std::vector<Obstacle*> leftObstacles;
+		std::vector<Obstacle*> rightObstacles;
+		leftObstacles.reserve(minLeft);
+		rightObstacles.reserve(minRight);
 
 		const size_t i = optimalSplit;
 		const Obstacle* const obstacleI1 = obstacles[i];
@@ -192,38 +467,87 @@ namespace SF
 			const auto j1LeftOfI = leftOf(obstacleI1->point_, obstacleI2->point_, obstacleJ1->point_);
 			const auto j2LeftOfI = leftOf(obstacleI1->point_, obstacleI2->point_, obstacleJ2->point_);
 
+			// A segment crossing the splitting line goes whole to the side of its midpoint, and the bounding box of that side covers its part across the line
 			if (j1LeftOfI >= -SF_EPSILON && j2LeftOfI >= -SF_EPSILON)
-				leftObstacles[leftCounter++] = obstacleJ1;
+				leftObstacles.push_back(obstacleJ1);
 			else if (j1LeftOfI <= SF_EPSILON && j2LeftOfI <= SF_EPSILON) 
-				rightObstacles[rightCounter++] = obstacleJ1;
-			else 
-			{
-				if(j1LeftOfI + j2LeftOfI > 0)
-				{
-					leftObstacles[leftCounter++] = obstacleJ1;
-					rightObstacles[rightCounter++] = obstacleJ2;
-				}
-				else
-				{
-					leftObstacles[leftCounter++] = obstacleJ2;
-					rightObstacles[rightCounter++] = obstacleJ1;
-				}
-			}
+				rightObstacles.push_back(obstacleJ1);
+			else if (j1LeftOfI + j2LeftOfI > 0.0f)
+				leftObstacles.push_back(obstacleJ1);
+			else
+				rightObstacles.push_back(obstacleJ1);
 		}
 
-		node->obstacle = obstacleI1;
-		node->left = buildObstacleTreeRecursive(leftObstacles);
-		node->right = buildObstacleTreeRecursive(rightObstacles);
+		const auto left = buildObstacleTreeRecursive(leftObstacles, depth + 1);
+		const auto right = buildObstacleTreeRecursive(rightObstacles, depth + 1);
+
+		auto& treeNode = obstacleTree_[node];
+		treeNode.point1 = obstacleI1->point_;
+		treeNode.point2 = obstacleI2->point_;
+		treeNode.lengthSq = absSq(obstacleI2->point_ - obstacleI1->point_);
+		treeNode.obstacle = static_cast<uint32_t>(obstacleI1->id_);
+		treeNode.left = left;
+		treeNode.right = right;
+
+		// The box of the segment is padded relative to its coordinates, so that rounding in the traversals never prunes a segment touching a query exactly
+		const auto margin = SF_EPSILON * (1.0f + std::max(std::max(std::fabs(treeNode.point1.x()), std::fabs(treeNode.point2.x())), std::max(std::fabs(treeNode.point1.y()), std::fabs(treeNode.point2.y()))));
+
+		treeNode.maxX = std::max(treeNode.point1.x(), treeNode.point2.x()) + margin;
+		treeNode.maxY = std::max(treeNode.point1.y(), treeNode.point2.y()) + margin;
+		treeNode.minX = std::min(treeNode.point1.x(), treeNode.point2.x()) - margin;
+		treeNode.minY = std::min(treeNode.point1.y(), treeNode.point2.y()) - margin;
+
+		for (const auto child : { left, right })
+		{
+			if (child == NO_OBSTACLE_NODE)
+				continue;
+
+			const auto& childNode = obstacleTree_[child];
+			treeNode.maxX = std::max(treeNode.maxX, childNode.maxX);
+			treeNode.maxY = std::max(treeNode.maxY, childNode.maxY);
+			treeNode.minX = std::min(treeNode.minX, childNode.minX);
+			treeNode.minY = std::min(treeNode.minY, childNode.minY);
+		}
 
 		return node;
 	}
 
+	/// <summary> Collects the obstacles tried as the splitter of a large obstacle set, taken around the median of the segment midpoints along both axes </summary>
+	/// <param name="obstacles"> Obstacles set  </param>
+	/// <param name="candidates"> The numbers of the candidate obstacles in the set </param>
+	void KdTree::collectObstacleSplitCandidates(const std::vector<Obstacle*>& obstacles, std::vector<size_t>& candidates) const
+	{
+		const auto count = obstacles.size();
+		const auto bandBegin = (count - OBSTACLE_SPLIT_CANDIDATES) / 2;
+		const auto bandEnd = bandBegin + OBSTACLE_SPLIT_CANDIDATES;
+
+		std::vector<std::pair<float, size_t>> keys(count);
+
+		// A segment across an axis splits its set near the median when its midpoint lies near the median along that axis
+		for (auto axis = 0; axis < 2; ++axis)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				const auto midpoint = obstacles[i]->point_ + obstacles[i]->nextObstacle->point_;
+				keys[i] = std::make_pair(axis == 0 ? midpoint.x() : midpoint.y(), i);
+			}
+
+			std::nth_element(keys.begin(), keys.begin() + bandBegin, keys.end());
+			std::nth_element(keys.begin() + bandBegin, keys.begin() + bandEnd, keys.end());
+			std::sort(keys.begin() + bandBegin, keys.begin() + bandEnd);
+
+			for (auto i = bandBegin; i < bandEnd; ++i)
+				candidates.push_back(keys[i].second);
+		}
+	}
+
 	/// <summary> Computes the agent neighbors of the specified agent </summary>
 	/// <param name="agent"> A pointer to the agent for which agent neighbors are to be computed </param>
 	/// <param name="rangeSq"> The squared range around the agent </param>
 	void KdTree::computeAgentNeighbors(Agent* agent, float& rangeSq) const
 	{
-		queryAgentTreeRecursive(agent, rangeSq, 0);
+		if (!agents_.empty())
+			queryAgentTreeRecursive(agent, rangeSq, 0);
 	}
 
 	/// <summary> Computes the agent ID neighbors of the specified agent </summary>
@@ -231,7 +555,24 @@ namespace SF
 	/// <param name="rangeSq"> The squared range around the agent </param>
 	void KdTree::computeAgentNeighborsIndexList(Agent* agent, float& rangeSq) const
 	{
-		queryAgentNeighborsIndexListTreeRecursive(agent, rangeSq, 0);
+		if (!agents_.empty())
+			queryAgentNeighborsIndexListTreeRecursive(agent, rangeSq, 0);
+	}
+
+	/// <summary> Collects the unsorted agent neighbor candidates of the specified agent </summary>
+	/// <param name="agent"> A pointer to the agent for which agent neighbor candidates are to be collected </param>
+	/// <param name="rangeSq"> The squared range around the agent </param>
+	void KdTree::computeAgentNeighborCandidates(Agent* agent, float rangeSq) const
+	{
+		if (!agents_.empty())
+			queryAgentNeighborCandidatesTreeRecursive(agent, rangeSq, 0);
+	}
+
+	/// <summary> Returns the storage slots of the indexed agents in the leaf order of the agent tree </summary>
+	/// <returns> The agent slots </returns>
+	const std::vector<size_t>& KdTree::getAgentOrder() const
+	{
+		return agents_;
 	}
 
 	/// <summary> Computes the obstacle neighbors of the specified agent </summary>
@@ -239,21 +580,99 @@ namespace SF
 	/// <param name="rangeSq"> The squared range around the agent </param>
 	void KdTree::computeObstacleNeighbors(Agent* agent, float rangeSq) const
 	{
-		queryObstacleTreeRecursive(agent, rangeSq, obstacleTree_);
-	}
+		if (obstacleTree_.empty())
+			return;
 
-	/// <summary> Deletes the specified obstacle tree node </summary>
-	/// <param name="agent"> A pointer to the obstacle tree node to be deleted </param>
-	void KdTree::deleteObstacleTree(ObstacleTreeNode* node) const
-	{
-		if (node != nullptr) 
+		uint32_t localStack[OBSTACLE_STACK_SIZE];
+		std::vector<uint32_t> heapStack;
+		const auto stack = getObstacleTreeStack(localStack, heapStack);
+
+		const auto& position = agent->position_;
+
+		size_t stackSize = 0;
+		stack[stackSize++] = 0;
+
+		// A node is skipped with its subtree when the agent is out of range of their bounding box. The nodes are visited in stack order rather than near side first,
+		// so segments at equal distances, such as two walls meeting at the vertex nearest to the agent, may be listed in another order than the recursive search listed them
+		while (stackSize > 0)
 		{
-			deleteObstacleTree(node->left);
-			deleteObstacleTree(node->right);
-			delete node;
+			const auto& node = obstacleTree_[stack[--stackSize]];
+
+			const auto distSqBox = sqr(std::max(0.0f, node.minX - position.x())) + sqr(std::max(0.0f, position.x() - node.maxX)) + sqr(std::max(0.0f, node.minY - position.y())) + sqr(std::max(0.0f, position.y() - node.maxY));
+
+			if (distSqBox >= rangeSq)
+				continue;
+
+			if (sqr(leftOf(node.point1, node.point2, position)) / node.lengthSq < rangeSq)
+				agent->insertObstacleNeighbor(node.obstacle, node.point1, node.point2, rangeSq);
+
+			if (node.left != NO_OBSTACLE_NODE)
+				stack[stackSize++] = node.left;
+
+			if (node.right != NO_OBSTACLE_NODE)
+				stack[stackSize++] = node.right;
 		}
 	}
 
+	/// <summary> Tests whether a line segment widened by a radius may reach the segments of an obstacle tree node, which it cannot when it is separated from their bounding box along an axis or along the normal of the segment </summary>
+	/// <param name="node"> The obstacle tree node </param>
+	/// <param name="q1"> The first endpoint of the line segment </param>
+	/// <param name="q2"> The second endpoint of the line segment </param>
+	/// <param name="radius"> The radius widening the line segment </param>
+	/// <returns> True if the widened line segment overlaps the bounding box of the node; false otherwise </returns>
+	bool KdTree::isObstacleNodeReached(const ObstacleTreeNode& node, const Vector2& q1, const Vector2& q2, float radius)
+	{
+		const auto minX = node.minX - radius;
+		const auto minY = node.minY - radius;
+		const auto maxX = node.maxX + radius;
+		const auto maxY = node.maxY + radius;
+
+		if (std::max(q1.x(), q2.x()) < minX || std::min(q1.x(), q2.x()) > maxX || std::max(q1.y(), q2.y()) < minY || std::min(q1.y(), q2.y()) > maxY)
+			return false;
+
+		// The corners of the box lie on both sides of the line of the segment unless the center is farther from it than the half extent of the box along its normal
+		const auto normalX = q1.y() - q2.y();
+		const auto normalY = q2.x() - q1.x();
+		const auto centerOffset = normalX * (0.5f * (minX + maxX) - q1.x()) + normalY * (0.5f * (minY + maxY) - q1.y());
+		const auto halfExtent = 0.5f * (maxX - minX) * std::fabs(normalX) + 0.5f * (maxY - minY) * std::fabs(normalY);
+
+		return std::fabs(centerOffset) <= halfExtent;
+	}
+
+	/// <summary> Tests whether an obstacle tree node blocks the visibility between two points, which it does when they cross its segment from right to left and the segments intersect or come within the radius </summary>
+	/// <param name="node"> The obstacle tree node </param>
+	/// <param name="q1"> The first point between which visibility is to be tested </param>
+	/// <param name="q2"> The second point between which visibility is to be tested </param>
+	/// <param name="radiusSq"> The squared radius within which visibility is to be tested </param>
+	/// <returns> True if the segment of the node blocks the visibility; false otherwise </returns>
+	bool KdTree::isObstacleNodeBlocking(const ObstacleTreeNode& node, const Vector2& q1, const Vector2& q2, float radiusSq)
+	{
+		// One can see through obstacle from left to right, but not from right to left. Only the segments intersecting or coming within the radius block, so that no segment outside the widened line segment does
+		if (leftOf(node.point1, node.point2, q1) >= 0.0f || leftOf(node.point1, node.point2, q2) <= 0.0f)
+			return false;
+
+		return leftOf(q1, q2, node.point1) * leftOf(q1, q2, node.point2) <= 0.0f
+			|| distSqPointLineSegment(q1, q2, node.point1) <= radiusSq
+			|| distSqPointLineSegment(q1, q2, node.point2) <= radiusSq
+			|| distSqPointLineSegment(node.point1, node.point2, q1) <= radiusSq
+			|| distSqPointLineSegment(node.point1, node.point2, q2) <= radiusSq;
+	}
+
+	/// <summary> Returns the stack for traversing the obstacle tree, which is the local buffer unless the tree is too deep for it </summary>
+	/// <param name="localStack"> The local buffer of OBSTACLE_STACK_SIZE node numbers </param>
+	/// <param name="heapStack"> The buffer grown when the tree is too deep </param>
+	/// <returns> A pointer to the stack </returns>
+	uint32_t* KdTree::getObstacleTreeStack(uint32_t* localStack, std::vector<uint32_t>& heapStack) const
+	{
+		// A traversal keeps at most the two children of a node on each level
+		if (2 * obstacleTreeDepth_ <= OBSTACLE_STACK_SIZE)
+			return localStack;
+
+		heapStack.resize(2 * obstacleTreeDepth_);
+
+		return heapStack.data();
+	}
+
 	/// <summary> Inserts the specified agent tree node </summary>
 	/// <param name="agent"> A pointer to the agent for which agent neighbors are to be inserted </param>
 	/// <param name="rangeSq"> The squared range around the agent </param>
@@ -262,11 +681,10 @@ namespace SF
 	{
 		if (agentTree_[node].end - agentTree_[node].begin <= MAX_LEAF_SIZE) 
 		{
+			const auto& positions = sim_->agentStorage_->positions_;
+
 			for (auto i = agentTree_[node].begin; i < agentTree_[node].end; ++i) 
-			{
-				if(!(agents_[i]->isDeleted_))
-					agent->insertAgentNeighbor(agents_[i], rangeSq);
-			}
+				agent->insertAgentNeighbor(agents_[i], absSq(agent->position_ - positions[agents_[i]]), rangeSq);
 		} 
 		else 
 		{
@@ -305,8 +723,10 @@ namespace SF
 	{
 		if (agentTree_[node].end - agentTree_[node].begin <= MAX_LEAF_SIZE) 
 		{
+			const auto& positions = sim_->agentStorage_->positions_;
+
 			for (auto i = agentTree_[node].begin; i < agentTree_[node].end; ++i) 
-				agent->insertAgentNeighborsIndex(agents_[i], rangeSq);
+				agent->insertAgentNeighborsIndex(agents_[i], absSq(agent->position_ - positions[agents_[i]]), rangeSq);
 		} 
 		else 
 		{
@@ -337,27 +757,33 @@ namespace SF
 		}
 	}
 
-	/// <summary> Inserts the specified obstacle tree node </summary>
-	/// <param name="agent"> A pointer to the agent for which obstacle neighbors are to be computed </param>
+	/// <summary> Inserts the agent neighbor candidates of the specified agent tree node </summary>
+	/// <param name="agent"> A pointer to the agent for which agent neighbor candidates are to be inserted </param>
 	/// <param name="rangeSq"> The squared range around the agent </param>
 	/// <param name="node"> The specified node </param>
-	void KdTree::queryObstacleTreeRecursive(Agent* agent, float rangeSq, const ObstacleTreeNode* node) const
+	void KdTree::queryAgentNeighborCandidatesTreeRecursive(Agent* agent, float rangeSq, size_t node) const
 	{
-		if (node == nullptr)
-			return;
-		
-		const auto obstacle1 = node->obstacle;
-		const auto obstacle2 = obstacle1->nextObstacle;
-		const auto agentLeftOfLine = leftOf(obstacle1->point_, obstacle2->point_, agent->position_);
-
-		queryObstacleTreeRecursive(agent, rangeSq, (agentLeftOfLine >= 0.0f ? node->left : node->right));
-			
-		const auto distSqLine = sqr(agentLeftOfLine) / absSq(obstacle2->point_ - obstacle1->point_);
+		if (agentTree_[node].end - agentTree_[node].begin <= MAX_LEAF_SIZE) 
+		{
+			const auto& positions = sim_->agentStorage_->positions_;
 
-		if (distSqLine < rangeSq) 
+			for (auto i = agentTree_[node].begin; i < agentTree_[node].end; ++i) 
+				agent->insertAgentNeighborCandidate(agents_[i], absSq(agent->position_ - positions[agents_[i]]), rangeSq);
+		} 
+		else 
 		{
-			agent->insertObstacleNeighbor(node->obstacle, rangeSq);
-			queryObstacleTreeRecursive(agent, rangeSq, (agentLeftOfLine >= 0.0f ? node->right : node->left));
+			const auto& left = agentTree_[agentTree_[node].left];
+			const auto& right = agentTree_[agentTree_[node].right];
+
+			const auto distSqLeft = sqr(std::max(0.0f, left.minX - agent->position_.x())) + sqr(std::max(0.0f, agent->position_.x() - left.maxX)) + sqr(std::max(0.0f, left.minY - agent->position_.y())) + sqr(std::max(0.0f, agent->position_.y() - left.maxY));
+
+			const auto distSqRight = sqr(std::max(0.0f, right.minX - agent->position_.x())) + sqr(std::max(0.0f, agent->position_.x() - right.maxX)) + sqr(std::max(0.0f, right.minY - agent->position_.y())) + sqr(std::max(0.0f, agent->position_.y() - right.maxY));
+
+			if (distSqLeft < rangeSq) 
+				queryAgentNeighborCandidatesTreeRecursive(agent, rangeSq, agentTree_[node].left);
+
+			if (distSqRight < rangeSq) 
+				queryAgentNeighborCandidatesTreeRecursive(agent, rangeSq, agentTree_[node].right);
 		}
 	}
 
@@ -368,43 +794,123 @@ namespace SF
 	/// <returns> True if q1 and q2 are mutually visible within the radius; false otherwise </returns>
 	bool KdTree::queryVisibility(const Vector2& q1, const Vector2& q2, float radius) const
 	{
-		return queryVisibilityRecursive(q1, q2, radius, obstacleTree_);
+		if (obstacleTree_.empty())
+			return true;
+
+		uint32_t localStack[OBSTACLE_STACK_SIZE];
+		std::vector<uint32_t> heapStack;
+
+		return queryVisibility(q1, q2, radius, getObstacleTreeStack(localStack, heapStack));
 	}
 
-	/// <summary> Queries the visibility between two points within a specified radius </summary>
+	/// <summary> Queries the visibility between two points within a specified radius, traversing the obstacle tree with the specified stack </summary>
 	/// <param name="q1"> The first point between which visibility is to be tested </param>
 	/// <param name="q2"> The second point between which visibility is to be tested </param>
-	/// <param name="node"> The selected node </param>
 	/// <param name="radius"> The radius within which visibility is to be tested </param>
+	/// <param name="stack"> The traversal stack returned by getObstacleTreeStack </param>
 	/// <returns> True if q1 and q2 are mutually visible within the radius; false otherwise </returns>
-	bool KdTree::queryVisibilityRecursive(const Vector2& q1, const Vector2& q2, float radius, const ObstacleTreeNode* node) const
+	bool KdTree::queryVisibility(const Vector2& q1, const Vector2& q2, float radius, uint32_t* stack) const
 	{
-		if (node == nullptr) 
-			return true;
-		else 
+		const auto radiusSq = sqr(radius);
+
+		size_t stackSize = 0;
+		stack[stackSize++] = 0;
+
+		// The points are visible when no visited node blocks them, so the nodes are checked in any order until one does. A node is skipped with its subtree when the widened line segment misses their bounding box
+		while (stackSize > 0)
 		{
-			const auto obstacle1 = node->obstacle;
-			const auto obstacle2 = obstacle1->nextObstacle;
-
-			const auto q1LeftOfI = leftOf(obstacle1->point_, obstacle2->point_, q1);
-			const auto q2LeftOfI = leftOf(obstacle1->point_, obstacle2->point_, q2);
-			const auto invLengthI = 1.0f / absSq(obstacle2->point_ - obstacle1->point_);
-
-			if (q1LeftOfI >= 0.0f && q2LeftOfI >= 0.0f)
-				return queryVisibilityRecursive(q1, q2, radius, node->left) && ((sqr(q1LeftOfI) * invLengthI >= sqr(radius) && sqr(q2LeftOfI) * invLengthI >= sqr(radius)) || queryVisibilityRecursive(q1, q2, radius, node->right));
-			else if (q1LeftOfI <= 0.0f && q2LeftOfI <= 0.0f) 
-				return queryVisibilityRecursive(q1, q2, radius, node->right) && ((sqr(q1LeftOfI) * invLengthI >= sqr(radius) && sqr(q2LeftOfI) * invLengthI >= sqr(radius)) || queryVisibilityRecursive(q1, q2, radius, node->left));
-			else if (q1LeftOfI >= 0.0f && q2LeftOfI <= 0.0f)
-				// One can see through obstacle from left to right
-				return queryVisibilityRecursive(q1, q2, radius, node->left) && queryVisibilityRecursive(q1, q2, radius, node->right);
-			else 
-			{
-				const auto point1LeftOfQ = leftOf(q1, q2, obstacle1->point_);
-				const auto point2LeftOfQ = leftOf(q1, q2, obstacle2->point_);
-				const auto invLengthQ = 1.0f / absSq(q2 - q1);
+			const auto& node = obstacleTree_[stack[--stackSize]];
 
-				return (point1LeftOfQ * point2LeftOfQ >= 0.0f && sqr(point1LeftOfQ) * invLengthQ > sqr(radius) && sqr(point2LeftOfQ) * invLengthQ > sqr(radius) && queryVisibilityRecursive(q1, q2, radius, node->left) && queryVisibilityRecursive(q1, q2, radius, node->right));
-			}
+			if (!isObstacleNodeReached(node, q1, q2, radius))
+				continue;
+
+			if (isObstacleNodeBlocking(node, q1, q2, radiusSq))
+				return false;
+
+			if (node.left != NO_OBSTACLE_NODE)
+				stack[stackSize++] = node.left;
+
+			if (node.right != NO_OBSTACLE_NODE)
+				stack[stackSize++] = node.right;
 		}
+
+		return true;
+	}
+
+	/// <summary> Queries the visibility between up to 64 pairs of points within their radii, traversing the obstacle tree for the pairs one after another with one stack </summary>
+	/// <param name="points1"> The first points of the pairs </param>
+	/// <param name="points2"> The second points of the pairs </param>
+	/// <param name="radii"> The radii of the pairs, or nullptr for zero radii </param>
+	/// <param name="count"> The count of pairs, at most 64 </param>
+	/// <returns> The mask with the bit of each pair, in the order of the pairs from the lowest bit, set when its points are mutually visible </returns>
+	uint64_t KdTree::queryVisibilities(const Vector2* points1, const Vector2* points2, const float* radii, size_t count) const
+	{
+		auto visible = count < 64 ? (uint64_t(1) << count) - 1 : ~uint64_t(0);
+
+		if (obstacleTree_.empty() || count == 0)
+			return visible;
+
+		uint32_t localStack[OBSTACLE_STACK_SIZE];
+		std::vector<uint32_t> heapStack;
+		const auto stack = getObstacleTreeStack(localStack, heapStack);
+
+		// A pair reaches only the few nodes whose bounding boxes its widened segment overlaps, so nearby pairs traversed in turn find these nodes in cache and take the same branches, which interleaving the pairs at each node would lose
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!queryVisibility(points1[i], points2[i], radii != nullptr ? radii[i] : 0.0f, stack))
+				visible &= ~(uint64_t(1) << i);
+		}
+
+		return visible;
+	}
+
+	/// <summary> Sweeps a circle along the specified displacement against the obstacles, visiting only the nodes whose segments the swept circle may reach </summary>
+	/// <param name="from"> The starting center of the circle </param>
+	/// <param name="displacement"> The displacement of the center </param>
+	/// <param name="radius"> The radius of the circle </param>
+	/// <param name="time"> The fraction of the displacement at the earliest contact so far, lowered when an obstacle is touched before it </param>
+	/// <param name="normal"> The unit normal of the earliest contact, pointing from the obstacle to the circle </param>
+	/// <returns> True if an obstacle is touched before the earliest contact so far </returns>
+	bool KdTree::querySweep(const Vector2& from, const Vector2& displacement, float radius, float& time, Vector2& normal) const
+	{
+		if (obstacleTree_.empty())
+			return false;
+
+		uint32_t localStack[OBSTACLE_STACK_SIZE];
+		std::vector<uint32_t> heapStack;
+		const auto stack = getObstacleTreeStack(localStack, heapStack);
+
+		const auto to = from + displacement;
+		const auto radiusSq = sqr(radius);
+		auto hasContact = false;
+
+		size_t stackSize = 0;
+		stack[stackSize++] = 0;
+
+		// A node is skipped with its subtree when the circle swept up to the earliest contact so far misses their bounding box, and its segment when the whole sweep stays farther than the radius on one side of it
+		while (stackSize > 0)
+		{
+			const auto& node = obstacleTree_[stack[--stackSize]];
+
+			if (!isObstacleNodeReached(node, from, from + time * displacement, radius))
+				continue;
+
+			const auto fromLeftOfI = leftOf(node.point1, node.point2, from);
+			const auto toLeftOfI = leftOf(node.point1, node.point2, to);
+			const auto invLengthI = 1.0f / node.lengthSq;
+			const auto isFar = sqr(fromLeftOfI) * invLengthI >= radiusSq && sqr(toLeftOfI) * invLengthI >= radiusSq;
+			const auto isOneSide = (fromLeftOfI <= 0.0f && toLeftOfI <= 0.0f) || (fromLeftOfI >= 0.0f && toLeftOfI >= 0.0f);
+
+			if (!(isFar && isOneSide) && sweepCircleLineSegment(from, displacement, radius, node.point1, node.point2, time, normal))
+				hasContact = true;
+
+			if (node.left != NO_OBSTACLE_NODE)
+				stack[stackSize++] = node.left;
+
+			if (node.right != NO_OBSTACLE_NODE)
+				stack[stackSize++] = node.right;
+		}
+
+		return hasContact;
 	}
 }
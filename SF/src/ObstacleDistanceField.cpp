@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <cmath>
+
+#include "../include/ObstacleDistanceField.h"
+#include "../include/SFSimulator.h"
+#include "../include/Agent.h"
+#include "../include/ObstacleSegments.h"
+
+namespace SF
+{
+	/// <summary> Constructs a disabled distance field </summary>
+	/// <param name="sim"> The simulator instance </param>
+	ObstacleDistanceField::ObstacleDistanceField(SFSimulator* sim) :
+		cellSize_(0.0f),
+		maxDistance_(0.0f),
+		minX_(0.0f),
+		minY_(0.0f),
+		columns_(0),
+		rows_(0),
+		distances_(),
+		boundDistances_(),
+		segmentNos_(),
+		twinSegmentNos_(),
+		sim_(sim)
+	{ }
+
+	/// <summary> Destructor </summary>
+	ObstacleDistanceField::~ObstacleDistanceField() { }
+
+	/// <summary> Samples the distances to the processed obstacle segments on the grid, unless the field is disabled </summary>
+	void ObstacleDistanceField::build()
+	{
+		const auto& segments = *sim_->obstacleSegments_;
+		const auto count = segments.staticCount_;
+
+		distances_.clear();
+		boundDistances_.clear();
+		segmentNos_.clear();
+		twinSegmentNos_.clear();
+		columns_ = 0;
+		rows_ = 0;
+
+		if (cellSize_ <= 0.0f || !(maxDistance_ > 0.0f) || count == 0)
+			return;
+
+		auto minX = segments.startX_[0];
+		auto minY = segments.startY_[0];
+		auto maxX = minX;
+		auto maxY = minY;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			minX = std::min(minX, segments.startX_[i]);
+			minY = std::min(minY, segments.startY_[i]);
+			maxX = std::max(maxX, segments.startX_[i]);
+			maxY = std::max(maxY, segments.startY_[i]);
+		}
+
+		// The grid reaches the max distance beyond the segments, so that every point off the grid is farther than it from all segments
+		minX_ = minX - maxDistance_;
+		minY_ = minY - maxDistance_;
+		columns_ = static_cast<size_t>(std::ceil((maxX - minX + 2 * maxDistance_) / cellSize_)) + 1;
+		rows_ = static_cast<size_t>(std::ceil((maxY - minY + 2 * maxDistance_) / cellSize_)) + 1;
+
+		// The interpolation needs 2 x 2 nodes, which a positive max distance only misses with an infinite cell size
+		if (columns_ < 2 || rows_ < 2)
+		{
+			columns_ = 0;
+			rows_ = 0;
+
+			return;
+		}
+
+		const auto nodeCount = columns_ * rows_;
+
+		distances_.resize(nodeCount);
+		boundDistances_.assign(nodeCount, maxDistance_);
+		segmentNos_.assign(nodeCount * NODE_SEGMENTS, static_cast<uint32_t>(NO_SEGMENT));
+		twinSegmentNos_.assign(count, static_cast<uint32_t>(NO_SEGMENT));
+
+		// The two segments of a two-vertex obstacle lie on each other, so they count as one segment
+		for (size_t i = 0; i + 1 < count; ++i)
+		{
+			const auto isPolygonStart = segments.polygonNos_[i] == i;
+			const auto isPair = isPolygonStart && segments.polygonNos_[i + 1] == i && (i + 2 == count || segments.polygonNos_[i + 2] != i);
+
+			if (isPair)
+			{
+				twinSegmentNos_[i] = static_cast<uint32_t>(i + 1);
+				twinSegmentNos_[i + 1] = static_cast<uint32_t>(i);
+			}
+		}
+
+		std::vector<float> nodeDistances(nodeCount * NODE_SEGMENTS, maxDistance_);
+
+		for (size_t i = 0; i < count; ++i)
+			addSegment(static_cast<uint32_t>(i), nodeDistances);
+
+		for (size_t i = 0; i < nodeCount; ++i)
+			distances_[i] = nodeDistances[i * NODE_SEGMENTS];
+
+		signInsideNodes();
+	}
+
+	/// <summary> Adds the specified segment to the nearest segments of the grid nodes within the max distance from it </summary>
+	/// <param name="segmentNo"> The number of the segment </param>
+	/// <param name="nodeDistances"> The distances to the nearest segments of each node, in the layout of the segment numbers </param>
+	void ObstacleDistanceField::addSegment(uint32_t segmentNo, std::vector<float>& nodeDistances)
+	{
+		const auto& segments = *sim_->obstacleSegments_;
+		const auto start = segments.getStart(segmentNo);
+		const auto end = segments.getEnd(segmentNo);
+		const auto twinNo = twinSegmentNos_[segmentNo];
+
+		const auto minColumn = static_cast<size_t>(std::max(0.0f, std::floor((std::min(start.x(), end.x()) - maxDistance_ - minX_) / cellSize_)));
+		const auto minRow = static_cast<size_t>(std::max(0.0f, std::floor((std::min(start.y(), end.y()) - maxDistance_ - minY_) / cellSize_)));
+		const auto maxColumn = std::min(columns_ - 1, static_cast<size_t>(std::ceil((std::max(start.x(), end.x()) + maxDistance_ - minX_) / cellSize_)));
+		const auto maxRow = std::min(rows_ - 1, static_cast<size_t>(std::ceil((std::max(start.y(), end.y()) + maxDistance_ - minY_) / cellSize_)));
+
+		for (auto row = minRow; row <= maxRow; ++row)
+		{
+			for (auto column = minColumn; column <= maxColumn; ++column)
+			{
+				const auto node = row * columns_ + column;
+				const auto point = Vector2(minX_ + column * cellSize_, minY_ + row * cellSize_);
+				const auto distance = std::sqrt(distSqPointLineSegment(start, end, point));
+
+				if (distance >= boundDistances_[node])
+					continue;
+
+				const auto ids = &segmentNos_[node * NODE_SEGMENTS];
+				const auto distances = &nodeDistances[node * NODE_SEGMENTS];
+
+				// The twin of a kept segment lies on it, so the node keeps only one of them
+				if (twinNo != NO_SEGMENT && std::find(ids, ids + NODE_SEGMENTS, twinNo) != ids + NODE_SEGMENTS)
+					continue;
+
+				auto k = static_cast<size_t>(std::upper_bound(distances, distances + NODE_SEGMENTS, distance) - distances);
+
+				// A node keeping as many segments as it can drops the farthest one, whose distance bounds those of the dropped segments
+				if (k == NODE_SEGMENTS)
+				{
+					boundDistances_[node] = distance;
+					continue;
+				}
+
+				if (ids[NODE_SEGMENTS - 1] != NO_SEGMENT)
+					boundDistances_[node] = distances[NODE_SEGMENTS - 1];
+
+				for (auto m = NODE_SEGMENTS - 1; m > k; --m)
+				{
+					ids[m] = ids[m - 1];
+					distances[m] = distances[m - 1];
+				}
+
+				ids[k] = segmentNo;
+				distances[k] = distance;
+			}
+		}
+	}
+
+	/// <summary> Negates the distances of the grid nodes lying inside the obstacle polygons by the parity of the segment crossings along each row </summary>
+	void ObstacleDistanceField::signInsideNodes()
+	{
+		const auto& segments = *sim_->obstacleSegments_;
+
+		std::vector<std::vector<float>> crossings(rows_);
+
+		for (size_t i = 0; i < segments.staticCount_; ++i)
+		{
+			const auto y1 = segments.startY_[i];
+			const auto y2 = segments.endY_[i];
+
+			if (y1 == y2)
+				continue;
+
+			// A row crosses the segment when it lies in the half-open span of its y-coordinates, so that a shared vertex counts once
+			const auto lowY = std::min(y1, y2);
+			const auto highY = std::max(y1, y2);
+			const auto firstRow = static_cast<size_t>(std::max(0.0f, std::ceil((lowY - minY_) / cellSize_)));
+
+			for (auto row = firstRow; row < rows_; ++row)
+			{
+				const auto y = minY_ + row * cellSize_;
+
+				if (y >= highY)
+					break;
+
+				if (y < lowY)
+					continue;
+
+				const auto t = (y - y1) / (y2 - y1);
+				crossings[row].push_back(segments.startX_[i] + t * (segments.endX_[i] - segments.startX_[i]));
+			}
+		}
+
+		for (size_t row = 0; row < rows_; ++row)
+		{
+			auto& rowCrossings = crossings[row];
+			std::sort(rowCrossings.begin(), rowCrossings.end());
+
+			// The nodes between the crossings of odd and even rank lie inside
+			for (size_t k = 0; k + 1 < rowCrossings.size(); k += 2)
+			{
+				const auto firstColumn = static_cast<size_t>(std::max(0.0f, std::ceil((rowCrossings[k] - minX_) / cellSize_)));
+
+				for (auto column = firstColumn; column < columns_ && minX_ + column * cellSize_ < rowCrossings[k + 1]; ++column)
+					distances_[row * columns_ + column] = -distances_[row * columns_ + column];
+			}
+		}
+	}
+
+	/// <summary> Computes the obstacle neighbors of the specified agent from the nearest grid node, when the segments it keeps are all those that may lie within range </summary>
+	/// <param name="agent"> A pointer to the agent for which obstacle neighbors are to be computed </param>
+	/// <param name="rangeSq"> The squared range around the agent </param>
+	/// <returns> False if the field is disabled or more segments may lie within range, so that the obstacle tree has to be queried </returns>
+	bool ObstacleDistanceField::computeObstacleNeighbors(Agent* agent, float rangeSq) const
+	{
+		if (distances_.empty())
+			return false;
+
+		const auto range = std::sqrt(rangeSq);
+		const auto column = (agent->position_.x() - minX_) / cellSize_ + 0.5f;
+		const auto row = (agent->position_.y() - minY_) / cellSize_ + 0.5f;
+
+		if (column < 0.0f || row < 0.0f || column >= columns_ || row >= rows_)
+			return range < maxDistance_;
+
+		const auto node = static_cast<size_t>(row) * columns_ + static_cast<size_t>(column);
+
+		// The distances to the segments change by at most the distance to the nearest node, which is half of the cell diagonal
+		if (boundDistances_[node] - cellSize_ * 0.7072f <= range)
+			return false;
+
+		const auto& segments = *sim_->obstacleSegments_;
+		const auto ids = &segmentNos_[node * NODE_SEGMENTS];
+
+		for (size_t k = 0; k < NODE_SEGMENTS && ids[k] != NO_SEGMENT; ++k)
+		{
+			agent->insertObstacleNeighbor(ids[k], segments.getStart(ids[k]), segments.getEnd(ids[k]), rangeSq);
+
+			const auto twinNo = twinSegmentNos_[ids[k]];
+
+			if (twinNo != NO_SEGMENT)
+				agent->insertObstacleNeighbor(twinNo, segments.getStart(twinNo), segments.getEnd(twinNo), rangeSq);
+		}
+
+		return true;
+	}
+
+	/// <summary> Interpolates the signed distance to the obstacles at the specified point </summary>
+	/// <param name="point"> The point </param>
+	/// <param name="gradient"> The gradient of the interpolated distance </param>
+	/// <returns> The distance, negative inside the obstacles, or the max distance outside the grid </returns>
+	float ObstacleDistanceField::interpolate(const Vector2& point, Vector2& gradient) const
+	{
+		gradient = Vector2();
+
+		if (distances_.empty())
+			return maxDistance_;
+
+		const auto x = (point.x() - minX_) / cellSize_;
+		const auto y = (point.y() - minY_) / cellSize_;
+
+		if (x < 0.0f || y < 0.0f || x > columns_ - 1 || y > rows_ - 1)
+			return maxDistance_;
+
+		const auto column = std::min(static_cast<size_t>(x), columns_ - 2);
+		const auto row = std::min(static_cast<size_t>(y), rows_ - 2);
+		const auto fx = x - column;
+		const auto fy = y - row;
+
+		const auto d00 = distances_[row * columns_ + column];
+		const auto d10 = distances_[row * columns_ + column + 1];
+		const auto d01 = distances_[(row + 1) * columns_ + column];
+		const auto d11 = distances_[(row + 1) * columns_ + column + 1];
+
+		const auto bottom = d00 + fx * (d10 - d00);
+		const auto top = d01 + fx * (d11 - d01);
+
+		gradient = Vector2(((d10 - d00) * (1 - fy) + (d11 - d01) * fy) / cellSize_, (top - bottom) / cellSize_);
+
+		return bottom + fy * (top - bottom);
+	}
+
+	/// <summary> Returns the nearest obstacle segment of the grid node nearest to the specified point </summary>
+	/// <param name="point"> The point </param>
+	/// <returns> The number of the segment, or NO_SEGMENT when all segments are farther than the max distance </returns>
+	uint32_t ObstacleDistanceField::getNearestSegment(const Vector2& point) const
+	{
+		if (distances_.empty())
+			return NO_SEGMENT;
+
+		const auto column = (point.x() - minX_) / cellSize_ + 0.5f;
+		const auto row = (point.y() - minY_) / cellSize_ + 0.5f;
+
+		if (column < 0.0f || row < 0.0f || column >= columns_ || row >= rows_)
+			return NO_SEGMENT;
+
+		return segmentNos_[(static_cast<size_t>(row) * columns_ + static_cast<size_t>(column)) * NODE_SEGMENTS];
+	}
+}
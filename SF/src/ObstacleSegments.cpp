@@ -0,0 +1,93 @@
+#include "../include/ObstacleSegments.h"
+#include "../include/Obstacle.h"
+
+namespace SF
+{
+	/// <summary> Constructs an empty segment table </summary>
+	ObstacleSegments::ObstacleSegments() :
+		startX_(),
+		startY_(),
+		endX_(),
+		endY_(),
+		polygonNos_(),
+		staticCount_(0)
+	{ }
+
+	/// <summary> Destructor </summary>
+	ObstacleSegments::~ObstacleSegments() { }
+
+	/// <summary> Fills the table with the segments starting at the specified obstacle vertices </summary>
+	/// <param name="obstacles"> The obstacle vertices in the order they have been added, with the vertices of each polygon in a row </param>
+	void ObstacleSegments::build(const std::vector<Obstacle*>& obstacles)
+	{
+		const auto count = obstacles.size();
+
+		resize(count);
+		staticCount_ = count;
+
+		size_t polygonNo = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const auto obstacle = obstacles[i];
+
+			startX_[i] = obstacle->point_.x();
+			startY_[i] = obstacle->point_.y();
+			endX_[i] = obstacle->nextObstacle->point_.x();
+			endY_[i] = obstacle->nextObstacle->point_.y();
+			polygonNos_[i] = polygonNo;
+
+			// The last vertex of a polygon closes it back to the first one, and the next polygon starts after it
+			if (obstacle->nextObstacle->id_ == polygonNo)
+				polygonNo = i + 1;
+		}
+	}
+
+	/// <summary> Sets the count of segments, keeping the first ones </summary>
+	/// <param name="count"> The count of segments </param>
+	void ObstacleSegments::resize(size_t count)
+	{
+		startX_.resize(count);
+		startY_.resize(count);
+		endX_.resize(count);
+		endY_.resize(count);
+		polygonNos_.resize(count);
+	}
+
+	/// <summary> Sets the specified segment </summary>
+	/// <param name="segmentNo"> The number of the segment </param>
+	/// <param name="start"> The first endpoint </param>
+	/// <param name="end"> The second endpoint </param>
+	/// <param name="polygonNo"> The number of the first segment of the polygon </param>
+	void ObstacleSegments::set(size_t segmentNo, const Vector2& start, const Vector2& end, size_t polygonNo)
+	{
+		startX_[segmentNo] = start.x();
+		startY_[segmentNo] = start.y();
+		endX_[segmentNo] = end.x();
+		endY_[segmentNo] = end.y();
+		polygonNos_[segmentNo] = polygonNo;
+	}
+
+	/// <summary> Returns the first endpoint of the specified segment </summary>
+	/// <param name="segmentNo"> The number of the segment </param>
+	/// <returns> The first endpoint </returns>
+	Vector2 ObstacleSegments::getStart(size_t segmentNo) const
+	{
+		return Vector2(startX_[segmentNo], startY_[segmentNo]);
+	}
+
+	/// <summary> Returns the second endpoint of the specified segment </summary>
+	/// <param name="segmentNo"> The number of the segment </param>
+	/// <returns> The second endpoint </returns>
+	Vector2 ObstacleSegments::getEnd(size_t segmentNo) const
+	{
+		return Vector2(endX_[segmentNo], endY_[segmentNo]);
+	}
+
+	/// <summary> Returns the count of segments in the table </summary>
+	/// <returns> The count of segments </returns>
+	size_t ObstacleSegments::size() const
+	{
+		return startX_.size();
+	}
+}
@@ -1,7 +1,17 @@
+#include <algorithm>
+
 #include "../include/SFSimulator.h"
 #include "../include/Agent.h"
+#include "../include/AgentGrid.h"
+#include "../include/AgentGroups.h"
+#include "../include/AgentStorage.h"
+#include "../include/DynamicObstacles.h"
+#include "../include/ForceKernels.h"
 #include "../include/KdTree.h"
 #include "../include/Obstacle.h"
+#include "../include/ObstacleDistanceField.h"
+#include "../include/ObstacleSegments.h"
+#include "../include/ScratchArena.h"
 #include "../include/AgentPropertyConfig.h"
 #include "../include/RotationDegreeSet.h"
 
@@ -16,6 +26,20 @@
 
 namespace SF
 {
+	/// <summary> Spreads the low 16 bits of a number to the even bits, for interleaving two numbers into a Z-order code </summary>
+	/// <param name="value"> The number </param>
+	/// <returns> The spread bits </returns>
+	static uint32_t spreadBits(uint32_t value)
+	{
+		value &= 0xFFFF;
+		value = (value | value << 8) & 0x00FF00FF;
+		value = (value | value << 4) & 0x0F0F0F0F;
+		value = (value | value << 2) & 0x33333333;
+		value = (value | value << 1) & 0x55555555;
+
+		return value;
+	}
+
 	/// <summary> Constructs a simulator instance </summary>
 	SFSimulator::SFSimulator() :
 		rotationPast_(),
@@ -24,18 +48,51 @@ namespace SF
 		rotationNow2Future_(),
 		rotationFuture_(),
 		agents_(),
+		agentStorage_(nullptr),
 		defaultAgent_(nullptr),
 		globalTime_(0.0f),
 		kdTree_(nullptr),
+		agentGrid_(nullptr),
+		agentGroups_(nullptr),
+		agentGroupExactSize_(8),
+		agentNeighborSearch_(nullptr),
+		neighborSearchType_(KD_TREE),
+		neighborSkin_(0.0f),
+		instructionSet_(SCALAR),
+		mathMode_(PRECISE),
+		repulsiveAgentKernel_(nullptr),
+		closestPointKernel_(nullptr),
+		repulsiveObstacleKernel_(nullptr),
+		movingPlatformKernel_(nullptr),
+		isNeighborCandidateStale_(true),
+		isNeighborCandidateUpdate_(true),
+		isCompactionPending_(false),
+		freeAgentNumbers_(),
+		removedAgentNumbers_(),
 		obstacles_(),
+		obstacleSegments_(nullptr),
+		obstacleDistanceField_(nullptr),
+		dynamicObstacles_(nullptr),
+		isObstacleSweep_(false),
+		scratchArenas_(),
 		timeStep_(1.0f),
 		platformVelocity_(),
+		previousPlatformVelocity_(),
+		platformFrame_(),
 		platformRotationXY_(0),
 		platformRotationXZ_(0),
 		platformRotationYZ_(0),
 		IsMovingPlatform(false)
 	{
+		agentStorage_ = new AgentStorage();
+		obstacleSegments_ = new ObstacleSegments();
+		obstacleDistanceField_ = new ObstacleDistanceField(this);
+		dynamicObstacles_ = new DynamicObstacles(this);
+		setInstructionSet(getSupportedInstructionSet());
 		kdTree_ = new KdTree(this);
+		agentGrid_ = new AgentGrid(this);
+		agentGroups_ = new AgentGroups(this);
+		agentNeighborSearch_ = kdTree_;
 	}
 
 	/// <summary> Destroys this simulator instance </summary>
@@ -49,7 +106,16 @@ namespace SF
 		for (size_t i = 0; i < obstacles_.size(); ++i)
 			delete obstacles_[i];
 
+		for (size_t i = 0; i < scratchArenas_.size(); ++i)
+			delete scratchArenas_[i];
+
+		delete agentGroups_;
+		delete agentGrid_;
 		delete kdTree_;
+		delete agentStorage_;
+		delete dynamicObstacles_;
+		delete obstacleDistanceField_;
+		delete obstacleSegments_;
 	}
 
 	/// <summary> Returns the count of agent neighbors taken into account to compute the current velocity for the specified agent </summary>
@@ -60,22 +126,35 @@ namespace SF
 		return agents_[agentNo]->agentNeighbors_.size();
 	}
 
+	/// <summary> Builds the agent neighbor index over the current agent positions, as each simulation step does before the agents query it. When deleted agents are released first, the agent neighbor lists are emptied until the next step </summary>
+	void SFSimulator::buildAgentNeighborIndex()
+	{
+		if (isCompactionPending_)
+			compactAgents();
+
+		resetScratchArenas();
+		agentNeighborSearch_->build();
+	}
+
 	/// <summary> Returns the specified agent neighbor of the specified agent </summary>
 	/// <param name="agentNo"> The number of the agent whose agent neighbor is to be retrieved </param>
 	/// <param name="neighborNo"> The number of the agent neighbor to be retrieved </param>
 	/// <returns> The number of the neighboring agent </returns>
 	size_t SFSimulator::getAgentAgentNeighbor(size_t agentNo, size_t neighborNo) const
 	{
-		return agents_[agentNo]->agentNeighbors_[neighborNo].second->id_;
+		return agentStorage_->agents_[agents_[agentNo]->agentNeighbors_[neighborNo].second]->id_;
 	}
 
 	/// <summary> Returns the specified obstacle neighbor of the specified agent </summary>
 	/// <param name="agentNo"> The number of the agent whose obstacle neighbor is to be retrieved </param>
 	/// <param name="neighborNo"> The number of the obstacle neighbor to be retrieved </param>
-	/// <returns> The number of the first vertex of the neighboring obstacle edge </returns>
+	/// <returns> The number of the first vertex of the neighboring obstacle edge, or SF::SF_ERROR when the edge belongs to a dynamic obstacle, whose edges are not obstacle vertices </returns>
 	size_t SFSimulator::getAgentObstacleNeighbor(size_t agentNo, size_t neighborNo) const
 	{
-		return agents_[agentNo]->obstacleNeighbors_[neighborNo].second->id_;
+		const auto segmentNo = agents_[agentNo]->obstacleNeighbors_[neighborNo].second;
+
+		// The segments of the dynamic obstacles follow those of the obstacle vertices in the segment table
+		return segmentNo < obstacleSegments_->staticCount_ ? segmentNo : SF_ERROR;
 	}
 
 	/// <summary> Returns the count of obstacle neighbors taken into account to compute the current velocity for the specified agent </summary>
@@ -94,6 +173,106 @@ namespace SF
 		if (defaultAgent_ == 0)
 			return SF_ERROR;
 
+		auto agent = createDefaultAgent(position);
+
+		agent->id_ = agents_.size();
+
+		agents_.push_back(agent);
+		agentStorage_->add(agent);
+		isNeighborCandidateStale_ = true;
+
+		return agents_.size() - 1;
+	}
+
+	/// <summary> Spawns a new agent with default properties, reusing the number of a removed agent when available </summary>
+	/// <param name="position"> The two-dimensional starting position of this agent </param>
+	/// <returns> The handle of the agent, with SF::SF_ERROR as the number when the agent defaults have not been set </returns>
+	AgentHandle SFSimulator::spawnAgent(const Vector2& position)
+	{
+		AgentHandle handle = { SF_ERROR, 0 };
+
+		if (defaultAgent_ == nullptr)
+			return handle;
+
+		auto agent = createDefaultAgent(position);
+
+		if (freeAgentNumbers_.empty())
+		{
+			agent->id_ = agents_.size();
+			agents_.push_back(agent);
+		}
+		else
+		{
+			agent->id_ = freeAgentNumbers_.back();
+			agent->generation_ = agents_[agent->id_]->generation_;
+			freeAgentNumbers_.pop_back();
+
+			delete agents_[agent->id_];
+			agents_[agent->id_] = agent;
+		}
+
+		agentStorage_->add(agent);
+		isNeighborCandidateStale_ = true;
+
+		handle.agentNo = agent->id_;
+		handle.generation = agent->generation_;
+
+		return handle;
+	}
+
+	/// <summary> Spawns new agents with default properties, reusing the numbers of removed agents when available </summary>
+	/// <param name="positions"> The two-dimensional starting positions of the agents </param>
+	/// <returns> The handles of the agents in the order of the positions </returns>
+	std::vector<AgentHandle> SFSimulator::addAgents(const std::vector<Vector2>& positions)
+	{
+		std::vector<AgentHandle> handles;
+		handles.reserve(positions.size());
+
+		for (const auto& position : positions)
+			handles.push_back(spawnAgent(position));
+
+		return handles;
+	}
+
+	/// <summary> Removes the specified agent; it leaves the simulation on the next step, when the other agents stop being attracted to it, after which its number may be reused </summary>
+	/// <param name="handle"> The handle of the agent, ignored when no longer valid </param>
+	void SFSimulator::removeAgent(const AgentHandle& handle)
+	{
+		if (!isAgentHandleValid(handle))
+			return;
+
+		deleteAgent(handle.agentNo);
+
+		++agents_[handle.agentNo]->generation_;
+		removedAgentNumbers_.push_back(handle.agentNo);
+	}
+
+	/// <summary> Removes the specified agents; they leave the simulation on the next step, when the other agents stop being attracted to them, after which their numbers may be reused </summary>
+	/// <param name="handles"> The handles of the agents, ignored when no longer valid </param>
+	void SFSimulator::removeAgents(const std::vector<AgentHandle>& handles)
+	{
+		for (const auto& handle : handles)
+			removeAgent(handle);
+	}
+
+	/// <summary> Checks whether the specified handle still refers to a live agent </summary>
+	/// <param name="handle"> The handle of the agent </param>
+	/// <returns> True if the agent has been neither removed nor deleted </returns>
+	bool SFSimulator::isAgentHandleValid(const AgentHandle& handle) const
+	{
+		if (handle.agentNo >= agents_.size())
+			return false;
+
+		const auto agent = agents_[handle.agentNo];
+
+		return agent->generation_ == handle.generation && !agent->isDeleted_;
+	}
+
+	/// <summary> Creates an agent with default properties </summary>
+	/// <param name="position"> The two-dimensional starting position of this agent </param>
+	/// <returns> A pointer to the agent, not yet numbered </returns>
+	Agent* SFSimulator::createDefaultAgent(const Vector2& position)
+	{
 		auto agent = new Agent(this);
 
 		agent->position_ = position;
@@ -114,11 +293,7 @@ namespace SF
 		agent->perception_ = defaultAgent_->perception_;
 		agent->friction_ = defaultAgent_->friction_;
 
-		agent->id_ = agents_.size();
-
-		agents_.push_back(agent);
-
-		return agents_.size() - 1;
+		return agent;
 	}
 
 	/// <summary> Adds a new agent to the simulation </summary>
@@ -183,6 +358,8 @@ namespace SF
 		agent->id_ = agents_.size();
 
 		agents_.push_back(agent);
+		agentStorage_->add(agent);
+		isNeighborCandidateStale_ = true;
 
 		return agents_.size() - 1;
 	}
@@ -233,7 +410,16 @@ namespace SF
 	{
 		size_t s = agents_.size();
 
-		kdTree_->buildAgentTree();
+		if (isCompactionPending_)
+			compactAgents();
+
+		resetScratchArenas();
+		agentGroups_->update();
+
+		isNeighborCandidateUpdate_ = isNeighborCandidateUpdateNeeded();
+
+		if (isNeighborCandidateUpdate_)
+			agentNeighborSearch_->build();
 
 		if (agents_.size() > 0)
 		{
@@ -241,22 +427,42 @@ namespace SF
 			addPlatformRotationYZ(getRotationDegreeSet().getRotationOX());
 		}
 
+		if (IsMovingPlatform)
+		{
+			updatePlatformFrame();
+			computeMovingPlatformForces();
+		}
+
+		// Agents are processed in the order of the spatial index, so that the queries of consecutive agents touch the same nodes
+		const auto& agentOrder = agentNeighborSearch_->getAgentOrder();
+
 #pragma omp parallel for
 
-		for (int i = 0; i < static_cast<size_t>(agents_.size()); ++i)
+		for (int i = 0; i < static_cast<int>(agentOrder.size()); ++i)
 		{
-			if (!(agents_[i]->isDeleted_))
-			{
-				agents_[i]->computeNeighbors();
-				agents_[i]->computeNewVelocity();
-			}
+			auto agent = agentStorage_->agents_[agentOrder[i]];
+
+			agent->computeNeighbors();
+			agent->computeNewVelocity();
+		}
+
+		if (neighborSkin_ > 0.0f && isNeighborCandidateUpdate_)
+		{
+			agentStorage_->candidatePositions_ = agentStorage_->positions_;
+			isNeighborCandidateStale_ = false;
 		}
 
 #pragma omp parallel for
 
-		for (int i = 0; i < static_cast<size_t>(agents_.size()); ++i)
-			if(!(agents_[i]->isDeleted_))
-				agents_[i]->update();
+		for (int i = 0; i < static_cast<int>(agentStorage_->size()); ++i)
+		{
+			auto agent = agentStorage_->agents_[i];
+
+			agent->update();
+
+			agentStorage_->positions_[i] = agent->position_;
+			agentStorage_->velocities_[i] = agent->velocity_;
+		}
 
 		globalTime_ += timeStep_;
 	}
@@ -269,6 +475,14 @@ namespace SF
 		return agents_[agentNo]->maxNeighbors_;
 	}
 
+	/// <summary> Returns the maximum obstacle neighbor count of a specified agent </summary>
+	/// <param name="agentNo"> The number of the agent whose maximum obstacle neighbor count is to be retrieved </param>
+	/// <returns> The present maximum obstacle neighbor count of the agent, SF::SF_ERROR when unbounded </returns>
+	size_t SFSimulator::getAgentMaxObstacleNeighbors(size_t agentNo) const
+	{
+		return agents_[agentNo]->maxObstacleNeighbors_;
+	}
+
 	/// <summary> Returns the maximum speed of a specified agent </summary>
 	/// <param name="agentNo"> The number of the agent whose maximum speed is to be retrieved </param>
 	/// <returns> The present maximum speed of the agent </returns>
@@ -380,17 +594,222 @@ namespace SF
 	/// <summary> Processes the obstacles that have been added so that they are accounted for in the simulation </summary>
 	void SFSimulator::processObstacles() const
 	{
+		obstacleSegments_->build(obstacles_);
+		dynamicObstacles_->writeSegments();
+		obstacleDistanceField_->build();
 		kdTree_->buildObstacleTree();
 	}
 
+	/// <summary> Sets the distance field of the obstacles, sampled on a grid over the scene bounds when the obstacles are processed. Each grid node keeps its four nearest segments, so that agents near a node with no other segment within range take their obstacle neighbors from it instead of querying the obstacle tree; agents near junctions of more segments still query the tree </summary>
+	/// <param name="cellSize"> The spacing of the grid nodes; not positive to disable the field, as by default </param>
+	/// <param name="maxDistance"> The distance up to which the field is exact, which should exceed the obstacle range timeHorizonObst * maxSpeed + radius of the agents; not positive to disable the field </param>
+	void SFSimulator::setObstacleDistanceField(float cellSize, float maxDistance)
+	{
+		obstacleDistanceField_->cellSize_ = cellSize;
+		obstacleDistanceField_->maxDistance_ = maxDistance;
+		obstacleDistanceField_->build();
+	}
+
+	/// <summary> Interpolates the signed distance to the obstacles at the specified point from the distance field </summary>
+	/// <param name="point"> The point </param>
+	/// <returns> The distance, negative inside the obstacles, or the max distance of the field beyond its grid or when it is disabled </returns>
+	float SFSimulator::getObstacleDistance(const Vector2& point) const
+	{
+		Vector2 gradient;
+
+		return obstacleDistanceField_->interpolate(point, gradient);
+	}
+
+	/// <summary> Returns the gradient of the interpolated signed distance to the obstacles at the specified point </summary>
+	/// <param name="point"> The point </param>
+	/// <returns> The gradient, zero beyond the grid of the distance field or when it is disabled </returns>
+	Vector2 SFSimulator::getObstacleDistanceGradient(const Vector2& point) const
+	{
+		Vector2 gradient;
+		obstacleDistanceField_->interpolate(point, gradient);
+
+		return gradient;
+	}
+
+	/// <summary> Returns the nearest obstacle segment of the distance field node nearest to the specified point </summary>
+	/// <param name="point"> The point </param>
+	/// <returns> The number of the first vertex of the segment, or SF::SF_ERROR when all segments are farther than the max distance of the field or when it is disabled </returns>
+	size_t SFSimulator::getNearestObstacleSegment(const Vector2& point) const
+	{
+		const auto segmentNo = obstacleDistanceField_->getNearestSegment(point);
+
+		return segmentNo == ObstacleDistanceField::NO_SEGMENT ? SF_ERROR : segmentNo;
+	}
+
+	/// <summary> Adds an enabled dynamic obstacle, which can be removed, disabled and moved at runtime without processing the obstacles again. Dynamic obstacles are searched by their bounding boxes apart from the obstacle tree, so they suit doors, gates and barriers in the tens to hundreds </summary>
+	/// <param name="vertices"> List of the vertices of the polygonal obstacle in counterclockwise order </param>
+	/// <returns> The number of the dynamic obstacle, or SF::SF_ERROR when the number of vertices is less than two </returns>
+	size_t SFSimulator::addDynamicObstacle(const std::vector<Vector2>& vertices)
+	{
+		return dynamicObstacles_->add(vertices);
+	}
+
+	/// <summary> Removes the specified dynamic obstacle; its segments are released when the obstacles are processed </summary>
+	/// <param name="obstacleNo"> The number of the dynamic obstacle </param>
+	void SFSimulator::removeDynamicObstacle(size_t obstacleNo)
+	{
+		dynamicObstacles_->remove(obstacleNo);
+	}
+
+	/// <summary> Enables or disables the specified dynamic obstacle, as when opening or closing a door </summary>
+	/// <param name="obstacleNo"> The number of the dynamic obstacle, ignored when removed </param>
+	/// <param name="isEnabled"> True to let the obstacle take part in the simulation </param>
+	void SFSimulator::setDynamicObstacleEnabled(size_t obstacleNo, bool isEnabled)
+	{
+		dynamicObstacles_->setEnabled(obstacleNo, isEnabled);
+	}
+
+	/// <summary> Returns whether the specified dynamic obstacle takes part in the simulation </summary>
+	/// <param name="obstacleNo"> The number of the dynamic obstacle </param>
+	/// <returns> True if the obstacle is enabled and not removed </returns>
+	bool SFSimulator::isDynamicObstacleEnabled(size_t obstacleNo) const
+	{
+		return dynamicObstacles_->obstacles_[obstacleNo].isEnabled;
+	}
+
+	/// <summary> Moves the specified dynamic obstacle by the specified displacement </summary>
+	/// <param name="obstacleNo"> The number of the dynamic obstacle, ignored when removed </param>
+	/// <param name="displacement"> The displacement of the vertices </param>
+	void SFSimulator::translateDynamicObstacle(size_t obstacleNo, const Vector2& displacement)
+	{
+		dynamicObstacles_->setOffset(obstacleNo, dynamicObstacles_->obstacles_[obstacleNo].offset + displacement);
+	}
+
+	/// <summary> Returns the count of dynamic obstacles added to the simulation, including the removed ones </summary>
+	/// <returns> The count of dynamic obstacles </returns>
+	size_t SFSimulator::getNumDynamicObstacles() const
+	{
+		return dynamicObstacles_->obstacles_.size();
+	}
+
 	/// <summary> Performs a visibility query between the two specified points with respect to the obstacles </summary>
 	/// <param name="point1"> The first point of the query </param>
 	/// <param name="point2"> The second point of the query </param>
-	/// <param name="radius"> The minimal distance between the line connecting the two points and the obstacles in order for the points to be mutually visible(optional). Must be non - negative </param>
+	/// <param name="radius"> The minimal distance between the line segment connecting the two points and the obstacles in order for the points to be mutually visible(optional). Must be non - negative </param>
 	/// <returns> A boolean specifying whether the two points are mutually visible. Returns true when the obstacles have not been processed </returns>
 	bool SFSimulator::queryVisibility(const Vector2& point1, const Vector2& point2, float radius) const
 	{
-		return kdTree_->queryVisibility(point1, point2, radius);
+		return kdTree_->queryVisibility(point1, point2, radius) && dynamicObstacles_->queryVisibility(point1, point2, radius);
+	}
+
+	/// <summary> Performs the visibility queries between the specified pairs of points in parallel, with the same results as queryVisibility. The pairs are ordered along a Z-order curve of their midpoints and tested 64 at a time by a thread in turn, so that successive pairs find the nodes they visit in cache </summary>
+	/// <param name="points1"> The first points of the queries </param>
+	/// <param name="points2"> The second points of the queries, as many as the first points </param>
+	/// <param name="radii"> The radii of the queries, as many as the first points, or empty for zero radii </param>
+	/// <returns> The mask of mutually visible pairs, packed 64 pairs per word from the lowest bit, so that the pair i is visible when the bit i % 64 of the word i / 64 is set. Empty when the second points or the radii do not match the first points in count </returns>
+	std::vector<uint64_t> SFSimulator::queryVisibilities(const std::vector<Vector2>& points1, const std::vector<Vector2>& points2, const std::vector<float>& radii) const
+	{
+		const auto count = points1.size();
+
+		if (points2.size() != count || (!radii.empty() && radii.size() != count))
+			return std::vector<uint64_t>();
+
+		const auto wordCount = static_cast<int>((count + 63) / 64);
+		const auto hasRadii = !radii.empty();
+		const auto hasDynamicObstacles = !dynamicObstacles_->enabledNos_.empty();
+
+		// The pairs are counting sorted by the Z-order code of the cell of their midpoint on a grid of up to 256 x 256 cells, so that each packet of 64 pairs covers a few neighboring cells
+		std::vector<uint32_t> order(count);
+
+		if (count > 64)
+		{
+			auto minX = points1[0].x() + points2[0].x();
+			auto minY = points1[0].y() + points2[0].y();
+			auto maxX = minX;
+			auto maxY = minY;
+
+			for (size_t i = 1; i < count; ++i)
+			{
+				const auto x = points1[i].x() + points2[i].x();
+				const auto y = points1[i].y() + points2[i].y();
+
+				minX = std::min(minX, x);
+				minY = std::min(minY, y);
+				maxX = std::max(maxX, x);
+				maxY = std::max(maxY, y);
+			}
+
+			// About 4 pairs per cell at the least
+			uint32_t levels = 1;
+
+			while (levels < 8 && (static_cast<size_t>(1) << (2 * levels + 4)) <= count)
+				++levels;
+
+			const auto cellCount = static_cast<size_t>(1) << (2 * levels);
+			const auto maxCell = static_cast<float>((1 << levels) - 1);
+			const auto scaleX = maxX > minX ? maxCell / (maxX - minX) : 0.0f;
+			const auto scaleY = maxY > minY ? maxCell / (maxY - minY) : 0.0f;
+
+			std::vector<uint32_t> codes(count);
+			std::vector<size_t> offsets(cellCount + 1);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const auto x = static_cast<uint32_t>((points1[i].x() + points2[i].x() - minX) * scaleX);
+				const auto y = static_cast<uint32_t>((points1[i].y() + points2[i].y() - minY) * scaleY);
+
+				codes[i] = spreadBits(x) | spreadBits(y) << 1;
+				++offsets[codes[i] + 1];
+			}
+
+			for (size_t cell = 0; cell < cellCount; ++cell)
+				offsets[cell + 1] += offsets[cell];
+
+			for (size_t i = 0; i < count; ++i)
+				order[offsets[codes[i]]++] = static_cast<uint32_t>(i);
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i)
+				order[i] = static_cast<uint32_t>(i);
+		}
+
+		std::vector<uint64_t> sortedVisible(wordCount);
+
+		// Each packet of 64 sorted pairs is tested by one thread with one traversal stack
+#pragma omp parallel for schedule(dynamic, 16)
+
+		for (int word = 0; word < wordCount; ++word)
+		{
+			const auto begin = static_cast<size_t>(word) * 64;
+			const auto size = std::min(count - begin, static_cast<size_t>(64));
+
+			Vector2 packet1[64];
+			Vector2 packet2[64];
+			float packetRadii[64];
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				const auto pairNo = order[begin + i];
+
+				packet1[i] = points1[pairNo];
+				packet2[i] = points2[pairNo];
+				packetRadii[i] = hasRadii ? radii[pairNo] : 0.0f;
+			}
+
+			auto mask = kdTree_->queryVisibilities(packet1, packet2, packetRadii, size);
+
+			for (size_t i = 0; hasDynamicObstacles && i < size; ++i)
+			{
+				if ((mask >> i & 1) != 0 && !dynamicObstacles_->queryVisibility(packet1[i], packet2[i], packetRadii[i]))
+					mask &= ~(uint64_t(1) << i);
+			}
+
+			sortedVisible[word] = mask;
+		}
+
+		// The bits are moved back to the order of the pairs, within a mask small enough to stay in cache
+		std::vector<uint64_t> visible(wordCount);
+
+		for (size_t i = 0; i < count; ++i)
+			visible[order[i] / 64] |= (sortedVisible[i / 64] >> (i % 64) & 1) << (order[i] % 64);
+
+		return visible;
 	}
 
 	/// <summary> Sets default property of agent</summary>
@@ -425,6 +844,15 @@ namespace SF
 	void SFSimulator::setAgentMaxNeighbors(size_t agentNo, size_t maxNeighbors)
 	{
 		agents_[agentNo]->maxNeighbors_ = maxNeighbors;
+		isNeighborCandidateStale_ = true;
+	}
+
+	/// <summary> Sets the maximum obstacle neighbor count of a specified agent; the nearest obstacles are kept </summary>
+	/// <param name="agentNo"> The number of the agent whose maximum obstacle neighbor count is to be modified </param>
+	/// <param name="maxObstacleNeighbors"> The replacement maximum obstacle neighbor count, SF::SF_ERROR for no limit </param>
+	void SFSimulator::setAgentMaxObstacleNeighbors(size_t agentNo, size_t maxObstacleNeighbors)
+	{
+		agents_[agentNo]->maxObstacleNeighbors_ = maxObstacleNeighbors;
 	}
 
 	/// <summary> Sets the maximum speed of a specified agent </summary>
@@ -433,6 +861,7 @@ namespace SF
 	void SFSimulator::setAgentMaxSpeed(size_t agentNo, float maxSpeed)
 	{
 		agents_[agentNo]->maxSpeed_ = maxSpeed;
+		agentStorage_->store(agents_[agentNo]);
 	}
 
 	/// <summary> Sets the maximum neighbor distance of a specified agent </summary>
@@ -441,6 +870,8 @@ namespace SF
 	void SFSimulator::setAgentNeighborDist(size_t agentNo, float neighborDist)
 	{
 		agents_[agentNo]->neighborDist_ = neighborDist;
+		agentStorage_->store(agents_[agentNo]);
+		isNeighborCandidateStale_ = true;
 	}
 
 	/// <summary> Sets the two-dimensional position of a specified agent </summary>
@@ -449,6 +880,7 @@ namespace SF
 	void SFSimulator::setAgentPosition(size_t agentNo, const Vector2& position)
 	{
 		agents_[agentNo]->position_ = position;
+		agentStorage_->store(agents_[agentNo]);
 	}
 
 	/// <summary> Sets the two-dimensional preferred velocity of a specified agent </summary>
@@ -457,6 +889,7 @@ namespace SF
 	void SFSimulator::setAgentPrefVelocity(size_t agentNo, const Vector2& prefVelocity)
 	{
 		agents_[agentNo]->prefVelocity_ = prefVelocity;
+		agentStorage_->store(agents_[agentNo]);
 	}
 
 	/// <summary> Sets the radius of a specified agent </summary>
@@ -465,6 +898,7 @@ namespace SF
 	void SFSimulator::setAgentRadius(size_t agentNo, float radius)
 	{
 		agents_[agentNo]->radius_ = radius;
+		agentStorage_->store(agents_[agentNo]);
 	}
 
 	/// <summary> Sets the time horizon of a specified agent with respect to obstacles </summary>
@@ -481,6 +915,129 @@ namespace SF
 	void SFSimulator::setAgentVelocity(size_t agentNo, const Vector2& velocity)
 	{
 		agents_[agentNo]->velocity_ = velocity;
+		agentStorage_->store(agents_[agentNo]);
+	}
+
+	/// <summary> Sets the spatial index used for agent neighbor queries </summary>
+	/// <param name="type"> The neighbor search type, SFSimulator::KD_TREE by default </param>
+	void SFSimulator::setNeighborSearchType(NeighborSearchType type)
+	{
+		neighborSearchType_ = type;
+
+		if (type == UNIFORM_GRID)
+			agentNeighborSearch_ = agentGrid_;
+		else
+			agentNeighborSearch_ = kdTree_;
+
+		isNeighborCandidateStale_ = true;
+	}
+
+	/// <summary> Returns the spatial index used for agent neighbor queries </summary>
+	/// <returns> The neighbor search type </returns>
+	SFSimulator::NeighborSearchType SFSimulator::getNeighborSearchType() const
+	{
+		return neighborSearchType_;
+	}
+
+	/// <summary> Sets the instruction set used by the force kernels. The widest one supported by the CPU is used by default </summary>
+	/// <param name="instructionSet"> The instruction set, narrowed to the widest supported one. SFSimulator::SCALAR reproduces the results of the per-neighbor computation exactly, and the others stay within 1e-6 relative error of it on each agent in the precise math mode </param>
+	void SFSimulator::setInstructionSet(InstructionSet instructionSet)
+	{
+		instructionSet_ = std::min(instructionSet, getSupportedInstructionSet());
+		repulsiveAgentKernel_ = getRepulsiveAgentKernel(instructionSet_, mathMode_);
+		closestPointKernel_ = getClosestPointKernel(instructionSet_);
+		repulsiveObstacleKernel_ = getRepulsiveObstacleKernel(instructionSet_, mathMode_);
+		movingPlatformKernel_ = getMovingPlatformKernel(instructionSet_);
+	}
+
+	/// <summary> Returns the instruction set used by the force kernels </summary>
+	/// <returns> The instruction set </returns>
+	SFSimulator::InstructionSet SFSimulator::getInstructionSet() const
+	{
+		return instructionSet_;
+	}
+
+	/// <summary> Sets the math mode used by the repulsive force kernels, SFSimulator::PRECISE by default </summary>
+	/// <param name="mathMode"> The math mode </param>
+	void SFSimulator::setMathMode(MathMode mathMode)
+	{
+		mathMode_ = mathMode;
+		setInstructionSet(instructionSet_);
+	}
+
+	/// <summary> Returns the math mode used by the repulsive force kernels </summary>
+	/// <returns> The math mode </returns>
+	SFSimulator::MathMode SFSimulator::getMathMode() const
+	{
+		return mathMode_;
+	}
+
+	/// <summary> Sets the skin of the cached agent neighbor candidates. The candidates within the neighbor distance extended by the skin, and the spatial index, are only updated once an agent has moved farther than half of the skin </summary>
+	/// <param name="skin"> The neighbor skin, zero to query the neighbors on each step. Must be non - negative </param>
+	void SFSimulator::setNeighborSkin(float skin)
+	{
+		neighborSkin_ = skin;
+		isNeighborCandidateStale_ = true;
+	}
+
+	/// <summary> Returns the skin of the cached agent neighbor candidates </summary>
+	/// <returns> The neighbor skin, zero when the neighbors are queried on each step </returns>
+	float SFSimulator::getNeighborSkin() const
+	{
+		return neighborSkin_;
+	}
+
+	/// <summary> Checks whether the cached agent neighbor candidates must be updated on the current step </summary>
+	/// <returns> True if an agent may have moved into the neighbor distance of another agent not among its candidates </returns>
+	bool SFSimulator::isNeighborCandidateUpdateNeeded() const
+	{
+		if (neighborSkin_ <= 0.0f || isNeighborCandidateStale_)
+			return true;
+
+		const auto& storage = *agentStorage_;
+		const auto maxDisplacementSq = sqr(0.5f * neighborSkin_);
+
+		// Two agents approaching each other by at most half of the skin each cannot cross the skin
+		for (size_t i = 0; i < storage.size(); ++i)
+			if (absSq(storage.positions_[i] - storage.candidatePositions_[i]) > maxDisplacementSq)
+				return true;
+
+		return false;
+	}
+
+	/// <summary> Sets whether the agent kd-tree is refitted instead of rebuilt on each step </summary>
+	/// <param name="refit"> True to keep the partition of the previous step and update only the bounding boxes </param>
+	void SFSimulator::setAgentTreeRefit(bool refit)
+	{
+		kdTree_->isAgentTreeRefit_ = refit;
+	}
+
+	/// <summary> Sets the overlap that triggers the rebuild of a refitted agent kd-tree node </summary>
+	/// <param name="maxOverlap"> The maximal ratio of the area shared by the bounding boxes of the node children to the area of the node bounding box. Must be non - negative </param>
+	void SFSimulator::setAgentTreeMaxOverlap(float maxOverlap)
+	{
+		kdTree_->maxAgentTreeOverlap_ = maxOverlap;
+	}
+
+	/// <summary> Sets the obstacle count up to which a node of the obstacle tree tries every obstacle as its splitter. Larger nodes try only the obstacles around the median of the segment midpoints, so that processing the obstacles takes O(n log n) time on balanced floor plans </summary>
+	/// <param name="size"> The obstacle count, 128 by default; SF::SF_ERROR keeps the exhaustive search for all nodes </param>
+	void SFSimulator::setObstacleTreeExhaustiveSize(size_t size)
+	{
+		kdTree_->obstacleTreeExhaustiveSize_ = size;
+	}
+
+	/// <summary> Sets whether agents are swept against the obstacles on each step. A swept agent stops at the first obstacle it touches, within its obstacle radius, and slides along it for the rest of the step, using the obstacle tree rather than its obstacle neighbors; otherwise an agent whose path crosses an obstacle neighbor goes back to its previous position. Sweeping keeps agents out of walls at larger time steps </summary>
+	/// <param name="sweep"> True to sweep the agents, false by default </param>
+	void SFSimulator::setObstacleSweep(bool sweep)
+	{
+		isObstacleSweep_ = sweep;
+	}
+
+	/// <summary> Returns whether agents are swept against the obstacles on each step </summary>
+	/// <returns> True if the agents are swept </returns>
+	bool SFSimulator::getObstacleSweep() const
+	{
+		return isObstacleSweep_;
 	}
 
 	/// <summary> Sets the time step of the simulation</summary>
@@ -560,6 +1117,157 @@ namespace SF
 		}
 	}
 
+	/// <summary> Computes the kinematics of the moving platform shared by all agents on the current step </summary>
+	void SFSimulator::updatePlatformFrame()
+	{
+		platformFrame_.isActive = rotationFuture_ != Vector3();
+
+		if (!platformFrame_.isActive)
+			return;
+
+		auto& rollX = platformFrame_.rollX;
+		rollX.isRolling = fabs(rotationNow_.x()) > 0.001f;
+		rollX.omega = getOmega(X, NOW);
+		rollX.dOmega = getDOmega(X, NOW);
+		rollX.omegaCosX = cos(rollX.omega.x());
+		rollX.omegaCosY = cos(rollX.omega.y());
+
+		auto& rollY = platformFrame_.rollY;
+		rollY.isRolling = fabs(rotationNow_.y()) > 0.001f;
+		rollY.omega = getOmega(Y, NOW);
+		rollY.dOmega = getDOmega(Y, NOW);
+		rollY.omegaCosX = cos(rollY.omega.x());
+		rollY.omegaCosY = cos(rollY.omega.y());
+
+		// heave
+		// TODO good heave
+		float
+			accelerationZ = platformVelocity_.z() * pow(timeStep_, 2),
+			oldAccelerationZ = previousPlatformVelocity_.z() * pow(timeStep_, 2);
+
+		auto difference = fabs(accelerationZ) - fabs(oldAccelerationZ);
+
+		if (difference > 0)
+			platformFrame_.heaveFactor = 1 + fabs(difference);
+		else
+			platformFrame_.heaveFactor = 1 - fabs(difference);
+
+		previousPlatformVelocity_ = platformVelocity_;
+	}
+
+	/// <summary> Gets current roll </summary>
+	/// <param name="pt"> Rotation projection type </param>
+	/// <param name="tt"> Rotation time type </param>
+	/// <returns> Roll </returns>
+	Vector3 SFSimulator::getRoll(ParameterType pt, TimeType tt) const
+	{
+		Vector3 rotation;
+		float value = 0;
+
+		if(tt == PAST)
+			rotation = rotationPast_;
+		else if(tt == PAST2NOW)
+			rotation = rotationPast2Now_;
+		else if(tt == NOW)
+			rotation = rotationNow_;
+		else if(tt == NOW2FUTURE)
+			rotation == rotationNow2Future_;
+		if(tt == FUTURE)
+			rotation = rotationFuture_;
+
+		if(pt == X)
+			value = rotation.x();
+		
+		if(pt == Y)
+			value = rotation.y();
+
+		if (pt == Z)
+			value = rotation.z();
+
+		return Vector3(value, value, value);
+	}
+
+	/// <summary> Gets Omega matrix </summary>
+	/// <param name="pt"> Rotation projection type </param>
+	/// <param name="tt"> Rotation time type </param>
+	/// <returns> Omega matrix </returns>
+	Vector3 SFSimulator::getOmega(ParameterType pt, TimeType tt) const
+	{
+		float value = 0;
+		
+		if(tt == NOW)
+			value = (getRoll(pt, NOW2FUTURE).x() - getRoll(pt, PAST2NOW).x()) / timeStep_;
+		else if(tt == NOW2FUTURE)
+			value = (getRoll(pt, FUTURE).x() - getRoll(pt, NOW).x()) / timeStep_;
+		else if(tt == PAST2NOW)
+			value = (getRoll(pt, NOW).x() - getRoll(pt, PAST).x()) / timeStep_;
+			
+		if(pt == X)
+			return Vector3(value, 0, 0);
+		
+		if(pt == Y)
+			return Vector3(0, value, 0);
+
+		if (pt == Z)
+			return Vector3(0, 0, value);
+
+		return Vector3();
+	}
+
+	/// <summary> Gets DOmega matrix </summary>
+	/// <param name="pt"> Rotation projection type </param>
+	/// <param name="tt"> Rotation time type </param>
+	/// <returns> DOmega matrix </returns>
+	Vector3 SFSimulator::getDOmega(ParameterType pt, TimeType tt) const
+	{
+		float value = 0;
+
+		if(tt == NOW)
+			value = (getOmega(pt, NOW2FUTURE).x() - getOmega(pt, PAST2NOW).x()) / timeStep_;
+			
+		if(pt == X)
+			return Vector3(value, 0, 0);
+		
+		if(pt == Y)
+			return Vector3(0, value, 0);
+
+		if (pt == Z)
+			return Vector3(0, 0, value);
+
+		return Vector3();
+	}
+
+	/// <summary> Computes the moving platform forces exerted on all agents on the current step in a separate pass over the agent storage </summary>
+	void SFSimulator::computeMovingPlatformForces()
+	{
+		if (!platformFrame_.isActive)
+			return;
+
+		const auto count = agentStorage_->size();
+		agentStorage_->platformForces_.resize(count);
+
+		MovingPlatformInput input;
+		input.positions = agentStorage_->positions_.data();
+		input.velocities = agentStorage_->velocities_.data();
+		input.platformFactors = agentStorage_->platformFactors_.data();
+		input.frame = &platformFrame_;
+		input.timeStep = timeStep_;
+
+		// The pass is split into blocks, which are large enough to amortize the scheduling of the threads
+		const size_t blockSize = 4096;
+		const auto blockCount = static_cast<int>((count + blockSize - 1) / blockSize);
+
+#pragma omp parallel for
+
+		for (int block = 0; block < blockCount; ++block)
+		{
+			const auto begin = block * blockSize;
+			const auto end = std::min(begin + blockSize, count);
+
+			movingPlatformKernel_(input, begin, end, agentStorage_->platformForces_.data());
+		}
+	}
+
 	/// <summary> Sets the additional force </summary>
 	/// <param name="velocity"> New value of velocity </param>
 	/// <param name="set"> Value of rotation set </param>
@@ -600,9 +1308,9 @@ namespace SF
 	/// <param name="newID"> The attractive agent ID </param>
 	void SFSimulator::addAttractiveId(int id, int newId)
 	{
-		auto ail = agents_[id]->attractiveIds_;
+		auto& ail = agents_[id]->attractiveIds_;
 		if(std::find(ail.begin(), ail.end(), newId) == ail.end())
-			agents_[id]->attractiveIds_.push_back(newId);
+			ail.push_back(newId);
 	}
 
 	/// <summary> Adds the list of attractive agents to specified agent </summary>
@@ -619,15 +1327,10 @@ namespace SF
 	/// <param name="idFoeDelete"> The attractive agent ID </param>
 	void SFSimulator::deleteAttractiveId(int id, int idForDelete)
 	{
-		auto aais = agents_[id]->attractiveIds_;
-		for (std::vector<int>::iterator i = aais.begin(); i != aais.end(); ++i)
-		{
-			if (*i == idForDelete)
-			{
-				aais.erase(i);
-				break;
-			}
-		}
+		auto& aais = agents_[id]->attractiveIds_;
+		auto i = std::find(aais.begin(), aais.end(), idForDelete);
+		if (i != aais.end())
+			aais.erase(i);
 	}
 
 	/// <summary> The deleting of the list of attractive agents </summary>
@@ -639,6 +1342,108 @@ namespace SF
 			deleteAttractiveId(id, ai);
 	}
 
+	/// <summary> Returns the list of attractive agents of specified agent </summary>
+	/// <param name="id"> The number of the agent </param>
+	/// <returns> The list of attractive agent ID </returns>
+	const std::vector<int>& SFSimulator::getAttractiveIdList(int id) const
+	{
+		return agents_[id]->attractiveIds_;
+	}
+
+	/// <summary> Adds a group of agents attracted to each other with the attractive force, moving the agents from their previous groups </summary>
+	/// <param name="agentNos"> The numbers of the agents; deleted agents and repeated numbers are ignored </param>
+	/// <returns> The number of the group </returns>
+	size_t SFSimulator::addAgentGroup(const std::vector<size_t>& agentNos)
+	{
+		return agentGroups_->add(agentNos);
+	}
+
+	/// <summary> Moves the specified agent to the specified group in constant time </summary>
+	/// <param name="agentNo"> The number of the agent, ignored when deleted or out of range </param>
+	/// <param name="groupNo"> The number of the group, getNumAgentGroups() to create a new group, or SF::SF_ERROR to remove the agent from its group. Larger numbers are ignored </param>
+	void SFSimulator::setAgentGroup(size_t agentNo, size_t groupNo)
+	{
+		if (agentNo >= agents_.size() || agents_[agentNo]->isDeleted_)
+			return;
+
+		if (groupNo != SF_ERROR && groupNo > agentGroups_->size())
+			return;
+
+		agentGroups_->assign(agents_[agentNo], groupNo);
+	}
+
+	/// <summary> Moves each of the specified agents to the corresponding group in turn, as setAgentGroup does </summary>
+	/// <param name="agentNos"> The numbers of the agents, deleted and out of range agents are ignored </param>
+	/// <param name="groupNos"> The numbers of the groups, each at most the count of groups when it is applied, or SF::SF_ERROR to remove the agents from their groups </param>
+	void SFSimulator::setAgentGroups(const std::vector<size_t>& agentNos, const std::vector<size_t>& groupNos)
+	{
+		const auto count = std::min(agentNos.size(), groupNos.size());
+
+		for (size_t i = 0; i < count; ++i)
+			setAgentGroup(agentNos[i], groupNos[i]);
+	}
+
+	/// <summary> Removes all agent groups </summary>
+	void SFSimulator::clearAgentGroups()
+	{
+		agentGroups_->clear();
+	}
+
+	/// <summary> Returns the group of the specified agent </summary>
+	/// <param name="agentNo"> The number of the agent </param>
+	/// <returns> The number of the group, or SF::SF_ERROR when the agent is in no group </returns>
+	size_t SFSimulator::getAgentGroup(size_t agentNo) const
+	{
+		return agents_[agentNo]->groupNo_;
+	}
+
+	/// <summary> Returns the count of agent groups </summary>
+	/// <returns> The count of agent groups </returns>
+	size_t SFSimulator::getNumAgentGroups() const
+	{
+		return agentGroups_->size();
+	}
+
+	/// <summary> Returns the members of the specified agent group </summary>
+	/// <param name="groupNo"> The number of the group </param>
+	/// <returns> The numbers of the member agents </returns>
+	std::vector<size_t> SFSimulator::getAgentGroupMembers(size_t groupNo) const
+	{
+		return agentGroups_->members_[groupNo];
+	}
+
+	/// <summary> Returns the centroid of the current positions of the members of the specified agent group </summary>
+	/// <param name="groupNo"> The number of the group </param>
+	/// <returns> The centroid, or the origin when the group is empty </returns>
+	Vector2 SFSimulator::getAgentGroupCentroid(size_t groupNo) const
+	{
+		const auto& members = agentGroups_->members_[groupNo];
+
+		if (members.empty())
+			return Vector2();
+
+		auto sum = Vector2();
+
+		for (auto agentNo : members)
+			sum += agents_[agentNo]->position_;
+
+		return sum / static_cast<float>(members.size());
+	}
+
+	/// <summary> Sets the size up to which the attractive force within a group sums the forces of the members one by one. Larger groups exert on each member a single force towards the centroid of the other members, scaled by their count </summary>
+	/// <param name="size"> The size, 8 by default </param>
+	void SFSimulator::setAgentGroupExactSize(size_t size)
+	{
+		agentGroupExactSize_ = size;
+	}
+
+	/// <summary> Returns the size up to which the attractive force within a group sums the forces of the members one by one </summary>
+	/// <returns> The size </returns>
+	size_t SFSimulator::getAgentGroupExactSize() const
+	{
+		return agentGroupExactSize_;
+	}
+
 	/// <summary> Adds the platform rotation on XY axis </summary>
 	/// <param name="value"> The new rotation value </param>
 	void SFSimulator::addPlatformRotationXY(float value)
@@ -703,6 +1508,19 @@ namespace SF
 	std::vector<size_t> SFSimulator::getAgentNeighboursIndexList(size_t index, float radius)
 	{
 		std::vector<size_t> result;
+		getAgentNeighboursIndexList(index, radius, result);
+
+		return result;
+	}
+
+	/// <summary> Fills a list of indices into a specified radius agents, reusing its storage </summary>
+	/// <param name="index"> The number of the agent </param>
+	/// <param name="radius"> The specified radius </param>
+	/// <param name="result"> The list of indices into a specified radius agents </param>
+	void SFSimulator::getAgentNeighboursIndexList(size_t index, float radius, std::vector<size_t>& result)
+	{
+		result.clear();
+
 		if (agents_.size() > 0)
 		{
 			if (index >= agents_.size())
@@ -713,23 +1531,110 @@ namespace SF
 				auto rangeSq = sqr(radius);
 
 				agent->agentNeighborsIndexList_.clear();
-				this->kdTree_->computeAgentNeighborsIndexList(agent, rangeSq);
+				this->agentNeighborSearch_->computeAgentNeighborsIndexList(agent, rangeSq);
 
 				for (auto an : agent->agentNeighborsIndexList_)
-					result.push_back(an.first);
+					result.push_back(agentStorage_->agents_[an.first]->id_);
 			}
 		}
 		else
 			result.push_back(0);
-
-		return result;
 	}
 
-	/// <summary> Deleting the specified agent </summary>
+	/// <summary> Deleting the specified agent; it leaves the simulation on the next step, while its number stays valid </summary>
 	/// <param name="index"> The number of the agent </param>
 	void SFSimulator::deleteAgent(size_t index)
 	{
-		agents_[index]->isDeleted_ = true;
+		auto agent = agents_[index];
+
+		agentGroups_->remove(agent);
+
+		agent->isDeleted_ = true;
+		agent->agentNeighbors_.clear();
+		agent->agentNeighborCandidates_.clear();
+
+		isCompactionPending_ = true;
+	}
+
+	/// <summary> Releases the storage slots of the deleted agents, so that the simulation steps only visit live agents </summary>
+	void SFSimulator::compactAgents()
+	{
+		if (agentStorage_->compact())
+		{
+			// The remaining agents have been moved to other slots, so the indices referring to slots are started anew
+			kdTree_->agents_.clear();
+			kdTree_->agentsAdded_ = 0;
+			isNeighborCandidateStale_ = true;
+
+			// The neighbor lists name agents by their former slots, so they are emptied until the next step computes them
+			for (auto agent : agents_)
+			{
+				agent->agentNeighbors_.clear();
+				agent->agentNeighborCandidates_.clear();
+			}
+		}
+
+		// The attractive references to the removed agents are dropped, so that new agents given their numbers do not inherit them
+		if (!removedAgentNumbers_.empty())
+		{
+			std::vector<char> isRemoved(agents_.size(), 0);
+
+			for (auto agentNo : removedAgentNumbers_)
+				isRemoved[agentNo] = 1;
+
+			const auto isRemovedId = [&](int id) { return id >= 0 && static_cast<size_t>(id) < isRemoved.size() && isRemoved[id] != 0; };
+
+			for (auto agent : agents_)
+			{
+				auto& ids = agent->attractiveIds_;
+				ids.erase(std::remove_if(ids.begin(), ids.end(), isRemovedId), ids.end());
+			}
+		}
+
+		// The removed agents no longer own slots, so their numbers can be given to new agents
+		freeAgentNumbers_.insert(freeAgentNumbers_.end(), removedAgentNumbers_.begin(), removedAgentNumbers_.end());
+		removedAgentNumbers_.clear();
+
+		isCompactionPending_ = false;
+	}
+
+	/// <summary> Releases the temporary buffers of the previous step, adding a scratch arena for each thread that may run the step </summary>
+	void SFSimulator::resetScratchArenas()
+	{
+#if HAVE_OPENMP || _OPENMP
+		const auto threadCount = static_cast<size_t>(omp_get_max_threads());
+#else
+		const size_t threadCount = 1;
+#endif
+
+		while (scratchArenas_.size() < threadCount)
+			scratchArenas_.push_back(new ScratchArena());
+
+		for (auto arena : scratchArenas_)
+			arena->reset();
+	}
+
+	/// <summary> Returns the scratch arena of the calling thread </summary>
+	/// <returns> The scratch arena </returns>
+	ScratchArena& SFSimulator::getScratchArena()
+	{
+#if HAVE_OPENMP || _OPENMP
+		return *scratchArenas_[omp_get_thread_num()];
+#else
+		return *scratchArenas_[0];
+#endif
+	}
+
+	/// <summary> Returns the count of heap allocations made for the temporary buffers of the simulation steps. It stops growing once the scratch arenas fit the scene, so that steady-state steps do not allocate </summary>
+	/// <returns> The count of heap allocations </returns>
+	size_t SFSimulator::getScratchAllocationCount() const
+	{
+		size_t count = 0;
+
+		for (auto arena : scratchArenas_)
+			count += arena->getAllocationCount();
+
+		return count;
 	}
 
 	/// <summary> Returns the list containing IDs of deleted agents </summary>
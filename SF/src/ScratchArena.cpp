@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "../include/ScratchArena.h"
+
+namespace SF
+{
+	// The alignment of the buffers, matching the widest vectors of the force kernels
+	static const size_t SCRATCH_ALIGNMENT = 64;
+
+	// The size of the first block in bytes
+	static const size_t MIN_SCRATCH_BLOCK_SIZE = 64 * 1024;
+
+	/// <summary> Opens a scope on the specified arena </summary>
+	/// <param name="arena"> The arena </param>
+	ScratchArena::Scope::Scope(ScratchArena& arena) :
+		arena_(arena),			// the arena
+		block_(arena.block_),	// the block in use when the scope has been opened
+		offset_(arena.offset_)	// the offset in that block
+	{ }
+
+	/// <summary> Releases the buffers allocated since the scope has been opened </summary>
+	ScratchArena::Scope::~Scope()
+	{
+		arena_.block_ = block_;
+		arena_.offset_ = offset_;
+	}
+
+	/// <summary> Constructs an empty arena </summary>
+	ScratchArena::ScratchArena() :
+		blocks_(),				// blocks in allocation order
+		block_(0),				// block in use
+		offset_(0),				// offset of the free memory in the block in use
+		allocationCount_(0)		// count of heap allocations
+	{ }
+
+	/// <summary> Destructor </summary>
+	ScratchArena::~ScratchArena()
+	{
+		freeBlocks();
+	}
+
+	/// <summary> Releases all buffers. The blocks grown during the previous step are merged, so that a step of the same size fits in a single block </summary>
+	void ScratchArena::reset()
+	{
+		if (blocks_.size() > 1)
+		{
+			size_t size = 0;
+
+			for (const auto& block : blocks_)
+				size += block.size;
+
+			freeBlocks();
+			appendBlock(size);
+		}
+
+		block_ = 0;
+		offset_ = 0;
+	}
+
+	/// <summary> Returns the count of heap allocations made by this arena </summary>
+	/// <returns> The count of heap allocations </returns>
+	size_t ScratchArena::getAllocationCount() const
+	{
+		return allocationCount_;
+	}
+
+	/// <summary> Allocates an aligned buffer, appending a block when the remaining ones are too small </summary>
+	/// <param name="size"> The size in bytes </param>
+	/// <returns> A pointer to the buffer </returns>
+	void* ScratchArena::allocateBytes(size_t size)
+	{
+		for (; block_ < blocks_.size(); ++block_, offset_ = 0)
+		{
+			const auto offset = (offset_ + SCRATCH_ALIGNMENT - 1) / SCRATCH_ALIGNMENT * SCRATCH_ALIGNMENT;
+
+			if (offset + size <= blocks_[block_].size)
+			{
+				offset_ = offset + size;
+
+				return blocks_[block_].data + offset;
+			}
+		}
+
+		// Each block at least doubles the capacity, so that a growing step appends a logarithmic count of blocks
+		size_t capacity = 0;
+
+		for (const auto& block : blocks_)
+			capacity += block.size;
+
+		appendBlock(std::max(size, std::max(MIN_SCRATCH_BLOCK_SIZE, capacity)));
+
+		block_ = blocks_.size() - 1;
+		offset_ = size;
+
+		return blocks_[block_].data;
+	}
+
+	/// <summary> Appends a block of at least the specified size </summary>
+	/// <param name="size"> The size in bytes </param>
+	void ScratchArena::appendBlock(size_t size)
+	{
+		Block block;
+		block.memory = new char[size + SCRATCH_ALIGNMENT];
+		block.data = block.memory + (SCRATCH_ALIGNMENT - reinterpret_cast<uintptr_t>(block.memory) % SCRATCH_ALIGNMENT) % SCRATCH_ALIGNMENT;
+		block.size = size;
+
+		blocks_.push_back(block);
+		++allocationCount_;
+	}
+
+	/// <summary> Frees all blocks </summary>
+	void ScratchArena::freeBlocks()
+	{
+		for (const auto& block : blocks_)
+			delete[] block.memory;
+
+		blocks_.clear();
+	}
+}
@@ -0,0 +1,45 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <chrono>
+
+#include "SF.h"
+
+namespace SFBenchmarks
+{
+	/// <summary> Measures the agent kd-tree build from 1 to the maximal count of threads at 10k, 100k and 1M agents </summary>
+	void runAgentTreeBenchmark();
+
+	/// <summary> Compares the kd-tree and the uniform grid agent neighbor search on dense corridors, checking that both find the same neighbors </summary>
+	void runNeighborSearchBenchmark();
+
+	/// <summary> Compares the obstacle tree build with exhaustive and with sampled splitter candidates on synthetic and real-size floor plans, along with the visibility queries over both trees </summary>
+	void runObstacleTreeBenchmark();
+
+	/// <summary> Compares the batched visibility queries with the same queries issued one at a time, on one and on the maximal count of threads, checking that both find the same visible pairs </summary>
+	void runVisibilityBenchmark();
+
+	/// <summary> Adds a floor plan of square rooms 10 m wide, each with a door in its bottom wall, a left wall and a partition, 16 segments per room </summary>
+	/// <param name="sim"> The simulator </param>
+	/// <param name="size"> The count of rooms along each side of the plan </param>
+	void addRooms(SF::SFSimulator& sim, size_t size);
+
+	/// <summary> Sets the agent defaults shared by the benchmarks: a neighbor distance of 3 m, 10 neighbors and a radius of 0.3 m </summary>
+	/// <param name="sim"> The simulator </param>
+	void setAgentDefaults(SF::SFSimulator& sim);
+
+	/// <summary> Returns the maximal count of threads that may run a simulation step </summary>
+	/// <returns> The count of threads, 1 without OpenMP </returns>
+	int getMaxThreadCount();
+
+	/// <summary> Sets the count of threads running the next simulation steps </summary>
+	/// <param name="threadCount"> The count of threads, ignored without OpenMP </param>
+	void setThreadCount(int threadCount);
+
+	/// <summary> Returns the milliseconds elapsed since the specified time </summary>
+	/// <param name="start"> The time </param>
+	/// <returns> The elapsed milliseconds </returns>
+	double getElapsedMilliseconds(const std::chrono::steady_clock::time_point& start);
+}
+
+#endif
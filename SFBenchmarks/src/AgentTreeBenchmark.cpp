@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../include/Benchmarks.h"
+
+namespace SFBenchmarks
+{
+	/// <summary> Measures the agent kd-tree build from 1 to the maximal count of threads at 10k, 100k and 1M agents </summary>
+	void runAgentTreeBenchmark()
+	{
+		const size_t agentCounts[] = { 10000, 100000, 1000000 };
+		const auto maxThreadCount = getMaxThreadCount();
+		std::vector<int> threadCounts;
+
+		for (auto threadCount = 1; threadCount < maxThreadCount; threadCount *= 2)
+			threadCounts.push_back(threadCount);
+
+		threadCounts.push_back(maxThreadCount);
+
+		std::printf("%10s %8s %12s %8s\n", "agents", "threads", "ms/build", "speedup");
+
+		for (auto agentCount : agentCounts)
+		{
+			SF::SFSimulator sim;
+			setAgentDefaults(sim);
+
+			// One agent per square meter, as in a dense crowd
+			const auto side = static_cast<float>(std::sqrt(static_cast<double>(agentCount)));
+			std::mt19937 random(1);
+			std::uniform_real_distribution<float> coordinate(0.0f, side);
+
+			for (size_t i = 0; i < agentCount; ++i)
+				sim.addAgent(SF::Vector2(coordinate(random), coordinate(random)));
+
+			// Each build starts from the agent order left by the previous one, as on consecutive steps
+			const auto buildCount = std::max<size_t>(3, 2000000 / agentCount);
+			double singleThreadTime = 0.0;
+
+			for (auto threadCount : threadCounts)
+			{
+				setThreadCount(threadCount);
+				sim.buildAgentNeighborIndex();
+
+				const auto start = std::chrono::steady_clock::now();
+
+				for (size_t i = 0; i < buildCount; ++i)
+					sim.buildAgentNeighborIndex();
+
+				const auto time = getElapsedMilliseconds(start) / buildCount;
+
+				if (threadCount == 1)
+					singleThreadTime = time;
+
+				std::printf("%10zu %8d %12.3f %7.2fx\n", agentCount, threadCount, time, singleThreadTime / time);
+			}
+		}
+
+		setThreadCount(maxThreadCount);
+	}
+}
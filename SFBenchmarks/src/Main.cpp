@@ -0,0 +1,105 @@
+#include <cstdio>
+#include <cstring>
+
+#include "../include/Benchmarks.h"
+#include "AgentPropertyConfig.h"
+
+#if HAVE_OPENMP || _OPENMP
+	#include <omp.h>
+#endif
+
+namespace SFBenchmarks
+{
+	/// <summary> Defines a benchmark that can be run by name </summary>
+	struct Benchmark
+	{
+		const char* name;		// The name given on the command line
+		void (*run)();			// The function running the benchmark
+	};
+
+	static const Benchmark BENCHMARKS[] =
+	{
+		{ "agent-tree", runAgentTreeBenchmark },
+		{ "neighbor-search", runNeighborSearchBenchmark },
+		{ "obstacle-tree", runObstacleTreeBenchmark },
+		{ "visibility", runVisibilityBenchmark }
+	};
+
+	/// <summary> Sets the agent defaults shared by the benchmarks: a neighbor distance of 3 m, 10 neighbors and a radius of 0.3 m </summary>
+	/// <param name="sim"> The simulator </param>
+	void setAgentDefaults(SF::SFSimulator& sim)
+	{
+		SF::AgentPropertyConfig apc(3.0f, 10, 1.0f, 0.3f, 1.4f, 1.0f, 0.5f, 0.3f, 1.0f, 0.2f, 1.0f, 0.1f, 1.0f, 0.5f, 0.1f, SF::Vector2());
+
+		sim.setTimeStep(0.1f);
+		sim.setAgentDefaults(apc);
+	}
+
+	/// <summary> Returns the maximal count of threads that may run a simulation step </summary>
+	/// <returns> The count of threads, 1 without OpenMP </returns>
+	int getMaxThreadCount()
+	{
+#if HAVE_OPENMP || _OPENMP
+		// The count before any benchmark lowers it
+		static const auto maxThreadCount = omp_get_max_threads();
+
+		return maxThreadCount;
+#else
+		return 1;
+#endif
+	}
+
+	/// <summary> Sets the count of threads running the next simulation steps </summary>
+	/// <param name="threadCount"> The count of threads, ignored without OpenMP </param>
+	void setThreadCount(int threadCount)
+	{
+#if HAVE_OPENMP || _OPENMP
+		omp_set_num_threads(threadCount);
+#else
+		(void)threadCount;
+#endif
+	}
+
+	/// <summary> Returns the milliseconds elapsed since the specified time </summary>
+	/// <param name="start"> The time </param>
+	/// <returns> The elapsed milliseconds </returns>
+	double getElapsedMilliseconds(const std::chrono::steady_clock::time_point& start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+/// <summary> Runs the benchmarks named on the command line, or all of them </summary>
+int main(int argc, char** argv)
+{
+	auto isFound = argc <= 1;
+
+	for (const auto& benchmark : SFBenchmarks::BENCHMARKS)
+	{
+		auto isSelected = argc <= 1;
+
+		for (auto i = 1; i < argc; ++i)
+			isSelected = isSelected || std::strcmp(argv[i], benchmark.name) == 0;
+
+		if (!isSelected)
+			continue;
+
+		std::printf("== %s\n", benchmark.name);
+		benchmark.run();
+		std::printf("\n");
+		isFound = true;
+	}
+
+	if (!isFound)
+	{
+		std::printf("usage: SFBenchmarks [name...]\nbenchmarks:");
+
+		for (const auto& benchmark : SFBenchmarks::BENCHMARKS)
+			std::printf(" %s", benchmark.name);
+
+		std::printf("\n");
+		return 1;
+	}
+
+	return 0;
+}
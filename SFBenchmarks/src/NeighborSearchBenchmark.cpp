@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../include/Benchmarks.h"
+
+namespace SFBenchmarks
+{
+	/// <summary> Fills a dense corridor 20 m wide with agents walking in both directions </summary>
+	/// <param name="sim"> The simulator </param>
+	/// <param name="agentCount"> The count of agents, one per square meter </param>
+	static void addCorridorAgents(SF::SFSimulator& sim, size_t agentCount)
+	{
+		const auto length = static_cast<float>(agentCount) / 20.0f;
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> x(0.0f, length);
+		std::uniform_real_distribution<float> y(0.0f, 20.0f);
+
+		for (size_t i = 0; i < agentCount; ++i)
+		{
+			const auto agentNo = sim.addAgent(SF::Vector2(x(random), y(random)));
+			sim.setAgentPrefVelocity(agentNo, SF::Vector2(i % 2 == 0 ? 1.2f : -1.2f, 0.0f));
+		}
+	}
+
+	/// <summary> Returns the sorted agent neighbors of the specified agent </summary>
+	/// <param name="sim"> The simulator </param>
+	/// <param name="agentNo"> The number of the agent </param>
+	/// <returns> The numbers of the agent neighbors in ascending order </returns>
+	static std::vector<size_t> getSortedAgentNeighbors(const SF::SFSimulator& sim, size_t agentNo)
+	{
+		std::vector<size_t> neighbors(sim.getAgentNumAgentNeighbors(agentNo));
+
+		for (size_t i = 0; i < neighbors.size(); ++i)
+			neighbors[i] = sim.getAgentAgentNeighbor(agentNo, i);
+
+		std::sort(neighbors.begin(), neighbors.end());
+
+		return neighbors;
+	}
+
+	/// <summary> Compares the kd-tree and the uniform grid agent neighbor search on dense corridors, checking that both find the same neighbors </summary>
+	void runNeighborSearchBenchmark()
+	{
+		const size_t agentCounts[] = { 10000, 100000 };
+		const size_t stepCount = 20;
+
+		std::printf("%10s %14s %12s %12s %10s\n", "agents", "search", "ms/build", "ms/step", "same sets");
+
+		for (auto agentCount : agentCounts)
+		{
+			SF::SFSimulator kdTreeSim;
+			SF::SFSimulator gridSim;
+			SF::SFSimulator* sims[] = { &kdTreeSim, &gridSim };
+			const char* names[] = { "kd-tree", "uniform grid" };
+
+			gridSim.setNeighborSearchType(SF::SFSimulator::UNIFORM_GRID);
+
+			for (auto sim : sims)
+			{
+				setAgentDefaults(*sim);
+				sim->setInstructionSet(SF::SFSimulator::SCALAR);
+				addCorridorAgents(*sim, agentCount);
+			}
+
+			// The first step starts from the same positions, so the neighbor sets must be the same
+			kdTreeSim.doStep();
+			gridSim.doStep();
+
+			auto isSame = true;
+
+			for (size_t i = 0; i < agentCount && isSame; ++i)
+				isSame = getSortedAgentNeighbors(kdTreeSim, i) == getSortedAgentNeighbors(gridSim, i);
+
+			for (size_t k = 0; k < 2; ++k)
+			{
+				auto start = std::chrono::steady_clock::now();
+
+				for (size_t i = 0; i < stepCount; ++i)
+					sims[k]->buildAgentNeighborIndex();
+
+				const auto buildTime = getElapsedMilliseconds(start) / stepCount;
+
+				start = std::chrono::steady_clock::now();
+
+				for (size_t i = 0; i < stepCount; ++i)
+					sims[k]->doStep();
+
+				const auto stepTime = getElapsedMilliseconds(start) / stepCount;
+
+				std::printf("%10zu %14s %12.3f %12.3f %10s\n", agentCount, names[k], buildTime, stepTime, isSame ? "yes" : "no");
+			}
+		}
+	}
+}
@@ -0,0 +1,127 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "../include/Benchmarks.h"
+
+namespace SFBenchmarks
+{
+	/// <summary> Adds an axis-aligned rectangular obstacle </summary>
+	/// <param name="sim"> The simulator </param>
+	/// <param name="left"> The x-coordinate of the left side </param>
+	/// <param name="bottom"> The y-coordinate of the bottom side </param>
+	/// <param name="right"> The x-coordinate of the right side </param>
+	/// <param name="top"> The y-coordinate of the top side </param>
+	static void addBox(SF::SFSimulator& sim, float left, float bottom, float right, float top)
+	{
+		sim.addObstacle({ SF::Vector2(left, bottom), SF::Vector2(right, bottom), SF::Vector2(right, top), SF::Vector2(left, top) });
+	}
+
+	/// <summary> Adds a floor plan of square rooms 10 m wide, each with a door in its bottom wall, a left wall and a partition, 16 segments per room </summary>
+	/// <param name="sim"> The simulator </param>
+	/// <param name="size"> The count of rooms along each side of the plan </param>
+	void addRooms(SF::SFSimulator& sim, size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			for (size_t j = 0; j < size; ++j)
+			{
+				const auto x = 10.0f * i;
+				const auto y = 10.0f * j;
+
+				addBox(sim, x, y, x + 4.0f, y + 0.2f);
+				addBox(sim, x + 6.0f, y, x + 10.0f, y + 0.2f);
+				addBox(sim, x, y, x + 0.2f, y + 10.0f);
+				addBox(sim, x + 3.0f, y + 5.0f, x + 7.0f, y + 5.2f);
+			}
+		}
+	}
+
+	/// <summary> Adds a hall of cells 10 m wide, each with a randomly placed and rotated pillar and three small obstacles, 16 segments per cell </summary>
+	/// <param name="sim"> The simulator </param>
+	/// <param name="size"> The count of cells along each side of the hall </param>
+	static void addPillars(SF::SFSimulator& sim, size_t size)
+	{
+		std::mt19937 random(3);
+		std::uniform_real_distribution<float> offset(0.0f, 10.0f);
+		std::uniform_real_distribution<float> angle(0.0f, 6.2832f);
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			for (size_t j = 0; j < size; ++j)
+			{
+				const auto x = 10.0f * i;
+				const auto y = 10.0f * j;
+				const auto centerX = x + offset(random);
+				const auto centerY = y + offset(random);
+				const auto a = angle(random);
+				const auto c = 0.8f * std::cos(a);
+				const auto s = 0.8f * std::sin(a);
+
+				sim.addObstacle({ SF::Vector2(centerX + c, centerY + s), SF::Vector2(centerX - s, centerY + c), SF::Vector2(centerX - c, centerY - s), SF::Vector2(centerX + s, centerY - c) });
+				addBox(sim, x + 1.0f, y + 1.0f, x + 2.0f, y + 1.5f);
+				addBox(sim, x + 5.0f, y + 7.0f, x + 5.5f, y + 9.0f);
+				addBox(sim, x + 7.0f, y + 2.0f, x + 9.0f, y + 2.3f);
+			}
+		}
+	}
+
+	/// <summary> Compares the obstacle tree build with exhaustive and with sampled splitter candidates on synthetic and real-size floor plans, along with the visibility queries over both trees </summary>
+	void runObstacleTreeBenchmark()
+	{
+		struct Scene
+		{
+			const char* name;							// The name of the scene
+			void (*add)(SF::SFSimulator&, size_t);		// The function adding the obstacles
+			size_t size;								// The count of rooms or cells along each side
+		};
+
+		const Scene scenes[] =
+		{
+			{ "rooms", addRooms, 10 },
+			{ "rooms", addRooms, 35 },
+			{ "pillars", addPillars, 35 }
+		};
+		const size_t queryCount = 100000;
+
+		std::printf("%10s %10s %12s %12s %12s\n", "scene", "segments", "build", "ms/build", "us/query");
+
+		for (const auto& scene : scenes)
+		{
+			for (auto isExhaustive = 1; isExhaustive >= 0; --isExhaustive)
+			{
+				SF::SFSimulator sim;
+				setAgentDefaults(sim);
+				scene.add(sim, scene.size);
+
+				if (isExhaustive != 0)
+					sim.setObstacleTreeExhaustiveSize(SF::SF_ERROR);
+
+				auto start = std::chrono::steady_clock::now();
+				sim.processObstacles();
+				const auto buildTime = getElapsedMilliseconds(start);
+
+				// Segments 10 m long from random points of the plan, the same for both trees
+				const auto extent = 10.0f * scene.size;
+				std::mt19937 random(9);
+				std::uniform_real_distribution<float> coordinate(0.0f, extent);
+				std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+				size_t visibleCount = 0;
+
+				start = std::chrono::steady_clock::now();
+
+				for (size_t i = 0; i < queryCount; ++i)
+				{
+					const SF::Vector2 point(coordinate(random), coordinate(random));
+
+					if (sim.queryVisibility(point, point + SF::Vector2(offset(random), offset(random)), 0.1f))
+						++visibleCount;
+				}
+
+				const auto queryTime = getElapsedMilliseconds(start) * 1000.0 / queryCount;
+
+				std::printf("%10s %10zu %12s %12.1f %12.3f   %zu visible\n", scene.name, sim.getNumObstacleVertices(), isExhaustive != 0 ? "exhaustive" : "sampled", buildTime, queryTime, visibleCount);
+			}
+		}
+	}
+}
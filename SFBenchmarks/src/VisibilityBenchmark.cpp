@@ -0,0 +1,69 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../include/Benchmarks.h"
+
+namespace SFBenchmarks
+{
+	/// <summary> Compares the batched visibility queries with the same queries issued one at a time, on one and on the maximal count of threads, checking that both find the same visible pairs </summary>
+	void runVisibilityBenchmark()
+	{
+		const size_t sizes[] = { 10, 35 };
+		const size_t queryCount = 1000000;
+		const auto threadCounts = getMaxThreadCount() > 1 ? std::vector<int>{ 1, getMaxThreadCount() } : std::vector<int>{ 1 };
+
+		std::printf("%10s %10s %8s %12s %12s %10s\n", "segments", "queries", "threads", "calls", "ns/query", "same pairs");
+
+		for (auto size : sizes)
+		{
+			SF::SFSimulator sim;
+			setAgentDefaults(sim);
+			addRooms(sim, size);
+			sim.processObstacles();
+
+			// Segments up to 10 m long from random points of the plan, in random order
+			const auto extent = 10.0f * size;
+			std::mt19937 random(11);
+			std::uniform_real_distribution<float> coordinate(0.0f, extent);
+			std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+			std::vector<SF::Vector2> points1(queryCount);
+			std::vector<SF::Vector2> points2(queryCount);
+			std::vector<float> radii(queryCount, 0.1f);
+
+			for (size_t i = 0; i < queryCount; ++i)
+			{
+				points1[i] = SF::Vector2(coordinate(random), coordinate(random));
+				points2[i] = points1[i] + SF::Vector2(offset(random), offset(random));
+			}
+
+			setThreadCount(1);
+
+			std::vector<uint64_t> expected((queryCount + 63) / 64);
+			auto start = std::chrono::steady_clock::now();
+
+			for (size_t i = 0; i < queryCount; ++i)
+			{
+				if (sim.queryVisibility(points1[i], points2[i], radii[i]))
+					expected[i / 64] |= uint64_t(1) << (i % 64);
+			}
+
+			auto time = getElapsedMilliseconds(start) * 1e6 / queryCount;
+
+			std::printf("%10zu %10zu %8d %12s %12.1f\n", sim.getNumObstacleVertices(), queryCount, 1, "one by one", time);
+
+			for (auto threadCount : threadCounts)
+			{
+				setThreadCount(threadCount);
+
+				start = std::chrono::steady_clock::now();
+				const auto visible = sim.queryVisibilities(points1, points2, radii);
+				time = getElapsedMilliseconds(start) * 1e6 / queryCount;
+
+				std::printf("%10zu %10zu %8d %12s %12.1f %10s\n", sim.getNumObstacleVertices(), queryCount, threadCount, "batched", time, visible == expected ? "yes" : "no");
+			}
+
+			setThreadCount(getMaxThreadCount());
+		}
+	}
+}
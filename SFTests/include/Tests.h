@@ -0,0 +1,74 @@
+#ifndef TESTS_H
+#define TESTS_H
+
+#include "SF.h"
+
+namespace SFTests
+{
+	/// <summary> Checks that removing an agent drops the attractive references of the other agents to it before its number is reused </summary>
+	void testRemovedAgentLeavesAttractiveLists();
+
+	/// <summary> Checks that agents are only moved to existing groups or to a new one numbered after them, and that out of range agents are ignored </summary>
+	void testAgentGroupNumbersAreBounded();
+
+	/// <summary> Checks that an agent alone in its group keeps a finite position when the group forces are approximated for all sizes </summary>
+	void testSingleMemberGroupStaysFinite();
+
+	/// <summary> Checks that compacting the agents when building the neighbor index leaves no neighbor naming a former storage slot </summary>
+	void testNeighborIndexBuildDropsStaleNeighbors();
+
+	/// <summary> Checks that the obstacle distance field is disabled by a max distance that is not positive, including along an axis-aligned wall that would give a grid one node wide </summary>
+	void testDistanceFieldRejectsNonPositiveMaxDistance();
+
+	/// <summary> Checks that the obstacle neighbors of an agent name the first vertices of static edges, and SF::SF_ERROR for the edges of dynamic obstacles </summary>
+	void testDynamicObstacleNeighborsHaveNoVertex();
+
+	/// <summary> Checks that the obstacle neighbors found through the obstacle tree are the segments within range of each agent, each once, with the splitters tried exhaustively and sampled, on segments crossing each other and so the splitting lines </summary>
+	void testObstacleNeighborsMatchBruteForce();
+
+	/// <summary> Checks that the batched visibility queries match the single queries, and that pair lists of different sizes are rejected </summary>
+	void testBatchedVisibilityMatchesSingle();
+
+	/// <summary> Checks that the radius of a visibility query widens the line segment between the points rather than its whole line, so that a wall nearly along the line but far past the points does not block them </summary>
+	void testVisibilityRadiusWidensSegment();
+
+	/// <summary> Checks that swept agents stop at walls crossing each other, which cross the splitting lines of the obstacle tree whatever splitters it takes </summary>
+	void testSweepStopsAtCrossingWalls();
+
+	/// <summary> Checks that the SIMD repulsive agent kernels stay within 1e-6 relative error of the scalar kernel on the same neighbor lists, including partial vectors, whose padding lanes must not contribute, and a neighbor standing on the agent </summary>
+	void testRepulsiveAgentKernelsMatchScalar();
+
+	/// <summary> Checks that the steady-state steps of the reference scene make no heap allocations, with both neighbor searches, on one thread and on several </summary>
+	void testSteadyStepsDoNotAllocate();
+
+	/// <summary> Checks that the trajectories of a platoon walking down the reference corridor in the fast math mode stay within 1e-5 of the precise ones, relative to the distance walked </summary>
+	void testFastMathTrajectoriesMatchPrecise();
+
+	/// <summary> Records the result of a check, printing the failed ones </summary>
+	/// <param name="condition"> The result of the check </param>
+	/// <param name="expression"> The checked expression </param>
+	/// <param name="file"> The source file of the check </param>
+	/// <param name="line"> The source line of the check </param>
+	void check(bool condition, const char* expression, const char* file, int line);
+
+	/// <summary> Sets the agent defaults shared by the tests: a neighbor distance of 3 m, 10 neighbors and a radius of 0.3 m </summary>
+	/// <param name="sim"> The simulator </param>
+	void setAgentDefaults(SF::SFSimulator& sim);
+
+	/// <summary> Adds the obstacles of the reference corridor: walls 20 m apart along the x-axis with a row of pillars in the middle </summary>
+	/// <param name="sim"> The simulator </param>
+	void addReferenceCorridor(SF::SFSimulator& sim);
+
+	/// <summary> Fills a simulator with the reference scene: the reference corridor crossed by two opposing flows of agents </summary>
+	/// <param name="sim"> The simulator, with its agent defaults set </param>
+	/// <param name="agentCount"> The count of agents </param>
+	void addReferenceScene(SF::SFSimulator& sim, size_t agentCount);
+
+	/// <summary> Sets the count of threads running the next simulation steps </summary>
+	/// <param name="threadCount"> The count of threads, ignored without OpenMP </param>
+	void setThreadCount(int threadCount);
+}
+
+#define SF_CHECK(condition) SFTests::check((condition), #condition, __FILE__, __LINE__)
+
+#endif
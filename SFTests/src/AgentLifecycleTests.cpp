@@ -0,0 +1,110 @@
+#include <cmath>
+
+#include "../include/Tests.h"
+
+namespace SFTests
+{
+	/// <summary> Checks that removing an agent drops the attractive references of the other agents to it before its number is reused </summary>
+	void testRemovedAgentLeavesAttractiveLists()
+	{
+		SF::SFSimulator sim;
+		setAgentDefaults(sim);
+
+		const auto first = sim.spawnAgent(SF::Vector2(0.0f, 0.0f));
+		const auto removed = sim.spawnAgent(SF::Vector2(1.0f, 0.0f));
+		const auto last = sim.spawnAgent(SF::Vector2(2.0f, 0.0f));
+
+		sim.addAttractiveId(static_cast<int>(first.agentNo), static_cast<int>(removed.agentNo));
+		sim.addAttractiveId(static_cast<int>(last.agentNo), static_cast<int>(removed.agentNo));
+		sim.addAttractiveId(static_cast<int>(last.agentNo), static_cast<int>(first.agentNo));
+
+		sim.removeAgent(removed);
+		sim.doStep();
+
+		const auto spawned = sim.spawnAgent(SF::Vector2(5.0f, 5.0f));
+
+		SF_CHECK(spawned.agentNo == removed.agentNo);
+		SF_CHECK(sim.getAttractiveIdList(static_cast<int>(first.agentNo)).empty());
+		SF_CHECK(sim.getAttractiveIdList(static_cast<int>(last.agentNo)).size() == 1);
+		SF_CHECK(sim.getAttractiveIdList(static_cast<int>(last.agentNo))[0] == static_cast<int>(first.agentNo));
+	}
+
+	/// <summary> Checks that agents are only moved to existing groups or to a new one numbered after them, and that out of range agents are ignored </summary>
+	void testAgentGroupNumbersAreBounded()
+	{
+		SF::SFSimulator sim;
+		setAgentDefaults(sim);
+
+		const auto first = sim.addAgent(SF::Vector2(0.0f, 0.0f));
+		const auto second = sim.addAgent(SF::Vector2(1.0f, 0.0f));
+
+		sim.setAgentGroup(first, 0);
+		sim.setAgentGroup(second, 5);
+		sim.setAgentGroup(sim.getNumAgents(), 0);
+
+		SF_CHECK(sim.getNumAgentGroups() == 1);
+		SF_CHECK(sim.getAgentGroup(first) == 0);
+		SF_CHECK(sim.getAgentGroup(second) == SF::SF_ERROR);
+		SF_CHECK(sim.getAgentGroupMembers(0).size() == 1);
+
+		sim.setAgentGroups({ second, first }, { 1, 1 });
+
+		SF_CHECK(sim.getNumAgentGroups() == 2);
+		SF_CHECK(sim.getAgentGroupMembers(0).empty());
+		SF_CHECK(sim.getAgentGroupMembers(1).size() == 2);
+	}
+
+	/// <summary> Checks that an agent alone in its group keeps a finite position when the group forces are approximated for all sizes </summary>
+	void testSingleMemberGroupStaysFinite()
+	{
+		SF::SFSimulator sim;
+		setAgentDefaults(sim);
+		sim.setAgentGroupExactSize(0);
+
+		const auto agentNo = sim.addAgent(SF::Vector2(0.0f, 0.0f));
+		sim.setAgentPrefVelocity(agentNo, SF::Vector2(1.0f, 0.0f));
+		sim.setAgentGroup(agentNo, 0);
+
+		for (auto step = 0; step < 10; ++step)
+			sim.doStep();
+
+		const auto position = sim.getAgentPosition(agentNo);
+
+		SF_CHECK(sim.getAgentGroupMembers(0).size() == 1);
+		SF_CHECK(std::isfinite(position.x()) && std::isfinite(position.y()));
+		SF_CHECK(position.x() > 0.0f);
+	}
+
+	/// <summary> Checks that compacting the agents when building the neighbor index leaves no neighbor naming a former storage slot </summary>
+	void testNeighborIndexBuildDropsStaleNeighbors()
+	{
+		SF::SFSimulator sim;
+		setAgentDefaults(sim);
+
+		for (auto i = 0; i < 5; ++i)
+			sim.addAgent(SF::Vector2(0.5f * i, 0.0f));
+
+		sim.doStep();
+
+		const auto last = sim.getNumAgents() - 1;
+
+		SF_CHECK(sim.getAgentNumAgentNeighbors(last) > 0);
+
+		sim.deleteAgent(0);
+		sim.buildAgentNeighborIndex();
+
+		for (size_t agentNo = 1; agentNo < sim.getNumAgents(); ++agentNo)
+			SF_CHECK(sim.getAgentNumAgentNeighbors(agentNo) == 0);
+
+		sim.doStep();
+
+		for (size_t i = 0; i < sim.getAgentNumAgentNeighbors(last); ++i)
+		{
+			const auto neighborNo = sim.getAgentAgentNeighbor(last, i);
+
+			SF_CHECK(neighborNo != 0 && neighborNo < sim.getNumAgents());
+		}
+
+		SF_CHECK(sim.getAgentNumAgentNeighbors(last) == 3);
+	}
+}
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "../include/Tests.h"
+#include "ForceKernels.h"
+
+namespace SFTests
+{
+	static const double KERNEL_TOLERANCE = 1e-6;	// relative error allowed between the SIMD kernels and the scalar one
+	static const size_t MAX_NEIGHBOR_COUNT = 40;	// largest neighbor list tried, covering partial vectors of every width
+	static const size_t TRIAL_COUNT = 100;			// count of random scenes tried for each neighbor count
+
+	/// <summary> Checks that a kernel result stays within the relative tolerance of the scalar result. The force sum is measured against the pressure, since opposing forces cancel in it </summary>
+	/// <param name="actual"> The result of the checked kernel </param>
+	/// <param name="expected"> The result of the scalar kernel </param>
+	/// <returns> True if the results agree </returns>
+	static bool isWithinTolerance(const SF::RepulsiveAgentOutput& actual, const SF::RepulsiveAgentOutput& expected)
+	{
+		const auto scale = std::max(expected.pressure, static_cast<double>(FLT_MIN));
+		const auto forceError = std::max(std::abs(actual.forceSum.x() - expected.forceSum.x()), std::abs(actual.forceSum.y() - expected.forceSum.y()));
+
+		return forceError <= KERNEL_TOLERANCE * scale
+			&& std::abs(actual.pressure - expected.pressure) <= KERNEL_TOLERANCE * scale
+			&& std::abs(actual.maxForceLength - expected.maxForceLength) <= KERNEL_TOLERANCE * std::max(expected.maxForceLength, FLT_MIN);
+	}
+
+	/// <summary> Checks that the SIMD repulsive agent kernels stay within 1e-6 relative error of the scalar kernel on the same neighbor lists, including partial vectors, whose padding lanes must not contribute, and a neighbor standing on the agent </summary>
+	void testRepulsiveAgentKernelsMatchScalar()
+	{
+		std::mt19937 random(11);
+		std::uniform_real_distribution<float> offset(-3.0f, 3.0f);
+		std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> speed(0.5f, 1.8f);
+
+		const auto supported = SF::getSupportedInstructionSet();
+		const auto scalar = SF::getRepulsiveAgentKernel(SF::SFSimulator::SCALAR, SF::SFSimulator::PRECISE);
+
+		std::vector<SF::Vector2> positions(MAX_NEIGHBOR_COUNT + 1);
+		std::vector<SF::Vector2> velocities(MAX_NEIGHBOR_COUNT + 1);
+		std::vector<float> speeds(MAX_NEIGHBOR_COUNT + 1);
+		std::vector<std::pair<float, size_t> > neighbors;
+
+		SF::RepulsiveAgentInput input;
+		input.positions = positions.data();
+		input.velocities = velocities.data();
+		input.speeds = speeds.data();
+		input.timeStep = 0.1f;
+		input.repulsiveAgent = 0.3f;
+		input.repulsiveAgentFactor = 1.0f;
+		input.perception = 0.2f;
+
+		for (size_t trial = 0; trial < TRIAL_COUNT; ++trial)
+		{
+			// Every other trial puts a neighbor on the agent, which the kernels must skip
+			const auto isCoincident = trial % 2 != 0;
+
+			for (size_t count = 0; count <= MAX_NEIGHBOR_COUNT; ++count)
+			{
+				input.position = SF::Vector2(10.0f + offset(random), -5.0f + offset(random));
+				neighbors.clear();
+
+				for (size_t i = 0; i < count; ++i)
+				{
+					positions[i] = isCoincident && i == count / 2 ? input.position : input.position + SF::Vector2(offset(random), offset(random));
+					velocities[i] = SF::normalize(SF::Vector2(direction(random), direction(random)));
+					speeds[i] = speed(random);
+					neighbors.push_back(std::make_pair(SF::absSq(input.position - positions[i]), i));
+				}
+
+				// A close agent follows the neighbor list, so that padding lanes reading it would change the force
+				positions[count] = input.position + SF::Vector2(0.4f, 0.0f);
+				velocities[count] = SF::Vector2(1.0f, 0.0f);
+				speeds[count] = 1.0f;
+				neighbors.push_back(std::make_pair(SF::absSq(input.position - positions[count]), count));
+
+				SF::RepulsiveAgentOutput expected;
+				scalar(input, neighbors.data(), count, expected);
+
+				for (auto instructionSet = SF::SFSimulator::SSE2; instructionSet <= supported; instructionSet = static_cast<SF::SFSimulator::InstructionSet>(instructionSet + 1))
+				{
+					SF::RepulsiveAgentOutput actual;
+					SF::getRepulsiveAgentKernel(instructionSet, SF::SFSimulator::PRECISE)(input, neighbors.data(), count, actual);
+
+					SF_CHECK(isWithinTolerance(actual, expected));
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,136 @@
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#if HAVE_OPENMP || _OPENMP
+#include <omp.h>
+#endif
+
+#include "../include/Tests.h"
+#include "AgentPropertyConfig.h"
+
+namespace SFTests
+{
+	/// <summary> Defines a test that can be run by name </summary>
+	struct Test
+	{
+		const char* name;		// The name given on the command line
+		void (*run)();			// The function running the test
+	};
+
+	static const Test TESTS[] =
+	{
+		{ "removed-agent-attractive-lists", testRemovedAgentLeavesAttractiveLists },
+		{ "agent-group-numbers", testAgentGroupNumbersAreBounded },
+		{ "single-member-group", testSingleMemberGroupStaysFinite },
+		{ "neighbor-index-stale-neighbors", testNeighborIndexBuildDropsStaleNeighbors },
+		{ "distance-field-max-distance", testDistanceFieldRejectsNonPositiveMaxDistance },
+		{ "dynamic-obstacle-neighbors", testDynamicObstacleNeighborsHaveNoVertex },
+		{ "obstacle-neighbors-brute-force", testObstacleNeighborsMatchBruteForce },
+		{ "batched-visibility", testBatchedVisibilityMatchesSingle },
+		{ "visibility-radius", testVisibilityRadiusWidensSegment },
+		{ "sweep-crossing-walls", testSweepStopsAtCrossingWalls },
+		{ "repulsive-agent-kernels", testRepulsiveAgentKernelsMatchScalar },
+		{ "steady-steps-do-not-allocate", testSteadyStepsDoNotAllocate },
+		{ "fast-math-trajectories", testFastMathTrajectoriesMatchPrecise }
+	};
+
+	static size_t failureCount = 0;		// count of the failed checks of the running test
+
+	/// <summary> Records the result of a check, printing the failed ones </summary>
+	/// <param name="condition"> The result of the check </param>
+	/// <param name="expression"> The checked expression </param>
+	/// <param name="file"> The source file of the check </param>
+	/// <param name="line"> The source line of the check </param>
+	void check(bool condition, const char* expression, const char* file, int line)
+	{
+		if (condition)
+			return;
+
+		std::printf("  %s(%d): check failed: %s\n", file, line, expression);
+		++failureCount;
+	}
+
+	/// <summary> Sets the agent defaults shared by the tests: a neighbor distance of 3 m, 10 neighbors and a radius of 0.3 m </summary>
+	/// <param name="sim"> The simulator </param>
+	void setAgentDefaults(SF::SFSimulator& sim)
+	{
+		SF::AgentPropertyConfig apc(3.0f, 10, 1.0f, 0.3f, 1.4f, 1.0f, 0.5f, 0.3f, 1.0f, 0.2f, 1.0f, 0.1f, 1.0f, 0.5f, 0.1f, SF::Vector2());
+
+		sim.setTimeStep(0.1f);
+		sim.setAgentDefaults(apc);
+	}
+
+	/// <summary> Adds the obstacles of the reference corridor: walls 20 m apart along the x-axis with a row of pillars in the middle </summary>
+	/// <param name="sim"> The simulator </param>
+	void addReferenceCorridor(SF::SFSimulator& sim)
+	{
+		sim.addObstacle({ SF::Vector2(-50.0f, -10.0f), SF::Vector2(50.0f, -10.0f), SF::Vector2(50.0f, -11.0f), SF::Vector2(-50.0f, -11.0f) });
+		sim.addObstacle({ SF::Vector2(-50.0f, 11.0f), SF::Vector2(50.0f, 11.0f), SF::Vector2(50.0f, 10.0f), SF::Vector2(-50.0f, 10.0f) });
+
+		for (auto i = -4; i <= 4; ++i)
+		{
+			const auto x = 8.0f * i;
+			sim.addObstacle({ SF::Vector2(x, -1.0f), SF::Vector2(x + 1.0f, -1.0f), SF::Vector2(x + 1.0f, 1.0f), SF::Vector2(x, 1.0f) });
+		}
+
+		sim.processObstacles();
+	}
+
+	/// <summary> Fills a simulator with the reference scene: the reference corridor crossed by two opposing flows of agents </summary>
+	/// <param name="sim"> The simulator, with its agent defaults set </param>
+	/// <param name="agentCount"> The count of agents </param>
+	void addReferenceScene(SF::SFSimulator& sim, size_t agentCount)
+	{
+		addReferenceCorridor(sim);
+
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> x(-40.0f, 40.0f);
+		std::uniform_real_distribution<float> y(-9.0f, 9.0f);
+
+		for (size_t i = 0; i < agentCount; ++i)
+		{
+			const auto agentNo = sim.addAgent(SF::Vector2(x(random), y(random)));
+			sim.setAgentPrefVelocity(agentNo, SF::Vector2(i % 2 == 0 ? 1.2f : -1.2f, 0.0f));
+		}
+	}
+
+	/// <summary> Sets the count of threads running the next simulation steps </summary>
+	/// <param name="threadCount"> The count of threads, ignored without OpenMP </param>
+	void setThreadCount(int threadCount)
+	{
+#if HAVE_OPENMP || _OPENMP
+		omp_set_num_threads(threadCount);
+#else
+		(void)threadCount;
+#endif
+	}
+}
+
+/// <summary> Runs the tests named on the command line, or all of them </summary>
+/// <returns> The count of failed tests </returns>
+int main(int argc, char** argv)
+{
+	auto failedTestCount = 0;
+
+	for (const auto& test : SFTests::TESTS)
+	{
+		auto isSelected = argc <= 1;
+
+		for (auto i = 1; i < argc; ++i)
+			isSelected = isSelected || std::strcmp(argv[i], test.name) == 0;
+
+		if (!isSelected)
+			continue;
+
+		SFTests::failureCount = 0;
+		test.run();
+
+		std::printf("%s %s\n", SFTests::failureCount == 0 ? "PASS" : "FAIL", test.name);
+
+		if (SFTests::failureCount != 0)
+			++failedTestCount;
+	}
+
+	return failedTestCount;
+}
@@ -0,0 +1,75 @@
+#include <vector>
+
+#include "../include/Tests.h"
+#include "ForceKernels.h"
+
+namespace SFTests
+{
+	static const double TRAJECTORY_TOLERANCE = 1e-5;	// deviation allowed between the fast and the precise trajectories, relative to the distance walked
+	static const size_t TRAJECTORY_STEP_COUNT = 200;	// count of steps compared, 20 s of walking
+	static const float MIN_DISTANCE = 1.0f;				// distance walked from which the trajectories are compared
+	static const size_t PLATOON_ROW_COUNT = 6;			// count of rows of the platoon
+	static const size_t PLATOON_COLUMN_COUNT = 8;		// count of agents in each row of the platoon
+
+	/// <summary> Fills a simulator with the reference platoon, rows of agents walking together down the reference corridor, those of the middle columns between the walls and the pillars </summary>
+	/// <param name="sim"> The simulator </param>
+	/// <param name="mathMode"> The math mode of the simulator </param>
+	/// <param name="instructionSet"> The instruction set of the simulator </param>
+	static void addPlatoon(SF::SFSimulator& sim, SF::SFSimulator::MathMode mathMode, SF::SFSimulator::InstructionSet instructionSet)
+	{
+		setAgentDefaults(sim);
+		sim.setMathMode(mathMode);
+		sim.setInstructionSet(instructionSet);
+		addReferenceCorridor(sim);
+
+		for (size_t row = 0; row < PLATOON_ROW_COUNT; ++row)
+		{
+			for (size_t column = 0; column < PLATOON_COLUMN_COUNT; ++column)
+			{
+				const auto y = -8.0f + 2.0f * column + (column >= PLATOON_COLUMN_COUNT / 2 ? 2.0f : 0.0f);
+				const auto agentNo = sim.addAgent(SF::Vector2(-30.0f + row, y));
+				sim.setAgentPrefVelocity(agentNo, SF::Vector2(1.2f, 0.0f));
+			}
+		}
+	}
+
+	/// <summary> Checks that the trajectories of a platoon walking down the reference corridor in the fast math mode stay within 1e-5 of the precise ones, relative to the distance walked. A dense counterflow would amplify any difference until the trajectories part, so the platoon keeps the comparison on the accuracy of the kernels </summary>
+	void testFastMathTrajectoriesMatchPrecise()
+	{
+		const auto supported = SF::getSupportedInstructionSet();
+
+		for (auto instructionSet = SF::SFSimulator::SCALAR; instructionSet <= supported; instructionSet = static_cast<SF::SFSimulator::InstructionSet>(instructionSet + 1))
+		{
+			SF::SFSimulator precise;
+			SF::SFSimulator fast;
+			addPlatoon(precise, SF::SFSimulator::PRECISE, instructionSet);
+			addPlatoon(fast, SF::SFSimulator::FAST, instructionSet);
+
+			const auto agentCount = precise.getNumAgents();
+			std::vector<SF::Vector2> starts;
+
+			for (size_t i = 0; i < agentCount; ++i)
+				starts.push_back(precise.getAgentPosition(i));
+
+			auto maxDeviation = 0.0;
+
+			for (size_t step = 0; step < TRAJECTORY_STEP_COUNT; ++step)
+			{
+				precise.doStep();
+				fast.doStep();
+
+				for (size_t i = 0; i < agentCount; ++i)
+				{
+					const auto& position = precise.getAgentPosition(i);
+					const auto distance = SF::abs(position - starts[i]);
+
+					// Over shorter distances a single rounding of the positions exceeds the tolerance
+					if (distance >= MIN_DISTANCE)
+						maxDeviation = std::max(maxDeviation, static_cast<double>(SF::abs(fast.getAgentPosition(i) - position) / distance));
+				}
+			}
+
+			SF_CHECK(maxDeviation <= TRAJECTORY_TOLERANCE);
+		}
+	}
+}
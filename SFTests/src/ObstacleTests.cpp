@@ -0,0 +1,291 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../include/Tests.h"
+#include "Definitions.h"
+
+namespace SFTests
+{
+	/// <summary> Checks that the obstacle distance field is disabled by a max distance that is not positive, including along an axis-aligned wall that would give a grid one node wide </summary>
+	void testDistanceFieldRejectsNonPositiveMaxDistance()
+	{
+		const float maxDistances[] = { -2.0f, 0.0f };
+
+		for (auto maxDistance : maxDistances)
+		{
+			SF::SFSimulator sim;
+			sim.addObstacle({ SF::Vector2(0.0f, 0.0f), SF::Vector2(10.0f, 0.0f) });
+			sim.setObstacleDistanceField(0.5f, maxDistance);
+			sim.processObstacles();
+
+			SF_CHECK(sim.getObstacleDistance(SF::Vector2(5.0f, 0.0f)) == maxDistance);
+			SF_CHECK(sim.getObstacleDistanceGradient(SF::Vector2(5.0f, 0.0f)) == SF::Vector2());
+		}
+
+		SF::SFSimulator sim;
+		sim.addObstacle({ SF::Vector2(0.0f, 0.0f), SF::Vector2(10.0f, 0.0f) });
+		sim.setObstacleDistanceField(0.5f, 2.0f);
+		sim.processObstacles();
+
+		SF_CHECK(std::abs(sim.getObstacleDistance(SF::Vector2(5.0f, 1.0f)) - 1.0f) < 1e-4f);
+	}
+
+	/// <summary> Checks that the obstacle neighbors of an agent name the first vertices of static edges, and SF::SF_ERROR for the edges of dynamic obstacles </summary>
+	void testDynamicObstacleNeighborsHaveNoVertex()
+	{
+		SF::SFSimulator sim;
+		setAgentDefaults(sim);
+
+		const auto wallNo = sim.addObstacle({ SF::Vector2(-5.0f, -1.0f), SF::Vector2(5.0f, -1.0f) });
+		sim.processObstacles();
+		sim.addDynamicObstacle({ SF::Vector2(0.8f, -0.2f), SF::Vector2(1.2f, -0.2f), SF::Vector2(1.2f, 0.2f), SF::Vector2(0.8f, 0.2f) });
+
+		const auto agentNo = sim.addAgent(SF::Vector2(0.0f, 0.0f));
+		sim.doStep();
+
+		size_t staticCount = 0;
+		size_t dynamicCount = 0;
+
+		for (size_t i = 0; i < sim.getAgentNumObstacleNeighbors(agentNo); ++i)
+		{
+			const auto vertexNo = sim.getAgentObstacleNeighbor(agentNo, i);
+
+			if (vertexNo == SF::SF_ERROR)
+				++dynamicCount;
+			else if (vertexNo < sim.getNumObstacleVertices())
+				++staticCount;
+		}
+
+		SF_CHECK(wallNo == 0);
+		SF_CHECK(staticCount > 0);
+		SF_CHECK(dynamicCount > 0);
+		SF_CHECK(staticCount + dynamicCount == sim.getAgentNumObstacleNeighbors(agentNo));
+	}
+
+	/// <summary> Checks that the obstacle neighbors found through the obstacle tree are the segments within range of each agent, each once, with the splitters tried exhaustively and sampled, on segments crossing each other and so the splitting lines </summary>
+	void testObstacleNeighborsMatchBruteForce()
+	{
+		const size_t exhaustiveSizes[] = { SF::SF_ERROR, 16 };
+		const size_t segmentCount = 150;
+		const size_t agentCount = 400;
+
+		// The obstacle range of the agent defaults: the time horizon times the max speed, plus the radius
+		const auto range = 1.0f * 1.4f + 0.3f;
+
+		for (auto exhaustiveSize : exhaustiveSizes)
+		{
+			SF::SFSimulator sim;
+			setAgentDefaults(sim);
+			sim.setObstacleTreeExhaustiveSize(exhaustiveSize);
+
+			std::mt19937 random(7);
+			std::uniform_real_distribution<float> coordinate(-15.0f, 15.0f);
+			std::uniform_real_distribution<float> offset(-4.0f, 4.0f);
+
+			for (size_t i = 0; i < segmentCount; ++i)
+			{
+				const SF::Vector2 center(coordinate(random), coordinate(random));
+				const SF::Vector2 half(offset(random), offset(random));
+
+				sim.addObstacle({ center - half, center + half });
+			}
+
+			sim.processObstacles();
+
+			std::vector<SF::Vector2> positions(agentCount);
+
+			for (size_t i = 0; i < agentCount; ++i)
+			{
+				positions[i] = SF::Vector2(coordinate(random), coordinate(random));
+
+				const auto agentNo = sim.addAgent(positions[i]);
+				sim.setAgentMaxObstacleNeighbors(agentNo, SF::SF_ERROR);
+			}
+
+			sim.doStep();
+
+			size_t neighborCount = 0;
+
+			for (size_t i = 0; i < agentCount; ++i)
+			{
+				std::vector<bool> isNeighbor(sim.getNumObstacleVertices(), false);
+
+				// Each segment is stored once in the tree, so it is a neighbor at most once
+				for (size_t j = 0; j < sim.getAgentNumObstacleNeighbors(i); ++j)
+				{
+					SF_CHECK(!isNeighbor[sim.getAgentObstacleNeighbor(i, j)]);
+					isNeighbor[sim.getAgentObstacleNeighbor(i, j)] = true;
+				}
+
+				neighborCount += sim.getAgentNumObstacleNeighbors(i);
+
+				// Segments within a small band around the range may fall either way through rounding
+				for (size_t vertexNo = 0; vertexNo < sim.getNumObstacleVertices(); ++vertexNo)
+				{
+					const auto& point1 = sim.getObstacleVertex(vertexNo);
+					const auto& point2 = sim.getObstacleVertex(sim.getNextObstacleVertexNo(vertexNo));
+					const auto dist = std::sqrt(SF::distSqPointLineSegment(point1, point2, positions[i]));
+
+					if (dist < range - 1e-3f)
+						SF_CHECK(isNeighbor[vertexNo]);
+					else if (dist > range + 1e-3f)
+						SF_CHECK(!isNeighbor[vertexNo]);
+				}
+			}
+
+			SF_CHECK(neighborCount > agentCount);
+		}
+	}
+
+	/// <summary> Checks that the batched visibility queries match the single queries, and that pair lists of different sizes are rejected </summary>
+	void testBatchedVisibilityMatchesSingle()
+	{
+		SF::SFSimulator sim;
+		setAgentDefaults(sim);
+		addReferenceCorridor(sim);
+		sim.processObstacles();
+		sim.addDynamicObstacle({ SF::Vector2(20.0f, -1.0f), SF::Vector2(22.0f, -1.0f), SF::Vector2(22.0f, 1.0f), SF::Vector2(20.0f, 1.0f) });
+
+		// Pairs across the corridor, its walls and the pillars, more than one packet of 64
+		const size_t pairCount = 1000;
+		std::mt19937 random(5);
+		std::uniform_real_distribution<float> x(-55.0f, 55.0f);
+		std::uniform_real_distribution<float> y(-12.0f, 12.0f);
+		std::uniform_real_distribution<float> radius(0.0f, 0.5f);
+		std::vector<SF::Vector2> points1(pairCount);
+		std::vector<SF::Vector2> points2(pairCount);
+		std::vector<float> radii(pairCount);
+
+		for (size_t i = 0; i < pairCount; ++i)
+		{
+			points1[i] = SF::Vector2(x(random), y(random));
+			points2[i] = SF::Vector2(x(random), y(random));
+			radii[i] = radius(random);
+		}
+
+		const auto visible = sim.queryVisibilities(points1, points2, radii);
+		const auto visibleNoRadii = sim.queryVisibilities(points1, points2);
+		const auto wordCount = (pairCount + 63) / 64;
+
+		SF_CHECK(visible.size() == wordCount);
+		SF_CHECK(visibleNoRadii.size() == wordCount);
+
+		if (visible.size() != wordCount || visibleNoRadii.size() != wordCount)
+			return;
+
+		size_t visibleCount = 0;
+
+		for (size_t i = 0; i < pairCount; ++i)
+		{
+			const auto isVisible = (visible[i / 64] >> (i % 64) & 1) != 0;
+
+			SF_CHECK(isVisible == sim.queryVisibility(points1[i], points2[i], radii[i]));
+			SF_CHECK(((visibleNoRadii[i / 64] >> (i % 64) & 1) != 0) == sim.queryVisibility(points1[i], points2[i]));
+
+			if (isVisible)
+				++visibleCount;
+		}
+
+		SF_CHECK(visibleCount > 0 && visibleCount < pairCount);
+
+		points2.pop_back();
+		SF_CHECK(sim.queryVisibilities(points1, points2, radii).empty());
+
+		points2.push_back(SF::Vector2());
+		radii.pop_back();
+		SF_CHECK(sim.queryVisibilities(points1, points2, radii).empty());
+	}
+
+	/// <summary> Checks that the radius of a visibility query widens the line segment between the points rather than its whole line, so that a wall nearly along the line but far past the points does not block them </summary>
+	void testVisibilityRadiusWidensSegment()
+	{
+		SF::SFSimulator sim;
+
+		// A wall whose line crosses the segment between the points, while the wall itself starts 9 m past them. The wall is added
+		// first so that it splits the root node, whose bounding box also covers a post 3 m beside the points and so reaches them
+		sim.addObstacle({ SF::Vector2(0.1f, 10.0f), SF::Vector2(0.2f, 20.0f) });
+		sim.addObstacle({ SF::Vector2(3.0f, 0.0f), SF::Vector2(3.0f, 0.5f) });
+		sim.processObstacles();
+
+		const std::vector<SF::Vector2> points1 = { SF::Vector2(0.0f, -1.0f), SF::Vector2(0.0f, 1.0f), SF::Vector2(0.0f, -1.0f), SF::Vector2(0.0f, -1.0f) };
+		const std::vector<SF::Vector2> points2 = { SF::Vector2(0.0f, 1.0f), SF::Vector2(0.0f, -1.0f), SF::Vector2(0.0f, 1.0f), SF::Vector2(0.0f, 1.0f) };
+		const std::vector<float> radii = { 0.0f, 0.5f, 0.5f, 9.5f };
+		const bool isVisible[] = { true, true, true, false };
+
+		const auto visible = sim.queryVisibilities(points1, points2, radii);
+
+		SF_CHECK(visible.size() == 1);
+
+		for (size_t i = 0; i < points1.size(); ++i)
+		{
+			SF_CHECK(sim.queryVisibility(points1[i], points2[i], radii[i]) == isVisible[i]);
+			SF_CHECK(visible.empty() || ((visible[0] >> i & 1) != 0) == isVisible[i]);
+		}
+	}
+
+	/// <summary> Checks that swept agents stop at walls crossing each other, which cross the splitting lines of the obstacle tree whatever splitters it takes </summary>
+	void testSweepStopsAtCrossingWalls()
+	{
+		// Walls 0.2 m thick in a hash pattern, so that the splitter taken at the root cuts two other walls
+		const float wallOffsets[] = { -3.0f, 3.0f };
+		const float sides[] = { -1.0f, 1.0f };
+		size_t reachedCount = 0;
+		size_t sweepCount = 0;
+
+		for (auto isVertical = 0; isVertical < 2; ++isVertical)
+		{
+			for (auto wallOffset : wallOffsets)
+			{
+				for (auto side : sides)
+				{
+					for (auto along = -9.0f; along <= 9.0f; along += 0.75f)
+					{
+						SF::SFSimulator sim;
+						setAgentDefaults(sim);
+						sim.setTimeStep(0.5f);
+						sim.setObstacleSweep(true);
+
+						for (auto offset : wallOffsets)
+						{
+							sim.addObstacle({ SF::Vector2(-10.0f, offset - 0.1f), SF::Vector2(10.0f, offset - 0.1f), SF::Vector2(10.0f, offset + 0.1f), SF::Vector2(-10.0f, offset + 0.1f) });
+							sim.addObstacle({ SF::Vector2(offset - 0.1f, -10.0f), SF::Vector2(offset + 0.1f, -10.0f), SF::Vector2(offset + 0.1f, 10.0f), SF::Vector2(offset - 0.1f, 10.0f) });
+						}
+
+						sim.processObstacles();
+
+						// The agent walks at the wall from 1.5 m away on one side, fast enough to cross it within a step
+						const auto start = wallOffset + 1.5f * side;
+						const auto agentNo = sim.addAgent(isVertical != 0 ? SF::Vector2(start, along) : SF::Vector2(along, start));
+						const auto velocity = -4.0f * side;
+
+						sim.setAgentMaxSpeed(agentNo, 5.0f);
+						sim.setAgentPrefVelocity(agentNo, isVertical != 0 ? SF::Vector2(velocity, 0.0f) : SF::Vector2(0.0f, velocity));
+						sim.setAgentVelocity(agentNo, isVertical != 0 ? SF::Vector2(velocity, 0.0f) : SF::Vector2(0.0f, velocity));
+
+						auto minGap = 1.5f;
+
+						for (auto step = 0; step < 4; ++step)
+						{
+							sim.doStep();
+
+							const auto& position = sim.getAgentPosition(agentNo);
+							const auto gap = side * ((isVertical != 0 ? position.x() : position.y()) - wallOffset);
+
+							SF_CHECK(gap > 0.1f);
+							minGap = std::min(minGap, gap);
+						}
+
+						++sweepCount;
+
+						if (minGap < 0.6f)
+							++reachedCount;
+					}
+				}
+			}
+		}
+
+		// Most agents reach the wall, but not those next to the other walls
+		SF_CHECK(reachedCount > sweepCount / 2);
+	}
+}
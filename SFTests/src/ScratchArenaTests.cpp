@@ -0,0 +1,66 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "../include/Tests.h"
+
+static std::atomic<size_t> heapAllocationCount(0);	// count of the calls to the global operator new of the test program
+
+/// <summary> Allocates memory as the default operator new does, counting the call </summary>
+/// <param name="size"> The size of the memory </param>
+/// <returns> A pointer to the memory </returns>
+void* operator new(size_t size)
+{
+	++heapAllocationCount;
+
+	if (auto memory = std::malloc(size == 0 ? 1 : size))
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+/// <summary> Frees memory allocated by the counting operator new </summary>
+/// <param name="memory"> A pointer to the memory </param>
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+namespace SFTests
+{
+	static const size_t WARM_UP_STEP_COUNT = 20;	// count of steps letting the scratch arenas and the buffers grow to fit the scene
+	static const size_t STEADY_STEP_COUNT = 100;	// count of steps that must not allocate
+
+	/// <summary> Checks that the steady-state steps of the reference scene make no heap allocations, with both neighbor searches, on one thread and on several </summary>
+	void testSteadyStepsDoNotAllocate()
+	{
+		const int threadCounts[] = { 1, 4 };
+		const SF::SFSimulator::NeighborSearchType searchTypes[] = { SF::SFSimulator::KD_TREE, SF::SFSimulator::UNIFORM_GRID };
+
+		for (auto searchType : searchTypes)
+		{
+			for (auto threadCount : threadCounts)
+			{
+				setThreadCount(threadCount);
+
+				SF::SFSimulator sim;
+				setAgentDefaults(sim);
+				sim.setNeighborSearchType(searchType);
+				addReferenceScene(sim, 1000);
+
+				for (size_t i = 0; i < WARM_UP_STEP_COUNT; ++i)
+					sim.doStep();
+
+				const auto scratchAllocationCount = sim.getScratchAllocationCount();
+				const size_t allocationCount = heapAllocationCount;
+
+				for (size_t i = 0; i < STEADY_STEP_COUNT; ++i)
+					sim.doStep();
+
+				SF_CHECK(scratchAllocationCount > 0);
+				SF_CHECK(sim.getScratchAllocationCount() == scratchAllocationCount);
+				SF_CHECK(heapAllocationCount == allocationCount);
+			}
+		}
+	}
+}